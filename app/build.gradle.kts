@@ -107,6 +107,10 @@ android {
         resources {
             excludes += "/META-INF/{AL2.0,LGPL2.1}"
         }
+        // Extract native libs so ggml can scan nativeLibraryDir for its CPU variants
+        jniLibs {
+            useLegacyPackaging = true
+        }
     }
 
     // Signing configuration for consistent signatures across local and CI builds
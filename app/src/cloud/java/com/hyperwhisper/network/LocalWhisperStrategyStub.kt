@@ -14,7 +14,8 @@ class LocalWhisperStrategyStub : AudioProcessingStrategy {
         audioFile: File,
         audioBase64: String,
         voiceMode: VoiceMode,
-        modelId: String
+        modelId: String,
+        reprocessing: Boolean
     ): ApiResult<String> {
         return ApiResult.Error(
             "Local processing is not available in this build variant. " +
@@ -26,8 +26,10 @@ object FlavorModule {
 
     @Provides
     @Singleton
-    fun provideWhisperContext(): WhisperContext {
-        return WhisperContext()
+    fun provideWhisperContext(
+        @ApplicationContext context: Context
+    ): WhisperContext {
+        return WhisperContext(context)
     }
 
     @Provides
@@ -40,9 +42,10 @@ object FlavorModule {
     @Singleton
     fun provideModelRepository(
         @ApplicationContext context: Context,
-        okHttpClient: OkHttpClient
+        okHttpClient: OkHttpClient,
+        whisperContext: WhisperContext
     ): ModelRepository {
-        return ModelRepository(context, okHttpClient)
+        return ModelRepository(context, okHttpClient, whisperContext)
     }
 
     @Provides
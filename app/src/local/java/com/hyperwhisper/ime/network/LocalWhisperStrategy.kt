@@ -1,11 +1,19 @@
 package com.hyperwhisper.network
 
 import android.util.Log
+import com.hyperwhisper.audio.AudioRecorderManager
 import com.hyperwhisper.data.*
 import com.hyperwhisper.native_whisper.AudioConverter
 import com.hyperwhisper.native_whisper.WhisperContext
+import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.asSharedFlow
 import kotlinx.coroutines.flow.first
 import java.io.File
 import javax.inject.Inject
@@ -25,15 +33,57 @@ class LocalWhisperStrategy @Inject constructor(
 
     companion object {
         private const val TAG = "LocalWhisperStrategy"
+
+        // Native VAD: context kept around speech, and the pause length that splits intervals
+        private const val VAD_PADDING_MS = 200
+        private const val VAD_MIN_SILENCE_MS = 400
+
+        // Detected language probability needed before it is reused for the rest of the session
+        private const val LANGUAGE_CONFIDENCE = 0.8f
+
+        private const val CONFIGURATION_MODE_ID = "configuration"
+
+        // Shorter recordings come back from the selected model quickly enough on their own
+        private const val CASCADE_MIN_SECONDS = 5.0
+        private const val REFINEMENT_TIMEOUT_MS = 120_000L
+    }
+
+    // Selected model's transcripts of drafts already returned, collected in the background
+    private val refinementScope = CoroutineScope(SupervisorJob() + Dispatchers.IO)
+    private val _refinements = MutableSharedFlow<TextRefinement>(extraBufferCapacity = 1)
+    override val refinements: Flow<TextRefinement> = _refinements.asSharedFlow()
+    private var refinementJob: Job? = null
+
+    @Volatile
+    private var fieldType = InputFieldType.TEXT
+
+    override fun setInputContext(textBeforeCursor: String, fieldType: InputFieldType) {
+        this.fieldType = fieldType
+        whisperContext.setFieldContext(textBeforeCursor)
+        whisperContext.setInputFieldType(fieldType)
+    }
+
+    override fun resetInputContext() {
+        whisperContext.resetPromptContext()
+    }
+
+    override fun cancelRefinement() {
+        refinementJob?.cancel()
+        refinementJob = null
+        whisperContext.cancelRefinement()
     }
 
     override suspend fun processAudio(
         audioFile: File,
         audioBase64: String, // Not used for local processing
         voiceMode: VoiceMode,
-        modelId: String
+        modelId: String,
+        reprocessing: Boolean
     ): ApiResult<String> = withContext(Dispatchers.IO) {
         return@withContext try {
+            // A refinement of the previous utterance would hold the model
+            cancelRefinement()
+
             Log.d(TAG, "========== LOCAL WHISPER PROCESSING ==========")
             Log.d(TAG, "Processing audio with local whisper.cpp")
             Log.d(TAG, "Model: $modelId")
@@ -41,9 +91,21 @@ class LocalWhisperStrategy @Inject constructor(
             Log.d(TAG, "Audio file: ${audioFile.name} (${audioFile.length()} bytes)")
 
             // 1. Get selected model from modelId
-            val model = WhisperModel.values().find { it.modelName == modelId }
+            val selectedModel = WhisperModel.values().find { it.modelName == modelId }
                 ?: WhisperModel.TINY // Default to TINY if not found
 
+            val apiSettings = settingsRepository.apiSettings.first()
+            val language = if (apiSettings.inputLanguage.isEmpty()) {
+                "auto"
+            } else {
+                apiSettings.inputLanguage
+            }
+
+            // English dictation runs on the English-only checkpoint of the same size when present
+            val model = routeModel(selectedModel, language)
+            if (model != selectedModel) {
+                Log.d(TAG, "Routing ${selectedModel.displayName} to ${model.displayName} for language $language")
+            }
             Log.d(TAG, "Using model: ${model.displayName}")
 
             // 2. Check if model is downloaded
@@ -53,11 +115,11 @@ class LocalWhisperStrategy @Inject constructor(
                 return@withContext ApiResult.Error(error)
             }
 
-            // 3. Load model if not already loaded
+            // 3. Load model if it isn't the one already loaded
             val modelFile = modelRepository.getModelFile(model)
-            if (!whisperContext.isModelLoaded()) {
+            if (!whisperContext.isModelLoaded(modelFile)) {
                 Log.d(TAG, "Loading model: ${modelFile.absolutePath}")
-                val loadResult = whisperContext.loadModel(modelFile)
+                val loadResult = whisperContext.loadModel(modelFile, modelRepository.getNativeCacheDir())
                 if (loadResult.isFailure) {
                     val error = loadResult.exceptionOrNull()?.message ?: "Failed to load model"
                     Log.e(TAG, "Model loading failed: $error")
@@ -85,25 +147,68 @@ class LocalWhisperStrategy @Inject constructor(
                 audioFile
             }
 
-            // 5. Get language settings
-            val apiSettings = settingsRepository.apiSettings.first()
-            val language = if (apiSettings.inputLanguage.isEmpty()) {
-                "auto"
-            } else {
-                apiSettings.inputLanguage
-            }
-
+            // 5. Language from the settings read above
             Log.d(TAG, "Language: $language")
 
             // 6. Transcribe with whisper.cpp
             Log.d(TAG, "Starting transcription...")
             val startTime = System.currentTimeMillis()
 
-            val transcribeResult = whisperContext.transcribe(
-                audioFile = wavFile,
-                language = language,
-                translate = false
+            whisperContext.setVadOptions(
+                enabled = true,
+                paddingMs = VAD_PADDING_MS,
+                minSilenceMs = VAD_MIN_SILENCE_MS
             )
+            whisperContext.setTimeCompression(apiSettings.localSettings.speechSpeedup)
+            // Configuration mode decodes straight into the command grammar instead of free text
+            val commandMode = voiceMode.id == CONFIGURATION_MODE_ID
+            val grammar = if (commandMode) {
+                VoiceCommandGrammar.build(settingsRepository.voiceModes.first())
+            } else {
+                ""
+            }
+            if (!whisperContext.setGrammar(grammar)) {
+                Log.w(TAG, "Command grammar rejected, decoding free text")
+            }
+            // Auto-detect once per session among the user's languages instead of on every utterance
+            whisperContext.setLanguageDetection(
+                enabled = language == "auto",
+                candidates = apiSettings.localSettings.languageCandidates,
+                threshold = LANGUAGE_CONFIDENCE
+            )
+            // Long free-text dictations answer with the Tiny draft right away; the selected model
+            // refines the same audio in the background and the draft is replaced if still untouched.
+            // Reprocessed audio has no committed draft to replace
+            val draftModel = if (reprocessing) {
+                null
+            } else {
+                draftModel(model, commandMode, apiSettings.localSettings, language, calculateAudioDuration(audioFile))
+            }
+            val draft = if (draftModel != null) {
+                whisperContext.transcribeDraft(
+                    wavFile,
+                    language,
+                    translate = false,
+                    profile = apiSettings.localSettings.decodingProfile
+                )
+                    .onFailure { Log.w(TAG, "Draft failed, transcribing with ${model.displayName}: ${it.message}") }
+                    .getOrNull()
+            } else {
+                null
+            }
+            val transcribeResult = if (draft != null) {
+                launchRefinement(draft)
+                Result.success(draft)
+            } else {
+                whisperContext.transcribe(
+                    audioFile = wavFile,
+                    language = language,
+                    translate = false,
+                    profile = apiSettings.localSettings.decodingProfile,
+                    budgetMs = apiSettings.localSettings.latencyBudgetMs,
+                    sessionContext = !reprocessing
+                )
+            }
 
             val elapsedTime = System.currentTimeMillis() - startTime
             Log.d(TAG, "Transcription completed in ${elapsedTime}ms")
@@ -120,27 +225,47 @@ class LocalWhisperStrategy @Inject constructor(
                 return@withContext ApiResult.Error("Transcription failed: $error")
             }
 
-            val transcription = transcribeResult.getOrNull() ?: ""
+            val rawTranscription = transcribeResult.getOrNull() ?: ""
+            val transcription = if (commandMode) {
+                VoiceCommandGrammar.parse(rawTranscription) ?: rawTranscription
+            } else {
+                rawTranscription
+            }
+            val segments = whisperContext.getLastSegments()
+            val confidence = whisperContext.getLastConfidence()
             Log.d(TAG, "✓ Transcription successful")
+            Log.d(TAG, "  Segments: ${segments.size}" +
+                (segments.firstOrNull()?.let { " (speech ${it.startMs}-${segments.last().endMs} ms)" } ?: ""))
             Log.d(TAG, "  Result length: ${transcription.length} chars")
             Log.d(TAG, "  Result preview: ${transcription.take(100)}...")
             Log.d(TAG, "  Processing time: ${elapsedTime}ms (${String.format("%.2f", elapsedTime / 1000.0)}s)")
+            Log.d(TAG, "  Caches: ${whisperContext.getCacheStats()}")
+            confidence?.let {
+                Log.d(TAG, "  Confidence: avg logprob ${"%.2f".format(it.avgLogprob)}, " +
+                    "no-speech ${"%.2f".format(it.noSpeechProb)}, compression ${"%.2f".format(it.compressionRatio)}")
+            }
             Log.d(TAG, "========== END LOCAL PROCESSING ==========")
 
             // 8. Create processing info for transparency
             val processingInfo = ProcessingInfo(
                 processingMode = "local",
-                strategy = "whisper.cpp",
-                transcriptionModel = model.displayName,
+                strategy = "whisper.cpp ${whisperContext.getCpuVariant().substringBefore(" (")}".trim(),
+                transcriptionModel = if (draft != null) {
+                    "${draftModel?.displayName} → ${model.displayName}"
+                } else {
+                    model.displayName
+                },
                 postProcessingModel = null,
                 translationEnabled = false,
                 translationTarget = null,
-                originalTranscription = null,
+                originalTranscription = if (commandMode) rawTranscription else null,
                 voiceModeName = voiceMode.name,
                 systemPrompt = voiceMode.systemPrompt,
                 audioDurationSeconds = calculateAudioDuration(audioFile),
                 transcriptionTokens = null, // Local processing doesn't use tokens
-                postProcessingTokens = null
+                postProcessingTokens = null,
+                confidence = confidence,
+                refinementPending = draft != null
             )
 
             ApiResult.Success(transcription, processingInfo)
@@ -154,15 +279,67 @@ class LocalWhisperStrategy @Inject constructor(
         }
     }
 
+    /**
+     * The English-only variant of model when the input language is English and it is downloaded
+     */
+    private fun routeModel(model: WhisperModel, language: String): WhisperModel {
+        if (language != "en") return model
+        val english = model.englishOnlyVariant() ?: return model
+        return if (modelRepository.isModelDownloaded(english)) english else model
+    }
+
+    /**
+     * Tiny model to answer with as a draft before model refines, or null to transcribe with
+     * model alone; loads the draft model on first use
+     */
+    private fun draftModel(
+        model: WhisperModel,
+        commandMode: Boolean,
+        localSettings: LocalSettings,
+        language: String,
+        audioSeconds: Double
+    ): WhisperModel? {
+        if (!localSettings.draftCascade || model == WhisperModel.TINY || model == WhisperModel.TINY_EN || commandMode) {
+            return null
+        }
+        // Typed fields decode under a grammar, which the draft path doesn't apply
+        if (fieldType != InputFieldType.TEXT || audioSeconds < CASCADE_MIN_SECONDS) return null
+        val draftModel = routeModel(WhisperModel.TINY, language).takeIf { modelRepository.isModelDownloaded(it) }
+            ?: return null
+        val draftFile = modelRepository.getModelFile(draftModel)
+        if (whisperContext.isDraftModelLoaded(draftFile)) return draftModel
+
+        val loadResult = whisperContext.loadDraftModel(draftFile)
+        loadResult.onFailure { Log.w(TAG, "Draft model unavailable: ${it.message}") }
+        return draftModel.takeIf { loadResult.isSuccess }
+    }
+
+    /**
+     * Wait for the selected model's transcript of draft and publish it with its confidence,
+     * even when it matches the draft (the caller may still escalate it)
+     */
+    private fun launchRefinement(draft: String) {
+        refinementJob = refinementScope.launch {
+            val startTime = System.currentTimeMillis()
+            val refined = whisperContext.awaitRefinement(REFINEMENT_TIMEOUT_MS)
+            when {
+                refined == null -> Log.d(TAG, "Refinement dropped")
+                refined.isBlank() -> Log.d(TAG, "Refinement is empty")
+                else -> {
+                    Log.d(TAG, "Refinement ready after ${System.currentTimeMillis() - startTime}ms: ${refined.take(100)}")
+                    _refinements.emit(TextRefinement(draft, refined, whisperContext.getLastConfidence()))
+                }
+            }
+        }
+    }
+
     /**
      * Calculate audio duration in seconds from file size
-     * Approximation based on file size and bitrate
+     * Exact for PCM WAV recordings, approximated from bitrate otherwise
      */
     private fun calculateAudioDuration(audioFile: File): Double {
         return try {
-            // For m4a at 128kbps: ~16KB per second
-            val fileSizeBytes = audioFile.length()
-            fileSizeBytes / 16000.0
+            AudioRecorderManager.audioDurationSeconds(audioFile)
         } catch (e: Exception) {
             Log.e(TAG, "Error calculating audio duration", e)
             0.0
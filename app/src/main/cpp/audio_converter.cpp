@@ -1,12 +1,14 @@
-#include <jni.h>
-#include <vector>
+#include "audio_converter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
-#include <android/log.h>
+#include "audio_kernels.h"
 
 #define LOG_TAG "AudioConverter"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "hw_log.h"
 
 // WAV header structure
 struct WavHeader {
@@ -72,9 +74,7 @@ bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_ra
         }
 
         // Convert int16 to float32 normalized to [-1, 1]
-        for (size_t i = 0; i < num_samples; i++) {
-            pcm_data[i] = static_cast<float>(samples[i]) / 32768.0f;
-        }
+        pcm16_to_float(samples.data(), pcm_data.data(), num_samples);
     } else if (header.bits_per_sample == 32) {
         std::vector<int32_t> samples(num_samples);
         if (fread(samples.data(), sizeof(int32_t), num_samples, file) != num_samples) {
@@ -84,9 +84,7 @@ bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_ra
         }
 
         // Convert int32 to float32 normalized to [-1, 1]
-        for (size_t i = 0; i < num_samples; i++) {
-            pcm_data[i] = static_cast<float>(samples[i]) / 2147483648.0f;
-        }
+        pcm32_to_float(samples.data(), pcm_data.data(), num_samples);
     } else {
         LOGE("Unsupported bit depth: %d", header.bits_per_sample);
         fclose(file);
@@ -97,9 +95,7 @@ bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_ra
     if (header.num_channels == 2) {
         LOGI("Converting stereo to mono");
         std::vector<float> mono_data(num_samples / 2);
-        for (size_t i = 0; i < mono_data.size(); i++) {
-            mono_data[i] = (pcm_data[i * 2] + pcm_data[i * 2 + 1]) / 2.0f;
-        }
+        stereo_to_mono(pcm_data.data(), mono_data.data(), mono_data.size());
         pcm_data = std::move(mono_data);
     }
 
@@ -107,3 +103,74 @@ bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_ra
     LOGI("Successfully loaded %zu samples from WAV file", pcm_data.size());
     return true;
 }
+
+TrimResult trim_silence(std::vector<float>& pcm, int sample_rate, const TrimOptions& options) {
+    TrimResult result;
+    const size_t frame_len = static_cast<size_t>(sample_rate) * options.frame_ms / 1000;
+    if (!options.enabled || frame_len == 0 || pcm.size() < frame_len * 2) {
+        return result;
+    }
+
+    const size_t n_frames = pcm.size() / frame_len;
+    std::vector<float> rms(n_frames);
+    std::vector<float> peak(n_frames);
+    frame_rms_peak(pcm.data(), n_frames, frame_len, rms.data(), peak.data());
+
+    auto to_db = [](float v) { return v > 0.0f ? std::max(-90.0f, 20.0f * std::log10(v)) : -90.0f; };
+    std::vector<float> level_db(n_frames);
+    float max_peak = 0.0f;
+    for (size_t f = 0; f < n_frames; f++) {
+        level_db[f] = to_db(rms[f]);
+        max_peak = std::max(max_peak, peak[f]);
+    }
+
+    // Nothing reaches the speech threshold anywhere: keep the recording as is
+    if (to_db(max_peak) < options.min_level_db) {
+        LOGI("Trim: peak %.1f dBFS below threshold, not trimming", to_db(max_peak));
+        return result;
+    }
+
+    // Noise floor: 10th percentile frame level
+    std::vector<float> sorted = level_db;
+    std::nth_element(sorted.begin(), sorted.begin() + n_frames / 10, sorted.end());
+    result.noise_db = sorted[n_frames / 10];
+    const float threshold = std::max(result.noise_db + options.margin_db, options.min_level_db);
+
+    // First/last run of min_sound_ms consecutive loud frames
+    const size_t min_run = std::max<size_t>(1, static_cast<size_t>(options.min_sound_ms / options.frame_ms));
+    size_t first = n_frames;
+    for (size_t f = 0, run = 0; f < n_frames; f++) {
+        run = level_db[f] > threshold ? run + 1 : 0;
+        if (run == min_run) {
+            first = f + 1 - min_run;
+            break;
+        }
+    }
+    if (first == n_frames) {
+        LOGI("Trim: no sustained sound above %.1f dB, not trimming", threshold);
+        return result;
+    }
+    result.sound = true;
+    size_t last = first;
+    for (size_t f = n_frames, run = 0; f > first; f--) {
+        run = level_db[f - 1] > threshold ? run + 1 : 0;
+        if (run == min_run) {
+            last = f - 1 + min_run;
+            break;
+        }
+    }
+
+    const size_t padding = static_cast<size_t>(sample_rate) * options.padding_ms / 1000;
+    const size_t start = first * frame_len > padding ? first * frame_len - padding : 0;
+    const size_t end = std::min(pcm.size(), last * frame_len + padding);
+    result.leading = start;
+    result.trailing = pcm.size() - end;
+
+    if (result.leading > 0 || result.trailing > 0) {
+        pcm.erase(pcm.begin() + static_cast<std::ptrdiff_t>(end), pcm.end());
+        pcm.erase(pcm.begin(), pcm.begin() + static_cast<std::ptrdiff_t>(start));
+        LOGI("Trim: cut %zu leading + %zu trailing samples (noise floor %.1f dB)",
+             result.leading, result.trailing, result.noise_db);
+    }
+    return result;
+}
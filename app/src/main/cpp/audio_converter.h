@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Read WAV file and extract PCM samples as float32
+ * Returns true on success, false on failure
+ */
+bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_rate);
+
+/**
+ * Leading/trailing silence trimming applied to read_wav output
+ *
+ * Cheap RMS/peak scan with a noise-floor estimate; keyboard recordings
+ * typically start with 0.5-1.5 s of button-press silence. Only the edges are
+ * cut, pauses inside the recording are left to the VAD.
+ */
+struct TrimOptions {
+    bool enabled = true;
+    int frame_ms = 10;
+    float margin_db = 12.0f;      // Sound must be this far above the noise floor (RMS)
+    float min_level_db = -50.0f;  // ...and above this absolute level (dBFS)
+    int min_sound_ms = 60;        // Shorter bursts (button clicks) don't count as sound
+    int padding_ms = 150;         // Kept before the first and after the last sound
+};
+
+struct TrimResult {
+    size_t leading = 0;           // Samples removed from the start
+    size_t trailing = 0;          // Samples removed from the end
+    float noise_db = -90.0f;      // Estimated noise floor (dBFS)
+    bool sound = false;           // Sustained sound found (pcm is trimmed around it)
+};
+
+/**
+ * Trim near-silence from both ends of pcm in place
+ * Leaves pcm untouched when no sound is found (let the VAD / whisper decide)
+ */
+TrimResult trim_silence(std::vector<float>& pcm, int sample_rate, const TrimOptions& options);
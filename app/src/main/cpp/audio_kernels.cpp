@@ -0,0 +1,267 @@
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Keep the scalar reference kernels scalar so benchmarks compare like with like
+#if defined(__clang__)
+#define SCALAR_FN
+#define SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define SCALAR_FN __attribute__((optimize("no-tree-vectorize")))
+#define SCALAR_LOOP
+#else
+#define SCALAR_FN
+#define SCALAR_LOOP
+#endif
+
+static constexpr float kPcm16Scale = 1.0f / 32768.0f;
+static constexpr float kPcm32Scale = 1.0f / 2147483648.0f;
+
+SCALAR_FN void pcm16_to_float_scalar(const int16_t* in, float* out, size_t n) {
+    SCALAR_LOOP
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<float>(in[i]) * kPcm16Scale;
+    }
+}
+
+void pcm16_to_float_simd(const int16_t* in, float* out, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t scale = vdupq_n_f32(kPcm16Scale);
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        const int32x4_t lo = vmovl_s16(vget_low_s16(v));
+        const int32x4_t hi = vmovl_s16(vget_high_s16(v));
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(lo), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(hi), scale));
+    }
+#elif defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(kPcm16Scale);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i sign = _mm_srai_epi16(v, 15);
+        const __m128i lo = _mm_unpacklo_epi16(v, sign);
+        const __m128i hi = _mm_unpackhi_epi16(v, sign);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = static_cast<float>(in[i]) * kPcm16Scale;
+    }
+}
+
+SCALAR_FN void pcm32_to_float_scalar(const int32_t* in, float* out, size_t n) {
+    SCALAR_LOOP
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<float>(in[i]) * kPcm32Scale;
+    }
+}
+
+void pcm32_to_float_simd(const int32_t* in, float* out, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t scale = vdupq_n_f32(kPcm32Scale);
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(in + i)), scale));
+    }
+#elif defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(kPcm32Scale);
+    for (; i + 4 <= n; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = static_cast<float>(in[i]) * kPcm32Scale;
+    }
+}
+
+SCALAR_FN void stereo_to_mono_scalar(const float* in, float* out, size_t n_frames) {
+    SCALAR_LOOP
+    for (size_t i = 0; i < n_frames; i++) {
+        out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+    }
+}
+
+void stereo_to_mono_simd(const float* in, float* out, size_t n_frames) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 4 <= n_frames; i += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + i * 2);
+        vst1q_f32(out + i, vmulq_f32(vaddq_f32(lr.val[0], lr.val[1]), half));
+    }
+#elif defined(__SSE2__)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= n_frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + i * 2);     // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(in + i * 2 + 4); // L2 R2 L3 R3
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+#endif
+    for (; i < n_frames; i++) {
+        out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+    }
+}
+
+SCALAR_FN void resample_linear_scalar(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out) {
+    const double ratio = static_cast<double>(in_rate) / static_cast<double>(out_rate);
+    const size_t out_n = static_cast<size_t>(n / ratio);
+    out.assign(out_n, 0.0f);
+
+    SCALAR_LOOP
+    for (size_t i = 0; i < out_n; i++) {
+        const double src = i * ratio;
+        const size_t idx = static_cast<size_t>(src);
+        if (idx + 1 < n) {
+            const float frac = static_cast<float>(src - idx);
+            out[i] = in[idx] + (in[idx + 1] - in[idx]) * frac;
+        } else if (idx < n) {
+            out[i] = in[idx];
+        }
+    }
+}
+
+void resample_linear_simd(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out) {
+    const double ratio = static_cast<double>(in_rate) / static_cast<double>(out_rate);
+    const size_t out_n = static_cast<size_t>(n / ratio);
+    out.assign(out_n, 0.0f);
+    if (out_n == 0) {
+        return;
+    }
+
+    // 32.32 fixed-point source position avoids a double multiply per sample
+    const uint64_t step = (static_cast<uint64_t>(in_rate) << 32) / static_cast<uint64_t>(out_rate);
+    constexpr float kFracScale = 1.0f / 4294967296.0f;
+
+    // Blocks of 4 outputs whose right neighbours are all in range
+    size_t i = 0;
+    uint64_t pos = 0;
+    const size_t safe_n = n >= 2 ? n - 1 : 0;
+    for (; i + 4 <= out_n && ((pos + 3 * step) >> 32) < safe_n; i += 4) {
+        float a[4], b[4], f[4];
+        for (int k = 0; k < 4; k++) {
+            const size_t idx = static_cast<size_t>(pos >> 32);
+            a[k] = in[idx];
+            b[k] = in[idx + 1];
+            f[k] = static_cast<float>(static_cast<uint32_t>(pos)) * kFracScale;
+            pos += step;
+        }
+#if defined(__ARM_NEON)
+        const float32x4_t va = vld1q_f32(a);
+        vst1q_f32(out.data() + i, vmlaq_f32(va, vsubq_f32(vld1q_f32(b), va), vld1q_f32(f)));
+#elif defined(__SSE2__)
+        const __m128 va = _mm_loadu_ps(a);
+        _mm_storeu_ps(out.data() + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b), va), _mm_loadu_ps(f))));
+#else
+        for (int k = 0; k < 4; k++) {
+            out[i + k] = a[k] + (b[k] - a[k]) * f[k];
+        }
+#endif
+    }
+
+    for (; i < out_n; i++) {
+        const size_t idx = static_cast<size_t>(pos >> 32);
+        if (idx + 1 < n) {
+            const float frac = static_cast<float>(static_cast<uint32_t>(pos)) * kFracScale;
+            out[i] = in[idx] + (in[idx + 1] - in[idx]) * frac;
+        } else if (idx < n) {
+            out[i] = in[idx];
+        }
+        pos += step;
+    }
+}
+
+SCALAR_FN void frame_rms_peak_scalar(const float* in, size_t n_frames, size_t frame_len, float* rms, float* peak) {
+    for (size_t f = 0; f < n_frames; f++) {
+        const float* frame = in + f * frame_len;
+        float sum = 0.0f;
+        float max_abs = 0.0f;
+        SCALAR_LOOP
+        for (size_t i = 0; i < frame_len; i++) {
+            sum += frame[i] * frame[i];
+            max_abs = std::max(max_abs, std::fabs(frame[i]));
+        }
+        rms[f] = std::sqrt(sum / static_cast<float>(frame_len));
+        peak[f] = max_abs;
+    }
+}
+
+void frame_rms_peak_simd(const float* in, size_t n_frames, size_t frame_len, float* rms, float* peak) {
+    for (size_t f = 0; f < n_frames; f++) {
+        const float* frame = in + f * frame_len;
+        float sum = 0.0f;
+        float max_abs = 0.0f;
+        size_t i = 0;
+#if defined(__ARM_NEON)
+        float32x4_t vsum = vdupq_n_f32(0.0f);
+        float32x4_t vmax = vdupq_n_f32(0.0f);
+        for (; i + 4 <= frame_len; i += 4) {
+            const float32x4_t v = vld1q_f32(frame + i);
+            vsum = vmlaq_f32(vsum, v, v);
+            vmax = vmaxq_f32(vmax, vabsq_f32(v));
+        }
+        const float32x2_t s2 = vadd_f32(vget_low_f32(vsum), vget_high_f32(vsum));
+        sum = vget_lane_f32(vpadd_f32(s2, s2), 0);
+        const float32x2_t m2 = vmax_f32(vget_low_f32(vmax), vget_high_f32(vmax));
+        max_abs = vget_lane_f32(vpmax_f32(m2, m2), 0);
+#elif defined(__SSE2__)
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 vsum = _mm_setzero_ps();
+        __m128 vmax = _mm_setzero_ps();
+        for (; i + 4 <= frame_len; i += 4) {
+            const __m128 v = _mm_loadu_ps(frame + i);
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+            vmax = _mm_max_ps(vmax, _mm_and_ps(v, abs_mask));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vsum);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm_storeu_ps(lanes, vmax);
+        max_abs = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+        for (; i < frame_len; i++) {
+            sum += frame[i] * frame[i];
+            max_abs = std::max(max_abs, std::fabs(frame[i]));
+        }
+        rms[f] = std::sqrt(sum / static_cast<float>(frame_len));
+        peak[f] = max_abs;
+    }
+}
+
+SCALAR_FN void power_spectrum_scalar(const float* re, const float* im, float* out, size_t n) {
+    SCALAR_LOOP
+    for (size_t i = 0; i < n; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+void power_spectrum_simd(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t r = vld1q_f32(re + i);
+        const float32x4_t m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vmlaq_f32(vmulq_f32(r, r), m, m));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        const __m128 r = _mm_loadu_ps(re + i);
+        const __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
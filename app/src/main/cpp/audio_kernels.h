@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Audio front-end kernels used between read_wav and whisper
+ *
+ * Every kernel has a scalar reference (_scalar) and a SIMD version (_simd,
+ * NEON on ARM, SSE2 on x86_64) with identical results up to float rounding.
+ * The unsuffixed names pick the fastest variant for the build.
+ */
+
+// int16 PCM -> float32 in [-1, 1)
+void pcm16_to_float_scalar(const int16_t* in, float* out, size_t n);
+void pcm16_to_float_simd(const int16_t* in, float* out, size_t n);
+
+// int32 PCM -> float32 in [-1, 1)
+void pcm32_to_float_scalar(const int32_t* in, float* out, size_t n);
+void pcm32_to_float_simd(const int32_t* in, float* out, size_t n);
+
+// Interleaved stereo -> mono by averaging channels (n_frames output samples)
+void stereo_to_mono_scalar(const float* in, float* out, size_t n_frames);
+void stereo_to_mono_simd(const float* in, float* out, size_t n_frames);
+
+// Linear interpolation resampling (same scheme as AudioConverter.kt)
+void resample_linear_scalar(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out);
+void resample_linear_simd(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out);
+
+// Per-frame RMS and absolute peak over n_frames consecutive frames of frame_len samples
+void frame_rms_peak_scalar(const float* in, size_t n_frames, size_t frame_len, float* rms, float* peak);
+void frame_rms_peak_simd(const float* in, size_t n_frames, size_t frame_len, float* rms, float* peak);
+
+// |X|^2 of a split-complex spectrum
+void power_spectrum_scalar(const float* re, const float* im, float* out, size_t n);
+void power_spectrum_simd(const float* re, const float* im, float* out, size_t n);
+
+inline void pcm16_to_float(const int16_t* in, float* out, size_t n) {
+    pcm16_to_float_simd(in, out, n);
+}
+
+inline void pcm32_to_float(const int32_t* in, float* out, size_t n) {
+    pcm32_to_float_simd(in, out, n);
+}
+
+inline void stereo_to_mono(const float* in, float* out, size_t n_frames) {
+    stereo_to_mono_simd(in, out, n_frames);
+}
+
+inline void resample_linear(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out) {
+    resample_linear_simd(in, n, in_rate, out_rate, out);
+}
+
+inline void frame_rms_peak(const float* in, size_t n_frames, size_t frame_len, float* rms, float* peak) {
+    frame_rms_peak_simd(in, n_frames, frame_len, rms, peak);
+}
+
+inline void power_spectrum(const float* re, const float* im, float* out, size_t n) {
+    power_spectrum_simd(re, im, out, n);
+}
@@ -0,0 +1,32 @@
+#include "confidence.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+float compression_ratio(const std::string& text) {
+    if (text.empty()) {
+        return 0.0f;
+    }
+    uLongf size = compressBound(static_cast<uLong>(text.size()));
+    std::vector<Bytef> buffer(size);
+    if (compress(buffer.data(), &size, reinterpret_cast<const Bytef*>(text.data()), static_cast<uLong>(text.size())) != Z_OK ||
+        size == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(text.size()) / static_cast<float>(size);
+}
+
+TranscriptConfidence summarize_confidence(const std::vector<TranscribeSegment>& segments, const std::string& text) {
+    TranscriptConfidence confidence;
+    double sum_logprob = 0.0;
+    for (const TranscribeSegment& segment : segments) {
+        sum_logprob += static_cast<double>(segment.avg_logprob) * segment.n_tokens;
+        confidence.n_tokens += segment.n_tokens;
+        confidence.no_speech_prob = std::max(confidence.no_speech_prob, segment.no_speech_prob);
+    }
+    if (confidence.n_tokens > 0) {
+        confidence.avg_logprob = static_cast<float>(sum_logprob / confidence.n_tokens);
+    }
+    confidence.compression_ratio = compression_ratio(text);
+    return confidence;
+}
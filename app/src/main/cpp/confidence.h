@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "whisper_engine.h"
+
+/**
+ * Transcript quality signals computed from whisper's token data
+ *
+ * Callers use them to tell a usable on-device result from a hallucination or
+ * a misrecognition (e.g. to re-run it elsewhere) without a reference text.
+ */
+
+/**
+ * Text bytes divided by their zlib-compressed size, as whisper's reference
+ * implementation computes it; 0 for empty text
+ */
+float compression_ratio(const std::string& text);
+
+/**
+ * Aggregate per-segment metrics: token-weighted avg_logprob, the highest
+ * no_speech_prob and the compression ratio of text
+ */
+TranscriptConfidence summarize_confidence(const std::vector<TranscribeSegment>& segments, const std::string& text);
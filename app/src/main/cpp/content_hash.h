@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Content hashing for the transcription caches
+ *
+ * XXH64 (same output as the reference xxHash implementation), fast enough to
+ * fingerprint a whole recording on every transcription: ~1 ms for 30 s of
+ * float PCM on a mid-range phone.
+ */
+
+uint64_t content_hash(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * Fingerprint of PCM samples (the float bit patterns, so -0.0f and 0.0f differ)
+ */
+inline uint64_t content_hash_pcm(const float* samples, size_t n_samples, uint64_t seed = 0) {
+    return content_hash(samples, n_samples * sizeof(float), seed);
+}
@@ -0,0 +1,144 @@
+#include "cpu_features.h"
+
+#include <cstring>
+#include <mutex>
+#include "ggml-backend.h"
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+#define LOG_TAG "CpuFeatures"
+#include "hw_log.h"
+
+#if defined(__aarch64__)
+// Not every NDK/libc exposes the newer HWCAP bits
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD (1 << 1)
+#endif
+#ifndef HWCAP_FPHP
+#define HWCAP_FPHP (1 << 9)
+#endif
+#ifndef HWCAP_ASIMDHP
+#define HWCAP_ASIMDHP (1 << 10)
+#endif
+#ifndef HWCAP_ASIMDDP
+#define HWCAP_ASIMDDP (1 << 20)
+#endif
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#ifndef HWCAP2_I8MM
+#define HWCAP2_I8MM (1 << 13)
+#endif
+#endif
+
+static std::once_flag g_backends_once;
+
+CpuFeatures cpu_features_probe() {
+    CpuFeatures features;
+
+#if defined(__aarch64__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    features.neon = (hwcap & HWCAP_ASIMD) != 0;
+    features.dotprod = (hwcap & HWCAP_ASIMDDP) != 0;
+    features.fp16 = (hwcap & HWCAP_FPHP) != 0 && (hwcap & HWCAP_ASIMDHP) != 0;
+    features.i8mm = (hwcap2 & HWCAP2_I8MM) != 0;
+    features.sve = (hwcap & HWCAP_SVE) != 0;
+#elif defined(__arm__)
+    features.neon = true; // armeabi-v7a is built with -mfpu=neon
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    features.sse42 = __builtin_cpu_supports("sse4.2");
+    features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+
+    return features;
+}
+
+std::string cpu_features_variant(const CpuFeatures& features) {
+#if defined(__aarch64__)
+    std::string variant;
+    if (features.dotprod && features.fp16 && features.i8mm) {
+        variant = "armv8.6+dotprod+fp16+i8mm";
+    } else if (features.dotprod && features.fp16) {
+        variant = "armv8.2+dotprod+fp16";
+    } else if (features.dotprod) {
+        variant = "armv8.2+dotprod";
+    } else {
+        variant = "armv8.0";
+    }
+    if (features.sve) {
+        variant += "+sve";
+    }
+    return variant;
+#elif defined(__arm__)
+    return "armv7+neon";
+#elif defined(__x86_64__) || defined(__i386__)
+    if (features.avx512) {
+        return "x86_64-avx512";
+    }
+    if (features.avx2) {
+        return "x86_64-avx2";
+    }
+    if (features.sse42) {
+        return "x86_64-sse4.2";
+    }
+    return "x86_64";
+#else
+    (void) features;
+    return "generic";
+#endif
+}
+
+void cpu_backends_load(const char* lib_dir) {
+    std::call_once(g_backends_once, [lib_dir]() {
+#ifdef HYPERWHISPER_CPU_VARIANTS
+        if (lib_dir != nullptr && lib_dir[0] != '\0') {
+            // ggml scores every libggml-cpu-*.so in lib_dir against the CPU and keeps the best
+            LOGI("Loading ggml backends from: %s", lib_dir);
+            ggml_backend_load_all_from_path(lib_dir);
+        }
+#else
+        (void) lib_dir;
+#endif
+        const CpuFeatures features = cpu_features_probe();
+        LOGI("CPU variant: %s", cpu_features_variant(features).c_str());
+        LOGI("ggml backends: %s", cpu_backends_describe().c_str());
+    });
+}
+
+std::string cpu_backends_describe() {
+    std::string description;
+
+    for (size_t i = 0; i < ggml_backend_reg_count(); i++) {
+        ggml_backend_reg_t reg = ggml_backend_reg_get(i);
+        if (!description.empty()) {
+            description += "; ";
+        }
+        description += ggml_backend_reg_name(reg);
+
+        auto get_features = (ggml_backend_get_features_t)
+            ggml_backend_reg_get_proc_address(reg, "ggml_backend_get_features");
+        if (get_features == nullptr) {
+            continue;
+        }
+
+        description += ":";
+        for (ggml_backend_feature* f = get_features(reg); f->name != nullptr; f++) {
+            if (strcmp(f->value, "0") == 0) {
+                continue;
+            }
+            description += " ";
+            description += f->name;
+            if (strcmp(f->value, "1") != 0) {
+                description += "=";
+                description += f->value;
+            }
+        }
+    }
+
+    return description.empty() ? "none" : description;
+}
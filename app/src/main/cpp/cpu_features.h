@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+/**
+ * CPU features relevant to the ggml kernel variants we ship
+ */
+struct CpuFeatures {
+    // arm64
+    bool neon = false;
+    bool dotprod = false;   // SDOT/UDOT (armv8.2)
+    bool fp16 = false;      // FP16 vector arithmetic (armv8.2)
+    bool i8mm = false;      // Int8 matrix multiply (armv8.6)
+    bool sve = false;
+
+    // x86_64
+    bool sse42 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+};
+
+/**
+ * Probe the running CPU (HWCAP on arm64, CPUID on x86_64)
+ */
+CpuFeatures cpu_features_probe();
+
+/**
+ * Short name of the ISA level the features allow, e.g. "armv8.2+dotprod+fp16"
+ */
+std::string cpu_features_variant(const CpuFeatures& features);
+
+/**
+ * Load the ggml CPU backend variants from lib_dir and let ggml pick the best
+ * one for this CPU. Safe to call more than once; only the first call loads.
+ * An empty lib_dir leaves backend discovery to ggml's default search paths.
+ */
+void cpu_backends_load(const char* lib_dir);
+
+/**
+ * Describe the selected variant and the features ggml reports for it
+ */
+std::string cpu_backends_describe();
@@ -0,0 +1,34 @@
+#include "decode_profile.h"
+
+namespace {
+
+// Indexed by DecodeProfile; Balanced mirrors whisper_full_default_params(GREEDY)
+const DecodeProfileParams kParams[] = {
+    {0, 1, 0.0f},
+    {0, 5, 0.2f},
+    {5, 5, 0.2f},
+};
+
+const char* const kNames[] = {"fast", "balanced", "accurate"};
+
+} // namespace
+
+const DecodeProfileParams& decode_profile_params(DecodeProfile profile) {
+    return kParams[static_cast<int>(decode_profile_from_int(static_cast<int>(profile)))];
+}
+
+DecodeProfile decode_profile_from_int(int value) {
+    if (value < static_cast<int>(DecodeProfile::Fast) || value > static_cast<int>(DecodeProfile::Accurate)) {
+        return DecodeProfile::Balanced;
+    }
+    return static_cast<DecodeProfile>(value);
+}
+
+DecodeProfile decode_profile_downgrade(DecodeProfile profile) {
+    const int value = static_cast<int>(decode_profile_from_int(static_cast<int>(profile)));
+    return static_cast<DecodeProfile>(value > 0 ? value - 1 : 0);
+}
+
+const char* decode_profile_name(DecodeProfile profile) {
+    return kNames[static_cast<int>(decode_profile_from_int(static_cast<int>(profile)))];
+}
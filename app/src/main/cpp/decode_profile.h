@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+ * Decoding strategies offered to callers, from cheapest to most accurate
+ *
+ * Fast decodes greedily once with no temperature fallback. Balanced is
+ * whisper's default: greedy, retried at higher temperatures with best-of-5
+ * sampling when a window looks unreliable. Accurate runs beam search.
+ */
+
+enum class DecodeProfile : int {
+    Fast = 0,
+    Balanced = 1,
+    Accurate = 2,
+};
+
+struct DecodeProfileParams {
+    int beam_size = 0;             // > 1 selects beam search
+    int best_of = 1;               // Greedy candidates per fallback temperature
+    float temperature_inc = 0.0f;  // Fallback step (0 = never retry a window)
+};
+
+/**
+ * Sampling parameters of profile; out-of-range values are treated as Balanced
+ */
+const DecodeProfileParams& decode_profile_params(DecodeProfile profile);
+
+/**
+ * Profile for a value coming over JNI or the command line
+ */
+DecodeProfile decode_profile_from_int(int value);
+
+/**
+ * Next cheaper profile (Fast stays Fast)
+ */
+DecodeProfile decode_profile_downgrade(DecodeProfile profile);
+
+const char* decode_profile_name(DecodeProfile profile);
@@ -0,0 +1,165 @@
+#include "encoder_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "repetition_guard.h"
+
+#define LOG_TAG "EncoderCache"
+#include "hw_log.h"
+
+struct whisper_state* EncoderCache::find(uint64_t key, int& lang_id) {
+    for (Entry& entry : entries_) {
+        if (entry.valid && entry.key == key) {
+            entry.last_use = ++clock_;
+            lang_id = entry.lang_id;
+            hits_++;
+            return entry.state;
+        }
+    }
+    misses_++;
+    return nullptr;
+}
+
+struct whisper_state* EncoderCache::acquire(struct whisper_context* ctx, size_t capacity) {
+    if (entries_.size() < std::max<size_t>(capacity, 1)) {
+        struct whisper_state* state = whisper_init_state(ctx);
+        if (state != nullptr) {
+            Entry entry;
+            entry.state = state;
+            entry.last_use = ++clock_;
+            entries_.push_back(entry);
+            return state;
+        }
+        LOGW("Failed to create whisper_state, reusing a cached one");
+        if (entries_.empty()) {
+            return nullptr;
+        }
+    }
+
+    Entry* lru = &entries_.front();
+    for (Entry& entry : entries_) {
+        if (entry.last_use < lru->last_use) {
+            lru = &entry;
+        }
+    }
+    lru->valid = false;
+    lru->last_use = ++clock_;
+    return lru->state;
+}
+
+void EncoderCache::commit(struct whisper_state* state, uint64_t key, int lang_id) {
+    for (Entry& entry : entries_) {
+        // A key can only live in one entry; drop a stale duplicate first
+        if (entry.valid && entry.key == key && entry.state != state) {
+            entry.valid = false;
+        }
+    }
+    for (Entry& entry : entries_) {
+        if (entry.state == state) {
+            entry.key = key;
+            entry.lang_id = lang_id;
+            entry.valid = true;
+            entry.last_use = ++clock_;
+        }
+    }
+}
+
+void EncoderCache::clear() {
+    for (Entry& entry : entries_) {
+        whisper_free_state(entry.state);
+    }
+    entries_.clear();
+}
+
+bool encoder_cache_decode(struct whisper_context* ctx, struct whisper_state* state,
+                          const CachedDecodeRequest& request, CachedDecodeResult& out) {
+    out = CachedDecodeResult();
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_vocab = whisper_n_vocab(ctx);
+    const int n_text_ctx = whisper_n_text_ctx(ctx);
+    whisper_token blank = -1;
+    whisper_tokenize(ctx, " ", &blank, 1);
+
+    // [prev prompt...] sot [lang task] notimestamps, as whisper_full builds it
+    std::vector<whisper_token> tokens;
+    if (!request.prompt.empty()) {
+        const size_t keep = std::min(request.prompt.size(), static_cast<size_t>(n_text_ctx / 2 - 1));
+        tokens.push_back(whisper_token_prev(ctx));
+        tokens.insert(tokens.end(), request.prompt.end() - keep, request.prompt.end());
+    }
+    tokens.push_back(whisper_token_sot(ctx));
+    if (whisper_is_multilingual(ctx)) {
+        if (request.lang_id < 0) {
+            LOGE("Cached decode needs a language for multilingual models");
+            return false;
+        }
+        tokens.push_back(whisper_token_lang(ctx, request.lang_id));
+        tokens.push_back(request.translate ? whisper_token_translate(ctx) : whisper_token_transcribe(ctx));
+    }
+    tokens.push_back(whisper_token_not(ctx));
+
+    int n_past = 0;
+    if (whisper_decode_with_state(ctx, state, tokens.data(), static_cast<int>(tokens.size()), n_past, request.n_threads) != 0) {
+        LOGE("Prompt decode failed");
+        return false;
+    }
+    n_past += static_cast<int>(tokens.size());
+
+    // Same sample_len as whisper_full: half the text context
+    int n_max = std::min(n_text_ctx / 2, n_text_ctx - n_past);
+    if (request.max_tokens > 0) {
+        n_max = std::min(n_max, request.max_tokens);
+    }
+    const RepetitionGuardOptions guard;
+    std::vector<int32_t> picked;
+    std::vector<float> logprobs;
+    for (int i = 0; i < n_max; i++) {
+        const float* logits = whisper_get_logits_from_state(state);
+
+        // Text tokens only; eot ends the output but may not be the first token
+        whisper_token best = -1;
+        float best_logit = -std::numeric_limits<float>::infinity();
+        const int n_candidates = std::min(n_vocab, static_cast<int>(eot) + (i > 0 ? 1 : 0));
+        for (int t = 0; t < n_candidates; t++) {
+            if (logits[t] > best_logit && (i > 0 || t != blank)) {
+                best_logit = logits[t];
+                best = t;
+            }
+        }
+        if (best < 0 || best == eot) {
+            break;
+        }
+        // log-softmax of the pick over the same candidates, as whisper's token plog
+        double sum_exp = 0.0;
+        for (int t = 0; t < n_candidates; t++) {
+            if (i > 0 || t != blank) {
+                sum_exp += std::exp(static_cast<double>(logits[t] - best_logit));
+            }
+        }
+        picked.push_back(best);
+        logprobs.push_back(-static_cast<float>(std::log(sum_exp)));
+
+        int repeats = 0;
+        const int period = request.stop_repetition
+            ? repetition_period(picked.data(), picked.size(), guard.max_period, guard.min_repeats, guard.min_span, &repeats)
+            : 0;
+        if (period > 0) {
+            LOGI("Loop stopped after %zu tokens: %d-token unit repeated %d times", picked.size(), period, repeats);
+            picked.resize(picked.size() - static_cast<size_t>((repeats - 1) * period));
+            break;
+        }
+        if (whisper_decode_with_state(ctx, state, &best, 1, n_past, request.n_threads) != 0) {
+            LOGE("Decode failed at token %d", i);
+            return false;
+        }
+        n_past++;
+    }
+
+    for (size_t i = 0; i < picked.size(); i++) {
+        out.sum_logprob += logprobs[i];
+        out.text += whisper_token_to_str(ctx, picked[i]);
+    }
+    out.n_tokens = static_cast<int>(picked.size());
+    return true;
+}
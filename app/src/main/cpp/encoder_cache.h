@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "whisper.h"
+
+/**
+ * Encoder-output cache for reprocessing the same audio
+ *
+ * A whisper_state keeps the cross-attention K/V computed by the encoder for
+ * the last window it processed. For single-window audio that is the whole
+ * recording, so the state of a finished whisper_full run can decode the same
+ * audio again with a different language, task or prompt without running the
+ * encoder. The cache keeps the states of the last few such runs, keyed by a
+ * content hash of the samples fed to whisper, and evicts least recently used.
+ */
+
+class EncoderCache {
+public:
+    EncoderCache() = default;
+    ~EncoderCache() { clear(); }
+    EncoderCache(const EncoderCache&) = delete;
+    EncoderCache& operator=(const EncoderCache&) = delete;
+
+    /**
+     * State holding the encoder output for key, or null on a miss
+     * lang_id receives the language whisper used for that run (-1 if unknown)
+     */
+    struct whisper_state* find(uint64_t key, int& lang_id);
+
+    /**
+     * State to run a new transcription on: a fresh one while below capacity, otherwise
+     * the least recently used entry (its key is dropped). Null if no state can be created.
+     */
+    struct whisper_state* acquire(struct whisper_context* ctx, size_t capacity);
+
+    /**
+     * Publish the encoder output in state (from acquire) under key
+     */
+    void commit(struct whisper_state* state, uint64_t key, int lang_id);
+
+    /**
+     * Free every state; required before the owning context is freed
+     */
+    void clear();
+
+    size_t size() const { return entries_.size(); }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        struct whisper_state* state = nullptr;
+        uint64_t key = 0;
+        bool valid = false;
+        int lang_id = -1;
+        uint64_t last_use = 0;
+    };
+
+    std::vector<Entry> entries_;
+    uint64_t clock_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+/**
+ * Decoder-only request against a cached state
+ */
+struct CachedDecodeRequest {
+    int lang_id = -1;                    // Required for multilingual models
+    bool translate = false;
+    std::vector<whisper_token> prompt;   // Previous-context tokens (without the prev marker), may be empty
+    int n_threads = 4;
+    int max_tokens = 0;                  // Text-token cap (0 = half the text context, as whisper_full)
+    bool stop_repetition = false;        // End at a repeated unit and drop its repeats (see repetition_guard.h)
+};
+
+struct CachedDecodeResult {
+    std::string text;          // Concatenated text tokens
+    float sum_logprob = 0.0f;  // Log-probabilities of those tokens among the sampled candidates
+    int n_tokens = 0;
+};
+
+/**
+ * Greedy, timestamp-free decode of the audio encoded in state
+ * Mirrors whisper_full's greedy sampler at temperature 0 (special tokens
+ * suppressed, no blank first token).
+ */
+bool encoder_cache_decode(struct whisper_context* ctx, struct whisper_state* state,
+                          const CachedDecodeRequest& request, CachedDecodeResult& out);
@@ -0,0 +1,96 @@
+#include "endpoint.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "Endpoint"
+#include "hw_log.h"
+
+namespace {
+
+constexpr float kFloorDb = -96.0f;
+constexpr int kCalibrationFrames = 10; // First 200 ms seed the noise floor
+constexpr float kNoiseRise = 0.01f;    // Per-frame drift toward louder background
+
+} // namespace
+
+EndpointDetector::EndpointDetector(const EndpointOptions& options)
+    : options_(options),
+      frame_len_(std::max<size_t>(1, static_cast<size_t>(options.sample_rate) * options.frame_ms / 1000)) {
+    reset();
+}
+
+void EndpointDetector::reset() {
+    state_ = EndpointState::WAITING;
+    frame_energy_ = 0.0;
+    frame_fill_ = 0;
+    noise_db_ = kFloorDb;
+    frames_seen_ = 0;
+    speech_ms_ = 0;
+    silence_ms_ = 0;
+}
+
+EndpointState EndpointDetector::process(const int16_t* pcm, size_t n_samples) {
+    constexpr double kScale = 1.0 / (32768.0 * 32768.0);
+    size_t i = 0;
+    while (i < n_samples) {
+        const size_t take = std::min(frame_len_ - frame_fill_, n_samples - i);
+        // Integer sum of squares vectorizes well; 20 ms of int16 squares fits in int64 easily
+        int64_t sum = 0;
+        for (size_t k = 0; k < take; k++) {
+            const int32_t s = pcm[i + k];
+            sum += s * s;
+        }
+        frame_energy_ += static_cast<double>(sum) * kScale;
+        frame_fill_ += take;
+        i += take;
+
+        if (frame_fill_ == frame_len_) {
+            const double mean = frame_energy_ / static_cast<double>(frame_len_);
+            process_frame(mean > 0.0 ? std::max(kFloorDb, static_cast<float>(10.0 * std::log10(mean))) : kFloorDb);
+            frame_energy_ = 0.0;
+            frame_fill_ = 0;
+        }
+    }
+    return state_;
+}
+
+void EndpointDetector::process_frame(float energy_db) {
+    if (state_ == EndpointState::END_OF_UTTERANCE) {
+        return;
+    }
+
+    // Noise floor: average of the first frames, then follow quiet frames down
+    // immediately and drift up slowly so sustained speech never becomes "noise"
+    frames_seen_++;
+    if (frames_seen_ <= kCalibrationFrames) {
+        noise_db_ = frames_seen_ == 1 ? energy_db : noise_db_ + (energy_db - noise_db_) / frames_seen_;
+        return;
+    }
+    if (energy_db < noise_db_) {
+        noise_db_ = energy_db;
+    } else {
+        noise_db_ += (energy_db - noise_db_) * kNoiseRise;
+    }
+
+    const bool speech = energy_db > std::max(noise_db_ + options_.margin_db, options_.min_energy_db);
+    if (speech) {
+        speech_ms_ += options_.frame_ms;
+        silence_ms_ = 0;
+        if (state_ == EndpointState::WAITING && speech_ms_ >= options_.min_speech_ms) {
+            state_ = EndpointState::SPEECH;
+            LOGI("Speech started (noise floor %.1f dB)", noise_db_);
+        }
+        return;
+    }
+
+    silence_ms_ += options_.frame_ms;
+    if (state_ == EndpointState::WAITING && silence_ms_ >= options_.hangover_ms) {
+        // Isolated blips before the utterance don't accumulate into speech
+        speech_ms_ = 0;
+    }
+    if (state_ == EndpointState::SPEECH && silence_ms_ >= options_.hangover_ms) {
+        state_ = EndpointState::END_OF_UTTERANCE;
+        LOGI("End of utterance after %d ms of silence", silence_ms_);
+    }
+}
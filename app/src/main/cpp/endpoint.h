@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Streaming end-of-utterance detector for live recording
+ *
+ * Consumes int16 PCM frames as they are captured, tracks an adaptive noise
+ * floor, and reports end-of-utterance once speech has been heard and is
+ * followed by hangover_ms of continuous silence.
+ */
+
+struct EndpointOptions {
+    int sample_rate = 16000;
+    int frame_ms = 20;
+    int hangover_ms = 1500;        // Trailing silence that ends the utterance
+    int min_speech_ms = 300;       // Speech needed before silence can end anything
+    float margin_db = 10.0f;       // Speech must be this far above the noise floor
+    float min_energy_db = -55.0f;  // ...and above this absolute level (dBFS)
+};
+
+enum class EndpointState : int {
+    WAITING = 0,         // No speech yet
+    SPEECH = 1,          // Speech heard, utterance in progress
+    END_OF_UTTERANCE = 2 // Speech followed by hangover_ms of silence (sticky until reset)
+};
+
+class EndpointDetector {
+public:
+    explicit EndpointDetector(const EndpointOptions& options);
+
+    /**
+     * Feed captured samples (any count); returns the state after the last complete frame
+     */
+    EndpointState process(const int16_t* pcm, size_t n_samples);
+
+    void reset();
+
+    EndpointState state() const { return state_; }
+    float noise_db() const { return noise_db_; }
+
+private:
+    void process_frame(float energy_db);
+
+    EndpointOptions options_;
+    size_t frame_len_;
+    EndpointState state_ = EndpointState::WAITING;
+
+    // Partial frame carried between process() calls
+    double frame_energy_ = 0.0;
+    size_t frame_fill_ = 0;
+
+    float noise_db_ = 0.0f;
+    int frames_seen_ = 0;
+    int speech_ms_ = 0;
+    int silence_ms_ = 0;
+};
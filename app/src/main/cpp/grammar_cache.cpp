@@ -0,0 +1,53 @@
+#include "grammar_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include "content_hash.h"
+
+#define LOG_TAG "GrammarCache"
+#include "hw_log.h"
+
+std::shared_ptr<const CompiledGrammar> grammar_compile(const std::string& text, const char* root) {
+    auto grammar = std::make_shared<CompiledGrammar>();
+    grammar->hash = content_hash(text.data(), text.size());
+    grammar->state = grammar_parser::parse(text.c_str());
+    if (grammar->state.rules.empty()) {
+        LOGE("Grammar does not parse (%zu chars)", text.size());
+        return nullptr;
+    }
+    auto it = grammar->state.symbol_ids.find(root);
+    if (it == grammar->state.symbol_ids.end()) {
+        LOGE("Grammar has no rule named '%s'", root);
+        return nullptr;
+    }
+    grammar->start_rule = it->second;
+    grammar->rules = grammar->state.c_rules();
+    return grammar;
+}
+
+std::shared_ptr<const CompiledGrammar> GrammarCache::get(const std::string& text) {
+    const uint64_t hash = content_hash(text.data(), text.size());
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [hash](const std::shared_ptr<const CompiledGrammar>& g) { return g->hash == hash; });
+    if (it != entries_.end()) {
+        std::shared_ptr<const CompiledGrammar> grammar = *it;
+        entries_.erase(it);
+        entries_.push_back(grammar);
+        return grammar;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<const CompiledGrammar> grammar = grammar_compile(text);
+    if (!grammar) {
+        return nullptr;
+    }
+    compiles_++;
+    LOGI("Compiled grammar: %zu rules in %.2f ms", grammar->rules.size(),
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    if (entries_.size() >= capacity_) {
+        entries_.erase(entries_.begin());
+    }
+    entries_.push_back(grammar);
+    return grammar;
+}
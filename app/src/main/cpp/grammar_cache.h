@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "whisper.h"
+#include "grammar-parser.h"
+
+/**
+ * Compiled GBNF grammars for constrained decoding
+ *
+ * whisper_full takes a grammar as parsed rule arrays (grammar_rules /
+ * i_start_rule). Parsing the GBNF text is cheap but not free, and the same
+ * few grammars (voice commands, per-field input types) are used for a whole
+ * session, so they are compiled once and shared by every transcription.
+ */
+
+struct CompiledGrammar {
+    uint64_t hash = 0;  // content_hash of the GBNF source
+    grammar_parser::parse_state state;
+    std::vector<const whisper_grammar_element*> rules;  // Points into state.rules
+    size_t start_rule = 0;
+
+    CompiledGrammar() = default;
+    CompiledGrammar(const CompiledGrammar&) = delete;
+    CompiledGrammar& operator=(const CompiledGrammar&) = delete;
+};
+
+/**
+ * Parse GBNF text; null when it does not parse or has no rule named root
+ */
+std::shared_ptr<const CompiledGrammar> grammar_compile(const std::string& text, const char* root = "root");
+
+/**
+ * Most recently used compiled grammars, keyed by source hash
+ * Not thread-safe; callers serialize access.
+ */
+class GrammarCache {
+public:
+    static constexpr size_t kDefaultCapacity = 8;
+
+    explicit GrammarCache(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    /**
+     * Compiled form of text, compiling it only on first use; null on a parse error
+     */
+    std::shared_ptr<const CompiledGrammar> get(const std::string& text);
+
+    void clear() { entries_.clear(); }
+
+    uint64_t compiles() const { return compiles_; }
+
+private:
+    size_t capacity_;
+    std::vector<std::shared_ptr<const CompiledGrammar>> entries_;  // Most recent last
+    uint64_t compiles_ = 0;
+};
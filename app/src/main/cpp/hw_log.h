@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * Logging shim for the native core
+ * Logs go to logcat on Android and to stderr on host builds.
+ * Each source file defines LOG_TAG before including this header.
+ */
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#else
+
+#include <cstdarg>
+#include <cstdio>
+
+// Host tools silence info logs so their stdout/stderr stays readable
+inline bool g_hw_log_verbose = true;
+
+inline void hw_log_set_verbose(bool verbose) {
+    g_hw_log_verbose = verbose;
+}
+
+__attribute__((format(printf, 3, 4)))
+inline void hw_log_print(char level, const char* tag, const char* fmt, ...) {
+    if (level == 'I' && !g_hw_log_verbose) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%c/%s: ", level, tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+#define LOGI(...) hw_log_print('I', LOG_TAG, __VA_ARGS__)
+#define LOGW(...) hw_log_print('W', LOG_TAG, __VA_ARGS__)
+#define LOGE(...) hw_log_print('E', LOG_TAG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,416 @@
+#include "incremental_mel.h"
+
+#include <algorithm>
+#include <cmath>
+#include "audio_kernels.h"
+
+#define LOG_TAG "IncrementalMel"
+#include "hw_log.h"
+
+namespace {
+
+constexpr size_t kPad = IncrementalMel::kFrameSize / 2; // Reflective padding before the first frame
+constexpr float kLogFloor = -10.0f;                     // log10(1e-10), whisper's floor for silence
+constexpr size_t kTailPadFrames = 3000;                 // 30 s, as whisper_pcm_to_mel pads
+
+// Slaney mel scale (librosa default, which produced whisper's mel_filters.npz)
+constexpr double kMinLogHz = 1000.0;
+constexpr double kLinearStep = 200.0 / 3.0;
+constexpr double kMinLogMel = kMinLogHz / kLinearStep;
+
+double hz_to_mel(double hz) {
+    static const double log_step = std::log(6.4) / 27.0;
+    return hz < kMinLogHz ? hz / kLinearStep : kMinLogMel + std::log(hz / kMinLogHz) / log_step;
+}
+
+double mel_to_hz(double mel) {
+    static const double log_step = std::log(6.4) / 27.0;
+    return mel < kMinLogMel ? mel * kLinearStep : kMinLogHz * std::exp(log_step * (mel - kMinLogMel));
+}
+
+/**
+ * librosa.filters.mel(sr, n_fft, n_mels, htk=False, norm="slaney") as a dense n_mels x (n_fft/2 + 1) matrix
+ */
+std::vector<float> slaney_filters(int n_mels, size_t n_fft, int sample_rate) {
+    const size_t n_bins = n_fft / 2 + 1;
+    const double max_mel = hz_to_mel(sample_rate / 2.0);
+    std::vector<double> edges(n_mels + 2);
+    for (int i = 0; i < n_mels + 2; i++) {
+        edges[i] = mel_to_hz(max_mel * i / (n_mels + 1));
+    }
+
+    std::vector<float> filters(static_cast<size_t>(n_mels) * n_bins, 0.0f);
+    for (int m = 0; m < n_mels; m++) {
+        const double enorm = 2.0 / (edges[m + 2] - edges[m]);
+        for (size_t k = 0; k < n_bins; k++) {
+            const double f = static_cast<double>(k) * sample_rate / n_fft;
+            const double lower = (f - edges[m]) / (edges[m + 1] - edges[m]);
+            const double upper = (edges[m + 2] - f) / (edges[m + 2] - edges[m + 1]);
+            const double w = std::max(0.0, std::min(lower, upper));
+            filters[m * n_bins + k] = static_cast<float>(w * enorm);
+        }
+    }
+    return filters;
+}
+
+} // namespace
+
+// ---- RealFft -----------------------------------------------------------------
+
+RealFft::RealFft(size_t n) : n_(n), half_(n / 2) {
+    // Factor the half size, larger radices first so the last stages have long contiguous runs
+    size_t rest = half_;
+    std::vector<size_t> radices;
+    for (size_t r : {5, 4, 3, 2}) {
+        while (rest % r == 0 && rest > 1) {
+            radices.push_back(r);
+            rest /= r;
+        }
+    }
+    if (rest != 1) {
+        // Only sizes of the form 2^a 3^b 5^c are supported; whisper's 400 is 2^4 5^2
+        LOGE("RealFft: unsupported size %zu", n);
+        half_ = 0;
+        return;
+    }
+
+    size_t span = 1;
+    for (size_t r : radices) {
+        Stage stage;
+        stage.radix = r;
+        stage.span = span;
+        stage.tw_re.resize((r - 1) * span);
+        stage.tw_im.resize((r - 1) * span);
+        stage.root_re.resize(r);
+        stage.root_im.resize(r);
+        for (size_t q = 0; q < r; q++) {
+            const double angle = -2.0 * M_PI * static_cast<double>(q) / static_cast<double>(r);
+            stage.root_re[q] = static_cast<float>(std::cos(angle));
+            stage.root_im[q] = static_cast<float>(std::sin(angle));
+        }
+        for (size_t q = 1; q < r; q++) {
+            for (size_t j = 0; j < span; j++) {
+                const double angle = -2.0 * M_PI * static_cast<double>(q * j) / static_cast<double>(span * r);
+                stage.tw_re[(q - 1) * span + j] = static_cast<float>(std::cos(angle));
+                stage.tw_im[(q - 1) * span + j] = static_cast<float>(std::sin(angle));
+            }
+        }
+        stages_.push_back(std::move(stage));
+        span *= r;
+    }
+
+    unpack_re_.resize(half_ + 1);
+    unpack_im_.resize(half_ + 1);
+    for (size_t k = 0; k <= half_; k++) {
+        const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(n_);
+        unpack_re_[k] = static_cast<float>(std::cos(angle));
+        unpack_im_[k] = static_cast<float>(std::sin(angle));
+    }
+
+    a_re_.resize(half_);
+    a_im_.resize(half_);
+    b_re_.resize(half_);
+    b_im_.resize(half_);
+}
+
+void RealFft::forward(const float* in, float* re, float* im) {
+    if (half_ == 0) {
+        return;
+    }
+
+    // Pack even/odd samples as one complex sequence of half the length
+    for (size_t i = 0; i < half_; i++) {
+        a_re_[i] = in[2 * i];
+        a_im_[i] = in[2 * i + 1];
+    }
+
+    float* x_re = a_re_.data();
+    float* x_im = a_im_.data();
+    float* y_re = b_re_.data();
+    float* y_im = b_im_.data();
+    for (const Stage& stage : stages_) {
+        const size_t r = stage.radix;
+        const size_t span = stage.span;
+        const size_t stride = half_ / r;
+        float v_re[5], v_im[5];
+
+        // Stockham step: y[(k*r + q)*span + j] = sum_p w^(p*q) * tw(p, j) * x[k*span + j + p*stride]
+        for (size_t k = 0; k < stride / span; k++) {
+            for (size_t j = 0; j < span; j++) {
+                const size_t src = k * span + j;
+                const size_t dst = k * span * r + j;
+                if (r == 2) {
+                    const float t_re = x_re[src + stride] * stage.tw_re[j] - x_im[src + stride] * stage.tw_im[j];
+                    const float t_im = x_re[src + stride] * stage.tw_im[j] + x_im[src + stride] * stage.tw_re[j];
+                    y_re[dst] = x_re[src] + t_re;
+                    y_im[dst] = x_im[src] + t_im;
+                    y_re[dst + span] = x_re[src] - t_re;
+                    y_im[dst + span] = x_im[src] - t_im;
+                    continue;
+                }
+
+                v_re[0] = x_re[src];
+                v_im[0] = x_im[src];
+                for (size_t p = 1; p < r; p++) {
+                    const float w_re = stage.tw_re[(p - 1) * span + j];
+                    const float w_im = stage.tw_im[(p - 1) * span + j];
+                    const float s_re = x_re[src + p * stride];
+                    const float s_im = x_im[src + p * stride];
+                    v_re[p] = s_re * w_re - s_im * w_im;
+                    v_im[p] = s_re * w_im + s_im * w_re;
+                }
+                for (size_t q = 0; q < r; q++) {
+                    float sum_re = 0.0f, sum_im = 0.0f;
+                    for (size_t p = 0; p < r; p++) {
+                        const float c = stage.root_re[(p * q) % r];
+                        const float s = stage.root_im[(p * q) % r];
+                        sum_re += v_re[p] * c - v_im[p] * s;
+                        sum_im += v_re[p] * s + v_im[p] * c;
+                    }
+                    y_re[dst + q * span] = sum_re;
+                    y_im[dst + q * span] = sum_im;
+                }
+            }
+        }
+        std::swap(x_re, y_re);
+        std::swap(x_im, y_im);
+    }
+
+    // Split into the spectrum of the real input: X[k] = E[k] + e^(-2*pi*i*k/n) * O[k]
+    for (size_t k = 0; k <= half_; k++) {
+        const size_t a = k % half_;
+        const size_t b = (half_ - k) % half_;
+        const float e_re = 0.5f * (x_re[a] + x_re[b]);
+        const float e_im = 0.5f * (x_im[a] - x_im[b]);
+        const float o_re = 0.5f * (x_im[a] + x_im[b]);
+        const float o_im = -0.5f * (x_re[a] - x_re[b]);
+        re[k] = e_re + unpack_re_[k] * o_re - unpack_im_[k] * o_im;
+        im[k] = e_im + unpack_re_[k] * o_im + unpack_im_[k] * o_re;
+    }
+}
+
+// ---- IncrementalMel ----------------------------------------------------------
+
+IncrementalMel::IncrementalMel(int n_mels)
+    : n_mels_(n_mels), fft_(kFrameSize) {
+    // Periodic Hann, as whisper.cpp and torch.stft use
+    window_.resize(kFrameSize);
+    for (size_t i = 0; i < kFrameSize; i++) {
+        window_[i] = static_cast<float>(0.5 * (1.0 - std::cos(2.0 * M_PI * i / kFrameSize)));
+    }
+
+    const size_t n_bins = kFrameSize / 2 + 1;
+    filters_ = slaney_filters(n_mels, kFrameSize, kSampleRate);
+    filter_begin_.assign(n_mels, 0);
+    filter_end_.assign(n_mels, 0);
+    for (int m = 0; m < n_mels; m++) {
+        const float* row = filters_.data() + static_cast<size_t>(m) * n_bins;
+        size_t begin = 0;
+        while (begin < n_bins && row[begin] == 0.0f) begin++;
+        size_t end = n_bins;
+        while (end > begin && row[end - 1] == 0.0f) end--;
+        filter_begin_[m] = begin;
+        filter_end_[m] = end;
+    }
+
+    buf_.resize(kFrameSize);
+    re_.resize(n_bins);
+    im_.resize(n_bins);
+    power_.resize(n_bins);
+}
+
+void IncrementalMel::log_mel(const float* frame, float* out) const {
+    for (size_t i = 0; i < kFrameSize; i++) {
+        buf_[i] = frame[i] * window_[i];
+    }
+    fft_.forward(buf_.data(), re_.data(), im_.data());
+    power_spectrum(re_.data(), im_.data(), power_.data(), power_.size());
+
+    // Each Slaney filter only covers a few bins, so only its support is summed
+    const size_t n_bins = power_.size();
+    for (int m = 0; m < n_mels_; m++) {
+        const float* row = filters_.data() + static_cast<size_t>(m) * n_bins;
+        float sum = 0.0f;
+        for (size_t k = filter_begin_[m]; k < filter_end_[m]; k++) {
+            sum += row[k] * power_[k];
+        }
+        out[m] = std::log10(std::max(sum, 1e-10f));
+    }
+}
+
+void IncrementalMel::compute_frame(const float* frame) {
+    frames_.resize(frames_.size() + static_cast<size_t>(n_mels_));
+    log_mel(frame, frames_.data() + n_frames_ * n_mels_);
+    n_frames_++;
+}
+
+void IncrementalMel::push(const int16_t* pcm, size_t n_samples) {
+    if (finished_ || n_samples == 0) {
+        return;
+    }
+    samples_.insert(samples_.end(), pcm, pcm + n_samples);
+    const size_t old = pending_.size();
+    pending_.resize(old + n_samples);
+    pcm16_to_float(pcm, pending_.data() + old, n_samples);
+    n_samples_ += n_samples;
+
+    // The first frame needs kPad samples of reflected history: pending_ becomes padded[0..]
+    if (!started_) {
+        if (pending_.size() <= kPad) {
+            return;
+        }
+        std::vector<float> padded(kPad);
+        std::reverse_copy(pending_.begin() + 1, pending_.begin() + 1 + kPad, padded.begin());
+        pending_.insert(pending_.begin(), padded.begin(), padded.end());
+        pending_origin_ = 0;
+        started_ = true;
+    }
+
+    // Frame i covers padded[i * step, i * step + size)
+    size_t consumed = 0;
+    while (n_frames_ * kFrameStep + kFrameSize <= pending_origin_ + pending_.size()) {
+        const size_t offset = n_frames_ * kFrameStep - pending_origin_;
+        compute_frame(pending_.data() + offset);
+        consumed = offset + kFrameStep;
+    }
+    if (consumed > 0) {
+        pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(consumed));
+        pending_origin_ += consumed;
+    }
+}
+
+void IncrementalMel::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    if (!started_) {
+        // Shorter than the reflection pad: reflect what there is
+        const size_t reflect = pending_.size() > 1 ? pending_.size() - 1 : 0;
+        std::vector<float> padded(kPad, 0.0f);
+        if (reflect > 0) {
+            std::reverse_copy(pending_.begin() + 1, pending_.begin() + 1 + static_cast<std::ptrdiff_t>(reflect),
+                              padded.begin() + static_cast<std::ptrdiff_t>(kPad - reflect));
+        }
+        pending_.insert(pending_.begin(), padded.begin(), padded.end());
+        pending_origin_ = 0;
+        started_ = true;
+    }
+
+    // Every frame centred inside the recording, against zero padding
+    const size_t last_frame = n_samples_ / kFrameStep;
+    const size_t needed = (last_frame + 1) * kFrameStep + kFrameSize;
+    if (pending_origin_ + pending_.size() < needed) {
+        pending_.resize(needed - pending_origin_, 0.0f);
+    }
+    while (n_frames_ <= last_frame) {
+        compute_frame(pending_.data() + (n_frames_ * kFrameStep - pending_origin_));
+    }
+    pending_.clear();
+    pending_.shrink_to_fit();
+    LOGI("Finished %zu frames for %zu samples", n_frames_, n_samples_);
+}
+
+void IncrementalMel::packed_pcm(const std::vector<MelRange>& ranges, const std::vector<size_t>& starts,
+                                size_t begin, size_t count, float* dst) const {
+    const size_t end = begin + count;
+    size_t pos = begin;
+    size_t r = static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), pos) - starts.begin());
+    r = r > 0 ? r - 1 : 0;
+    while (pos < end) {
+        if (r == ranges.size()) {
+            std::fill(dst + (pos - begin), dst + count, 0.0f);
+            break;
+        }
+        const size_t range_end = starts[r] + (ranges[r].end - ranges[r].start);
+        if (pos < starts[r]) {
+            // Gap before range r
+            const size_t n = std::min(end, starts[r]) - pos;
+            std::fill(dst + (pos - begin), dst + (pos - begin) + n, 0.0f);
+            pos += n;
+        } else if (pos < range_end) {
+            const size_t n = std::min(end, range_end) - pos;
+            const size_t source = ranges[r].start + (pos - starts[r]);
+            const size_t available = source < samples_.size() ? std::min(n, samples_.size() - source) : 0;
+            pcm16_to_float(samples_.data() + source, dst + (pos - begin), available);
+            std::fill(dst + (pos - begin) + available, dst + (pos - begin) + n, 0.0f);
+            pos += n;
+        } else {
+            r++;
+        }
+    }
+}
+
+void IncrementalMel::build(const std::vector<MelRange>& ranges, size_t gap_samples,
+                           std::vector<float>& out, int& n_len, size_t& n_audio_samples) const {
+    // Packed start of every range in the joined timeline
+    std::vector<size_t> starts(ranges.size());
+    n_audio_samples = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        n_audio_samples += i > 0 ? gap_samples : 0;
+        starts[i] = n_audio_samples;
+        n_audio_samples += ranges[i].end - ranges[i].start;
+    }
+
+    // Same frame count as whisper_pcm_to_mel: the audio plus 30 s of zeros, one frame per hop
+    const size_t total = n_audio_samples / kFrameStep + kTailPadFrames;
+    n_len = static_cast<int>(total);
+    out.assign(static_cast<size_t>(n_mels_) * total, kLogFloor);
+    if (n_audio_samples == 0) {
+        return;
+    }
+
+    // Output frame o covers joined samples [o * step - kPad, o * step + kPad), reflected before 0
+    // like whisper_pcm_to_mel; frames past the audio stay silent
+    const size_t n_frames = std::min(total, (n_audio_samples + kPad - 1) / kFrameStep + 1);
+    std::vector<float> window(kFrameSize);
+    std::vector<float> head(kPad + 1);
+    std::vector<float> mel(n_mels_);
+    size_t range = 0;
+    size_t copied = 0;
+    float mmax = kLogFloor;
+    for (size_t o = 0; o < n_frames; o++) {
+        const size_t centre = o * kFrameStep;
+        while (range + 1 < ranges.size() && centre >= starts[range + 1]) {
+            range++;
+        }
+
+        // A frame the recording already has: same window, same samples (or the same reflection at sample 0)
+        const float* src = nullptr;
+        const size_t range_end = starts[range] + (ranges[range].end - ranges[range].start);
+        if (centre >= starts[range] && centre + kPad < range_end &&
+            (centre >= starts[range] + kPad || (starts[range] == 0 && ranges[range].start == 0))) {
+            const size_t source = ranges[range].start + (centre - starts[range]);
+            if (source % kFrameStep == 0 && source / kFrameStep < n_frames_) {
+                src = frames_.data() + (source / kFrameStep) * n_mels_;
+                copied++;
+            }
+        }
+        if (src == nullptr) {
+            if (centre >= kPad) {
+                packed_pcm(ranges, starts, centre - kPad, kFrameSize, window.data());
+            } else {
+                const size_t reflect = kPad - centre;
+                packed_pcm(ranges, starts, 0, kFrameSize - reflect, window.data() + reflect);
+                packed_pcm(ranges, starts, 0, reflect + 1, head.data());
+                for (size_t i = 0; i < reflect; i++) {
+                    window[i] = head[reflect - i];
+                }
+            }
+            log_mel(window.data(), mel.data());
+            src = mel.data();
+        }
+        for (int m = 0; m < n_mels_; m++) {
+            out[static_cast<size_t>(m) * total + o] = src[m];
+            mmax = std::max(mmax, src[m]);
+        }
+    }
+    LOGI("Built %zu frames (%zu copied) from %zu ranges", n_frames, copied, ranges.size());
+
+    // whisper's normalization: clamp to 8 (log10) below the maximum, then scale
+    const float floor = mmax - 8.0f;
+    for (float& v : out) {
+        v = (std::max(v, floor) + 4.0f) / 4.0f;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Incremental log-mel front-end
+ *
+ * Computes whisper's log-mel frames (400-point STFT, 160-sample hop, Slaney
+ * mel filters) while PCM is still being recorded, so only frame selection and
+ * normalization remain after the user presses stop. The finished spectrogram
+ * is handed to whisper with whisper_set_mel instead of passing samples to
+ * whisper_full.
+ */
+
+/**
+ * Real-input FFT of even size n via a half-size complex Stockham FFT
+ * (mixed radix 2/3/4/5, structure-of-arrays so the butterflies vectorize)
+ */
+class RealFft {
+public:
+    explicit RealFft(size_t n);
+
+    /**
+     * Spectrum bins 0..n/2 of in (n samples) into re/im (n/2 + 1 values each)
+     */
+    void forward(const float* in, float* re, float* im);
+
+    size_t size() const { return n_; }
+
+private:
+    struct Stage {
+        size_t radix;
+        size_t span;               // Product of the radices of earlier stages
+        std::vector<float> tw_re;  // (radix - 1) * span twiddles
+        std::vector<float> tw_im;
+        std::vector<float> root_re;  // radix-point DFT roots
+        std::vector<float> root_im;
+    };
+
+    size_t n_;
+    size_t half_;
+    std::vector<Stage> stages_;
+    std::vector<float> unpack_re_;  // e^(-2*pi*i*k/n) for the real-to-complex split
+    std::vector<float> unpack_im_;
+    std::vector<float> a_re_, a_im_, b_re_, b_im_;
+};
+
+/**
+ * Sample range [start, end) of the recording that whisper will see
+ */
+struct MelRange {
+    size_t start = 0;
+    size_t end = 0;
+};
+
+class IncrementalMel {
+public:
+    static constexpr int kSampleRate = 16000;
+    static constexpr size_t kFrameSize = 400;
+    static constexpr size_t kFrameStep = 160;
+
+    explicit IncrementalMel(int n_mels = 80);
+
+    /**
+     * Append captured samples and compute every frame that is now complete
+     */
+    void push(const int16_t* pcm, size_t n_samples);
+
+    /**
+     * End of recording: compute the trailing frames against zero padding
+     */
+    void finish();
+
+    int n_mels() const { return n_mels_; }
+    size_t n_samples() const { return n_samples_; }
+    bool finished() const { return finished_; }
+
+    /**
+     * Build a whisper mel (mel-major, n_mels x n_len) for the given recording ranges
+     * joined by gap_samples of silence, plus 30 s of trailing padding like
+     * whisper_pcm_to_mel. Frames whose window lies inside one range at a 10 ms hop of the
+     * recording are copied; the rest (range edges, gaps, unaligned ranges) are computed from
+     * the recorded samples, so the result matches whisper_pcm_to_mel on the joined PCM.
+     * n_audio_samples receives the joined length (for whisper_full_params.duration_ms).
+     */
+    void build(const std::vector<MelRange>& ranges, size_t gap_samples,
+               std::vector<float>& out, int& n_len, size_t& n_audio_samples) const;
+
+private:
+    void compute_frame(const float* frame);
+
+    /**
+     * Raw log10 mel of one kFrameSize window into out (n_mels values)
+     */
+    void log_mel(const float* frame, float* out) const;
+
+    /**
+     * Joined samples [begin, begin + count) into dst: ranges (packed at starts) with silent gaps and zeros past the end
+     */
+    void packed_pcm(const std::vector<MelRange>& ranges, const std::vector<size_t>& starts,
+                    size_t begin, size_t count, float* dst) const;
+
+    int n_mels_;
+    std::vector<float> window_;
+    std::vector<float> filters_;          // n_mels x n_bins (dense, zero outside [begin, end))
+    std::vector<size_t> filter_begin_;
+    std::vector<size_t> filter_end_;
+
+    std::vector<float> pending_;          // Samples not yet consumed by a frame (incl. 200 of history)
+    size_t pending_origin_ = 0;           // Recording index of pending_[0] (may be "negative" via reflection)
+    bool started_ = false;
+    size_t n_samples_ = 0;
+    size_t n_frames_ = 0;
+    bool finished_ = false;
+    std::vector<float> frames_;           // Raw log10 mel, frame-major (n_frames x n_mels)
+    std::vector<int16_t> samples_;        // The recording, for frames build cannot copy
+
+    // FFT scratch, shared by push and build
+    mutable RealFft fft_;
+    mutable std::vector<float> buf_, re_, im_, power_;
+};
@@ -0,0 +1,49 @@
+#include "input_field.h"
+
+namespace {
+
+// whisper starts text tokens with a space, so every grammar allows one up front.
+// Suppression regexes match whole tokens that contain a character the field can't hold.
+
+const char* const kNumberGrammar = R"(
+root ::= " "? "-"? [0-9]+ ([.,] [0-9]+)*
+)";
+
+const char* const kPhoneGrammar = R"(
+root ::= " "? "+"? [0-9(] [0-9() .-]*
+)";
+
+const char* const kEmailGrammar = R"(
+root   ::= " "? local "@" domain
+local  ::= [a-zA-Z0-9_%+-]+ ("." [a-zA-Z0-9_%+-]+)*
+domain ::= label ("." label)+
+label  ::= [a-zA-Z0-9-]+
+)";
+
+const char* const kUrlGrammar = R"(
+root   ::= " "? (("https" | "http") "://")? domain path?
+domain ::= label ("." label)+
+label  ::= [a-zA-Z0-9-]+
+path   ::= "/" [a-zA-Z0-9._~%/?#=&+-]*
+)";
+
+const InputFieldConstraints kConstraints[] = {
+    {nullptr, nullptr, 0},
+    {kNumberGrammar, ".*[^0-9 .,-].*", 16},
+    {kPhoneGrammar, ".*[^0-9 ()+.-].*", 24},
+    {kEmailGrammar, ".*\\S.*\\s.*", 32},
+    {kUrlGrammar, ".*\\S.*\\s.*", 48},
+};
+
+} // namespace
+
+const InputFieldConstraints& input_field_constraints(InputFieldType type) {
+    return kConstraints[static_cast<int>(input_field_type_from_int(static_cast<int>(type)))];
+}
+
+InputFieldType input_field_type_from_int(int value) {
+    if (value < static_cast<int>(InputFieldType::Text) || value > static_cast<int>(InputFieldType::Url)) {
+        return InputFieldType::Text;
+    }
+    return static_cast<InputFieldType>(value);
+}
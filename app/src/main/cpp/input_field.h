@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * Decoding constraints derived from the kind of field being dictated into
+ *
+ * Numeric, phone, email and URL fields only accept a narrow character set, so
+ * instead of decoding free text and cleaning it up afterwards the transcription
+ * runs under a grammar for the field (start rule "root"), with tokens that can
+ * never fit suppressed outright and a token cap sized for such values.
+ */
+
+enum class InputFieldType : int {
+    Text = 0,
+    Number = 1,
+    Phone = 2,
+    Email = 3,
+    Url = 4,
+};
+
+struct InputFieldConstraints {
+    const char* grammar = nullptr;         // GBNF; null for free text
+    const char* suppress_regex = nullptr;  // Tokens matching it are never sampled; null for none
+    int max_tokens = 0;                    // Per-segment cap (0 = no cap)
+};
+
+/**
+ * Constraints for type; out-of-range values are treated as free text
+ */
+const InputFieldConstraints& input_field_constraints(InputFieldType type);
+
+/**
+ * Field type for a value coming over JNI or the command line
+ */
+InputFieldType input_field_type_from_int(int value);
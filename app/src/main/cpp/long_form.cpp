@@ -0,0 +1,113 @@
+#include "long_form.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+#define LOG_TAG "LongForm"
+#include "hw_log.h"
+
+namespace {
+
+constexpr float kProbeMs = 100.0f;
+
+std::vector<std::string> comparable_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text) {
+        if (std::isspace(c)) {
+            if (!word.empty()) {
+                words.push_back(word);
+                word.clear();
+            }
+        } else if (std::isalnum(c) || c >= 0x80) {
+            word += static_cast<char>(std::tolower(c));
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+} // namespace
+
+std::vector<AudioChunk> plan_chunks(const float* pcm, size_t n_samples, int sample_rate, const ChunkOptions& options) {
+    std::vector<AudioChunk> chunks;
+    const size_t target = static_cast<size_t>(options.target_s * sample_rate);
+    const size_t search = std::min(target / 2, static_cast<size_t>(options.search_s * sample_rate));
+    const size_t overlap = static_cast<size_t>(options.overlap_s * sample_rate);
+    const size_t probe = std::max<size_t>(1, static_cast<size_t>(kProbeMs * sample_rate / 1000.0f));
+
+    size_t start = 0;
+    bool overlaps_prev = false;
+    while (n_samples - start > target) {
+        // Quietest probe window in [start + target - search, start + target)
+        const size_t lo = start + target - search;
+        const size_t hi = start + target - probe;
+        size_t best = hi;
+        double best_energy = -1.0;
+        for (size_t pos = lo; pos <= hi; pos += probe / 2) {
+            double energy = 0.0;
+            for (size_t i = 0; i < probe; i++) {
+                energy += static_cast<double>(pcm[pos + i]) * pcm[pos + i];
+            }
+            if (best_energy < 0.0 || energy <= best_energy) {
+                best_energy = energy;
+                best = pos;
+            }
+        }
+
+        const size_t cut = best + probe / 2;
+        const double mean = best_energy / static_cast<double>(probe);
+        const float level_db = mean > 0.0 ? static_cast<float>(10.0 * std::log10(mean)) : -120.0f;
+        const bool silent = level_db < options.silence_db;
+
+        chunks.push_back({start, cut, overlaps_prev});
+        overlaps_prev = !silent;
+        start = silent ? cut : cut - std::min(overlap, cut - start);
+    }
+    chunks.push_back({start, n_samples, overlaps_prev});
+
+    if (chunks.size() > 1) {
+        LOGI("Split %zu samples into %zu chunks", n_samples, chunks.size());
+    }
+    return chunks;
+}
+
+size_t overlap_word_count(const std::string& prev, const std::string& next, size_t max_words, size_t min_words) {
+    const std::vector<std::string> a = comparable_words(prev);
+    const std::vector<std::string> b = comparable_words(next);
+    const size_t limit = std::min({max_words, a.size(), b.size()});
+    for (size_t k = limit; k >= std::max<size_t>(min_words, 1); k--) {
+        if (std::equal(a.end() - k, a.end(), b.begin())) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+size_t drop_leading_words(std::string& text, size_t n) {
+    size_t pos = 0;
+    size_t dropped = 0;
+    while (dropped < n) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+        if (pos >= text.size()) {
+            break;
+        }
+        // Punctuation-only tokens are not words for comparable_words, so they don't count
+        bool is_word = false;
+        while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos]))) {
+            const unsigned char c = static_cast<unsigned char>(text[pos]);
+            is_word = is_word || std::isalnum(c) || c >= 0x80;
+            pos++;
+        }
+        if (is_word) {
+            dropped++;
+        }
+    }
+    text.erase(0, pos);
+    return dropped;
+}
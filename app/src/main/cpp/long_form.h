@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Long-form chunking for parallel transcription
+ *
+ * Recordings longer than one whisper window are split at the quietest point
+ * near each window boundary so chunks can be decoded concurrently on separate
+ * whisper_states. Cuts that do not land on silence overlap the next chunk,
+ * and the repeated words are removed again when results are merged.
+ */
+
+struct ChunkOptions {
+    float target_s = 28.0f;      // Preferred chunk length (stays inside the 30 s window)
+    float search_s = 8.0f;       // Look this far back from the target for a quiet cut point
+    float overlap_s = 1.0f;      // Overlap added when the cut is not silent
+    float silence_db = -45.0f;   // Cut windows quieter than this need no overlap
+};
+
+/**
+ * Half-open sample range [start, end)
+ */
+struct AudioChunk {
+    size_t start = 0;
+    size_t end = 0;
+    bool overlaps_prev = false;  // Starts before the previous chunk's end
+};
+
+/**
+ * Split pcm into chunks of at most target_s (+ overlap); a single chunk when it already fits
+ */
+std::vector<AudioChunk> plan_chunks(const float* pcm, size_t n_samples, int sample_rate, const ChunkOptions& options);
+
+/**
+ * Number of leading words of next that repeat the trailing words of prev
+ * (case and punctuation insensitive, at most max_words)
+ * Matches shorter than min_words count as 0: a single word said twice across a cut
+ * ("that that", "no no") is more likely speech than overlap.
+ */
+size_t overlap_word_count(const std::string& prev, const std::string& next, size_t max_words = 12,
+                          size_t min_words = 2);
+
+/**
+ * Remove the first n whitespace-separated words from text
+ * Returns the number of words actually removed
+ */
+size_t drop_leading_words(std::string& text, size_t n);
@@ -0,0 +1,110 @@
+#include "model_header.h"
+
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t kGgmlMagic = 0x67676d6c;     // "ggml"
+constexpr int32_t kQntVersionFactor = 1000;    // ftype field = version * 1000 + type
+
+// Vocabulary of the English-only models, of the multilingual ones, and of large-v3 (one more language)
+constexpr int32_t kMinVocab = 51864;
+constexpr int32_t kMaxVocab = 51866;
+
+// whisper.cpp decodes 30 s windows (1500 encoder frames) and at most 448 text positions
+constexpr int32_t kAudioCtx = 1500;
+constexpr int32_t kMaxTextCtx = 448;
+constexpr int32_t kMaxLayers = 64;
+
+// Encoder depth of the released sizes, which distilled checkpoints keep
+struct EncoderSize {
+    int32_t n_layer;
+    const char* name;
+};
+
+const EncoderSize kEncoderSizes[] = {
+    {4, "tiny"},
+    {6, "base"},
+    {12, "small"},
+    {24, "medium"},
+    {32, "large"},
+};
+
+bool check_heads(int32_t n_state, int32_t n_head) {
+    return n_state > 0 && n_head > 0 && n_state % n_head == 0;
+}
+
+} // namespace
+
+bool model_hparams_read(const char* model_path, ModelHparams& out) {
+    out = ModelHparams();
+    FILE* f = fopen(model_path, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    uint32_t magic = 0;
+    int32_t fields[11] = {};
+    const bool ok = fread(&magic, sizeof(magic), 1, f) == 1 && magic == kGgmlMagic &&
+                    fread(fields, sizeof(fields), 1, f) == 1;
+    fclose(f);
+    if (!ok) {
+        return false;
+    }
+
+    out.n_vocab = fields[0];
+    out.n_audio_ctx = fields[1];
+    out.n_audio_state = fields[2];
+    out.n_audio_head = fields[3];
+    out.n_audio_layer = fields[4];
+    out.n_text_ctx = fields[5];
+    out.n_text_state = fields[6];
+    out.n_text_head = fields[7];
+    out.n_text_layer = fields[8];
+    out.n_mels = fields[9];
+    out.ftype = fields[10] % kQntVersionFactor;
+    return true;
+}
+
+bool model_hparams_validate(const ModelHparams& hparams, std::string& error) {
+    char buf[128];
+    if (hparams.n_vocab < kMinVocab || hparams.n_vocab > kMaxVocab) {
+        snprintf(buf, sizeof(buf), "unexpected vocabulary size %d", hparams.n_vocab);
+    } else if (hparams.n_mels != 80 && hparams.n_mels != 128) {
+        snprintf(buf, sizeof(buf), "unsupported mel bins %d (80 or 128)", hparams.n_mels);
+    } else if (hparams.n_audio_ctx != kAudioCtx) {
+        snprintf(buf, sizeof(buf), "audio context %d, expected %d (30 s windows)", hparams.n_audio_ctx, kAudioCtx);
+    } else if (hparams.n_text_ctx < 1 || hparams.n_text_ctx > kMaxTextCtx) {
+        snprintf(buf, sizeof(buf), "text context %d out of range", hparams.n_text_ctx);
+    } else if (hparams.n_audio_layer < 1 || hparams.n_audio_layer > kMaxLayers ||
+               hparams.n_text_layer < 1 || hparams.n_text_layer > kMaxLayers) {
+        snprintf(buf, sizeof(buf), "layer counts %d/%d out of range", hparams.n_audio_layer, hparams.n_text_layer);
+    } else if (!check_heads(hparams.n_audio_state, hparams.n_audio_head) ||
+               !check_heads(hparams.n_text_state, hparams.n_text_head)) {
+        snprintf(buf, sizeof(buf), "state width not divisible by heads (%d/%d, %d/%d)", hparams.n_audio_state,
+                 hparams.n_audio_head, hparams.n_text_state, hparams.n_text_head);
+    } else if (hparams.n_audio_state != hparams.n_text_state) {
+        // Cross-attention reads the encoder output at the decoder's width
+        snprintf(buf, sizeof(buf), "encoder width %d differs from decoder width %d", hparams.n_audio_state,
+                 hparams.n_text_state);
+    } else if (hparams.ftype < 0) {
+        snprintf(buf, sizeof(buf), "invalid tensor type %d", hparams.ftype);
+    } else {
+        return true;
+    }
+    error = buf;
+    return false;
+}
+
+std::string model_hparams_describe(const ModelHparams& hparams) {
+    const char* size = "custom";
+    for (const EncoderSize& s : kEncoderSizes) {
+        if (s.n_layer == hparams.n_audio_layer) {
+            size = s.name;
+        }
+    }
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s encoder (%d layers), %d-layer decoder%s, %d mels, %s, ftype %d", size,
+             hparams.n_audio_layer, hparams.n_text_layer, hparams.reduced_decoder() ? " (distilled)" : "",
+             hparams.n_mels, hparams.n_vocab == kMinVocab ? "English-only" : "multilingual", hparams.ftype);
+    return buf;
+}
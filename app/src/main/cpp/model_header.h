@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Hyperparameters from the header of a whisper.cpp GGML model file
+ *
+ * Besides the tiny/base/small checkpoints the loader accepts distil-whisper and
+ * large-v3-turbo conversions: the encoder of a larger model with a decoder of a
+ * few layers (decoding cost scales with decoder depth), and 128 mel bins for
+ * checkpoints derived from large-v3. The header is checked before whisper sees
+ * the file so a truncated or foreign file fails with a reason instead of
+ * somewhere inside tensor loading.
+ */
+struct ModelHparams {
+    int32_t n_vocab = 0;
+    int32_t n_audio_ctx = 0;
+    int32_t n_audio_state = 0;
+    int32_t n_audio_head = 0;
+    int32_t n_audio_layer = 0;
+    int32_t n_text_ctx = 0;
+    int32_t n_text_state = 0;
+    int32_t n_text_head = 0;
+    int32_t n_text_layer = 0;
+    int32_t n_mels = 0;
+    int32_t ftype = 0;        // Tensor type, without the quantization version
+
+    /**
+     * Decoder shallower than the encoder (distil-whisper, large-v3-turbo)
+     */
+    bool reduced_decoder() const { return n_text_layer < n_audio_layer; }
+};
+
+/**
+ * Read the header of a GGML whisper model; false if the file is unreadable or not GGML
+ */
+bool model_hparams_read(const char* model_path, ModelHparams& out);
+
+/**
+ * Check hparams describe a model this build can run; error receives the reason
+ */
+bool model_hparams_validate(const ModelHparams& hparams, std::string& error);
+
+/**
+ * One-line summary, e.g. "large encoder (32 layers), 4-layer decoder, 128 mels, ftype 1"
+ */
+std::string model_hparams_describe(const ModelHparams& hparams);
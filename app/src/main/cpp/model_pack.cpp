@@ -0,0 +1,378 @@
+#include "model_pack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define LOG_TAG "ModelPack"
+#include "hw_log.h"
+
+namespace {
+
+constexpr uint32_t kGgmlMagic = 0x67676d6c;  // "ggml"
+constexpr int kHparamsCount = 11;
+constexpr int kFtypeIndex = 10;
+constexpr size_t kChunkFloats = 1 << 20;     // 4 MB of f32 per conversion step
+constexpr uint32_t kMaxTokenBytes = 1 << 16;
+
+// Types a pack can use, with the header ftype whisper.cpp maps back to them
+struct PackType {
+    ggml_type type;
+    int32_t ftype;
+};
+
+const PackType kPackTypes[] = {
+    {GGML_TYPE_F32, GGML_FTYPE_ALL_F32},
+    {GGML_TYPE_F16, GGML_FTYPE_MOSTLY_F16},
+    {GGML_TYPE_Q4_0, GGML_FTYPE_MOSTLY_Q4_0},
+    {GGML_TYPE_Q4_1, GGML_FTYPE_MOSTLY_Q4_1},
+    {GGML_TYPE_Q5_0, GGML_FTYPE_MOSTLY_Q5_0},
+    {GGML_TYPE_Q5_1, GGML_FTYPE_MOSTLY_Q5_1},
+    {GGML_TYPE_Q8_0, GGML_FTYPE_MOSTLY_Q8_0},
+    {GGML_TYPE_Q2_K, GGML_FTYPE_MOSTLY_Q2_K},
+    {GGML_TYPE_Q3_K, GGML_FTYPE_MOSTLY_Q3_K},
+    {GGML_TYPE_Q4_K, GGML_FTYPE_MOSTLY_Q4_K},
+    {GGML_TYPE_Q5_K, GGML_FTYPE_MOSTLY_Q5_K},
+    {GGML_TYPE_Q6_K, GGML_FTYPE_MOSTLY_Q6_K},
+};
+
+int32_t ftype_of(ggml_type type) {
+    for (const PackType& t : kPackTypes) {
+        if (t.type == type) {
+            return t.ftype;
+        }
+    }
+    return GGML_FTYPE_UNKNOWN;
+}
+
+ggml_type type_of_ftype(int32_t ftype) {
+    for (const PackType& t : kPackTypes) {
+        if (t.ftype == ftype) {
+            return t.type;
+        }
+    }
+    return GGML_TYPE_COUNT;
+}
+
+bool is_pack_type(int32_t type) {
+    for (const PackType& t : kPackTypes) {
+        if (t.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+using FilePtr = std::unique_ptr<FILE, int (*)(FILE*)>;
+
+FilePtr open_file(const char* path, const char* mode) {
+    return FilePtr(fopen(path, mode), fclose);
+}
+
+bool read_exact(FILE* f, void* data, size_t n) {
+    return n == 0 || fread(data, 1, n, f) == n;
+}
+
+bool write_exact(FILE* f, const void* data, size_t n) {
+    return f == nullptr || n == 0 || fwrite(data, 1, n, f) == n;
+}
+
+/**
+ * Copy (or skip, when out is null) n bytes through buf
+ */
+bool copy_bytes(FILE* in, FILE* out, size_t n, std::vector<uint8_t>& buf) {
+    if (out == nullptr) {
+        return fseek(in, static_cast<long>(n), SEEK_CUR) == 0;
+    }
+    buf.resize(std::max<size_t>(buf.size(), 1 << 20));
+    while (n > 0) {
+        const size_t step = std::min(n, buf.size());
+        if (!read_exact(in, buf.data(), step) || !write_exact(out, buf.data(), step)) {
+            return false;
+        }
+        n -= step;
+    }
+    return true;
+}
+
+bool read_hparams(FILE* in, int32_t hparams[kHparamsCount]) {
+    uint32_t magic = 0;
+    return read_exact(in, &magic, sizeof(magic)) && magic == kGgmlMagic &&
+           read_exact(in, hparams, sizeof(int32_t) * kHparamsCount);
+}
+
+/**
+ * Mel filters and vocabulary between the hparams and the tensors, copied verbatim
+ */
+bool copy_tables(FILE* in, FILE* out, std::vector<uint8_t>& buf) {
+    int32_t mel[2] = {};
+    if (!read_exact(in, mel, sizeof(mel)) || mel[0] <= 0 || mel[1] <= 0 || !write_exact(out, mel, sizeof(mel)) ||
+        !copy_bytes(in, out, sizeof(float) * static_cast<size_t>(mel[0]) * static_cast<size_t>(mel[1]), buf)) {
+        return false;
+    }
+    int32_t n_vocab = 0;
+    if (!read_exact(in, &n_vocab, sizeof(n_vocab)) || n_vocab < 0 || !write_exact(out, &n_vocab, sizeof(n_vocab))) {
+        return false;
+    }
+    for (int32_t i = 0; i < n_vocab; i++) {
+        uint32_t len = 0;
+        if (!read_exact(in, &len, sizeof(len)) || len > kMaxTokenBytes || !write_exact(out, &len, sizeof(len)) ||
+            !copy_bytes(in, out, len, buf)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct TensorHeader {
+    int32_t n_dims = 0;
+    int32_t type = 0;
+    int32_t ne[4] = {1, 1, 1, 1};
+    std::string name;
+
+    int64_t n_rows() const { return static_cast<int64_t>(ne[1]) * ne[2] * ne[3]; }
+    size_t data_bytes(ggml_type as) const { return ggml_row_size(as, ne[0]) * static_cast<size_t>(n_rows()); }
+};
+
+/**
+ * Next tensor header; false at the end of the file (eof set) or on a malformed header
+ */
+bool read_tensor_header(FILE* in, TensorHeader& t, bool& eof) {
+    int32_t fields[3] = {};
+    eof = false;
+    const size_t n = fread(fields, 1, sizeof(fields), in);
+    if (n == 0 && feof(in)) {
+        eof = true;
+        return false;
+    }
+    if (n != sizeof(fields) || fields[0] < 1 || fields[0] > 4 || fields[1] <= 0 || fields[1] > 256 ||
+        !is_pack_type(fields[2])) {
+        return false;
+    }
+    t = TensorHeader();
+    t.n_dims = fields[0];
+    t.type = fields[2];
+    if (!read_exact(in, t.ne, sizeof(int32_t) * t.n_dims)) {
+        return false;
+    }
+    t.name.resize(fields[1]);
+    return read_exact(in, &t.name[0], t.name.size()) && t.ne[0] > 0 && t.n_rows() > 0;
+}
+
+bool write_tensor_header(FILE* out, const TensorHeader& t, ggml_type type) {
+    const int32_t fields[3] = {t.n_dims, static_cast<int32_t>(t.name.size()), static_cast<int32_t>(type)};
+    return write_exact(out, fields, sizeof(fields)) && write_exact(out, t.ne, sizeof(int32_t) * t.n_dims) &&
+           write_exact(out, t.name.data(), t.name.size());
+}
+
+PackGroup classify(const TensorHeader& t) {
+    if (t.name == "decoder.token_embedding.weight") {
+        return PackGroup::Embedding;
+    }
+    if (t.n_dims != 2 || t.name.find("positional_embedding") != std::string::npos) {
+        return PackGroup::Other;
+    }
+    if (t.name.compare(0, 8, "encoder.") == 0) {
+        return PackGroup::Encoder;
+    }
+    if (t.name.compare(0, 8, "decoder.") == 0) {
+        return PackGroup::Decoder;
+    }
+    return PackGroup::Other;
+}
+
+/**
+ * Type whisper.cpp creates t with when the weight matrices are weight_type
+ */
+ggml_type target_type(const TensorHeader& t, PackGroup group, ggml_type weight_type) {
+    const ggml_type source = static_cast<ggml_type>(t.type);
+    if (group == PackGroup::Other) {
+        // Convolutions follow the weights (F32 models) or are F16; everything else is F32 already
+        if (t.n_dims == 3) {
+            return weight_type == GGML_TYPE_F32 ? GGML_TYPE_F32 : GGML_TYPE_F16;
+        }
+        return source;
+    }
+    return t.ne[0] % ggml_blck_size(weight_type) == 0 ? weight_type : source;
+}
+
+/**
+ * Stream one tensor's data from in to out, converting a block of rows at a time
+ */
+bool convert_tensor(FILE* in, FILE* out, const TensorHeader& t, ggml_type to, std::vector<uint8_t>& src_buf,
+                    std::vector<float>& f32_buf, std::vector<uint8_t>& dst_buf) {
+    const ggml_type from = static_cast<ggml_type>(t.type);
+    if (from == to) {
+        return copy_bytes(in, out, t.data_bytes(from), src_buf);
+    }
+
+    const ggml_to_float_t to_float = from == GGML_TYPE_F32 ? nullptr : ggml_get_type_traits(from)->to_float;
+    if (from != GGML_TYPE_F32 && to_float == nullptr) {
+        LOGE("No conversion from %s for %s", ggml_type_name(from), t.name.c_str());
+        return false;
+    }
+    const int64_t n_per_row = t.ne[0];
+    const int64_t rows_per_chunk = std::max<int64_t>(1, static_cast<int64_t>(kChunkFloats) / n_per_row);
+    for (int64_t row = 0; row < t.n_rows(); row += rows_per_chunk) {
+        const int64_t n_rows = std::min(rows_per_chunk, t.n_rows() - row);
+        const size_t n_floats = static_cast<size_t>(n_rows * n_per_row);
+        src_buf.resize(std::max(src_buf.size(), ggml_row_size(from, n_per_row) * n_rows));
+        f32_buf.resize(std::max(f32_buf.size(), n_floats));
+        dst_buf.resize(std::max(dst_buf.size(), ggml_row_size(to, n_per_row) * n_rows));
+        if (!read_exact(in, src_buf.data(), ggml_row_size(from, n_per_row) * n_rows)) {
+            return false;
+        }
+        if (to_float != nullptr) {
+            to_float(src_buf.data(), f32_buf.data(), static_cast<int64_t>(n_floats));
+        } else {
+            memcpy(f32_buf.data(), src_buf.data(), n_floats * sizeof(float));
+        }
+        const size_t written = ggml_quantize_chunk(to, f32_buf.data(), dst_buf.data(), 0, n_rows, n_per_row, nullptr);
+        if (!write_exact(out, dst_buf.data(), written)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string lowercase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+} // namespace
+
+bool PackLayout::loadable() const {
+    if (header_type == GGML_TYPE_COUNT) {
+        return false;
+    }
+    for (int g = 0; g < 3; g++) {
+        if (group_mixed[g] || (group_types[g] != GGML_TYPE_COUNT && group_types[g] != header_type)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool pack_type_from_name(const std::string& name, ggml_type& out) {
+    const std::string wanted = lowercase(name);
+    for (const PackType& t : kPackTypes) {
+        if (lowercase(ggml_type_name(t.type)) == wanted) {
+            out = t.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool model_pack(const char* src_path, const char* dst_path, ggml_type type, PackStats* stats,
+                std::string& error) {
+    PackStats local;
+    PackStats& s = stats != nullptr ? *stats : local;
+    s = PackStats();
+
+    FilePtr in = open_file(src_path, "rb");
+    if (!in) {
+        error = std::string("cannot open ") + src_path;
+        return false;
+    }
+    const std::string part_path = std::string(dst_path) + ".part";
+    FilePtr out = open_file(part_path.c_str(), "wb");
+    if (!out) {
+        error = "cannot create " + part_path;
+        return false;
+    }
+
+    int32_t hparams[kHparamsCount] = {};
+    std::vector<uint8_t> src_buf;
+    std::vector<float> f32_buf;
+    std::vector<uint8_t> dst_buf;
+    bool ok = read_hparams(in.get(), hparams);
+    if (ok) {
+        hparams[kFtypeIndex] = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ftype_of(type);
+        ok = write_exact(out.get(), &kGgmlMagic, sizeof(kGgmlMagic)) &&
+             write_exact(out.get(), hparams, sizeof(hparams)) && copy_tables(in.get(), out.get(), src_buf);
+    }
+    if (!ok) {
+        error = "not a GGML whisper model";
+    }
+
+    while (ok) {
+        TensorHeader t;
+        bool eof = false;
+        if (!read_tensor_header(in.get(), t, eof)) {
+            if (!eof) {
+                error = "malformed tensor header";
+                ok = false;
+            }
+            break;
+        }
+        const PackGroup group = classify(t);
+        const ggml_type to = target_type(t, group, type);
+        if (group != PackGroup::Other && to != type) {
+            LOGW("%s: %d columns don't fit %s blocks, keeping %s", t.name.c_str(), t.ne[0],
+                 ggml_type_name(type), ggml_type_name(to));
+            s.n_kept++;
+        }
+        if (!write_tensor_header(out.get(), t, to) || !convert_tensor(in.get(), out.get(), t, to, src_buf, f32_buf, dst_buf)) {
+            error = "failed to convert " + t.name;
+            ok = false;
+            break;
+        }
+        s.bytes_in += t.data_bytes(static_cast<ggml_type>(t.type));
+        s.bytes_out += t.data_bytes(to);
+        s.group_bytes[static_cast<int>(group)] += t.data_bytes(to);
+        s.n_tensors++;
+    }
+
+    in.reset();
+    ok = ok && fflush(out.get()) == 0 && s.n_tensors > 0;
+    out.reset();
+    if (!ok || rename(part_path.c_str(), dst_path) != 0) {
+        if (error.empty()) {
+            error = "failed to write " + std::string(dst_path);
+        }
+        remove(part_path.c_str());
+        return false;
+    }
+    LOGI("Packed %d tensors at %s: %zu -> %zu bytes", s.n_tensors, ggml_type_name(type), s.bytes_in, s.bytes_out);
+    return true;
+}
+
+bool model_pack_inspect(const char* path, PackLayout& out) {
+    out = PackLayout();
+    FilePtr in = open_file(path, "rb");
+    int32_t hparams[kHparamsCount] = {};
+    std::vector<uint8_t> buf;
+    if (!in || !read_hparams(in.get(), hparams) || !copy_tables(in.get(), nullptr, buf)) {
+        return false;
+    }
+    out.header_type = type_of_ftype(hparams[kFtypeIndex] % GGML_QNT_VERSION_FACTOR);
+
+    bool any = false;
+    while (true) {
+        TensorHeader t;
+        bool eof = false;
+        if (!read_tensor_header(in.get(), t, eof)) {
+            return eof && any;
+        }
+        any = true;
+        const PackGroup group = classify(t);
+        if (group != PackGroup::Other) {
+            const int g = static_cast<int>(group);
+            const ggml_type type = static_cast<ggml_type>(t.type);
+            if (out.group_types[g] == GGML_TYPE_COUNT) {
+                out.group_types[g] = type;
+            } else if (out.group_types[g] != type) {
+                out.group_mixed[g] = true;
+            }
+        }
+        if (!copy_bytes(in.get(), nullptr, t.data_bytes(static_cast<ggml_type>(t.type)), buf)) {
+            return false;
+        }
+    }
+}
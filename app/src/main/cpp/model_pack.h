@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "ggml.h"
+
+/**
+ * Re-quantization of whisper GGML models
+ *
+ * Rewrites the weight matrices of the three groups, encoder (attention and MLP),
+ * decoder (self/cross attention and MLP) and the token embedding, at one tensor
+ * type. Convolutions, biases, norms and positional embeddings keep the types
+ * whisper.cpp creates them with.
+ *
+ * whisper.cpp instantiates every weight matrix at the type named by the header's
+ * ftype and rejects tensors of another type, so a file with a different type per
+ * group can't be loaded; the packer only writes one type. Such files from other
+ * tools are detected by model_pack_inspect, and packing one again gives a loadable
+ * file.
+ */
+
+enum class PackGroup : int {
+    Encoder = 0,
+    Decoder = 1,
+    Embedding = 2,
+    Other = 3,   // Kept as whisper.cpp expects
+};
+
+struct PackStats {
+    size_t bytes_in = 0;
+    size_t bytes_out = 0;
+    size_t group_bytes[4] = {};   // Output bytes by PackGroup
+    int n_tensors = 0;
+    int n_kept = 0;               // Matrices left at their source type (row width not a multiple of the block)
+};
+
+/**
+ * Tensor types found in a model file
+ */
+struct PackLayout {
+    ggml_type header_type = GGML_TYPE_COUNT;   // Type the header's ftype names
+    ggml_type group_types[3] = {GGML_TYPE_COUNT, GGML_TYPE_COUNT, GGML_TYPE_COUNT};  // COUNT = none or several
+    bool group_mixed[3] = {false, false, false};
+
+    /**
+     * Every weight matrix is at the header's type, as whisper.cpp requires
+     */
+    bool loadable() const;
+};
+
+/**
+ * Tensor type for a name such as "q5_1" or "f16" (case-insensitive); false if it can't be packed
+ */
+bool pack_type_from_name(const std::string& name, ggml_type& out);
+
+/**
+ * Rewrite the model at src_path with its weight matrices at type to dst_path
+ * Converts a row block at a time, so memory stays small next to the model size.
+ * dst_path is written through a temporary file and only appears once complete.
+ */
+bool model_pack(const char* src_path, const char* dst_path, ggml_type type, PackStats* stats,
+                std::string& error);
+
+/**
+ * Scan the tensor table of a model file (headers only) for the types it holds
+ */
+bool model_pack_inspect(const char* path, PackLayout& out);
@@ -0,0 +1,106 @@
+#include "prompt_cache.h"
+
+namespace {
+
+// Only the end of a long field matters, and a token is at least one byte
+constexpr size_t kMaxFieldChars = 1024;
+
+} // namespace
+
+void PromptCache::set_field_context(const std::string& text) {
+    const std::string tail = text.size() > kMaxFieldChars ? text.substr(text.size() - kMaxFieldChars) : text;
+    if (tail == field_.text) {
+        return;
+    }
+    field_ = Piece();
+    field_.text = tail;
+    dirty_ = true;
+}
+
+void PromptCache::append(const std::string& transcript) {
+    if (transcript.find_first_not_of(" \t\n") == std::string::npos ||
+        (!history_.empty() && history_.back().text == transcript)) {
+        return;
+    }
+    Piece piece;
+    piece.text = transcript;
+    history_.push_back(std::move(piece));
+    dirty_ = true;
+}
+
+void PromptCache::clear() {
+    field_ = Piece();
+    history_.clear();
+    prompt_.clear();
+    dirty_ = false;
+}
+
+void PromptCache::invalidate() {
+    ++epoch_;
+    field_.tokenized = false;
+    field_.tokens.clear();
+    for (Piece& piece : history_) {
+        piece.tokenized = false;
+        piece.tokens.clear();
+    }
+    dirty_ = true;
+}
+
+std::vector<std::string> PromptCache::untokenized() const {
+    std::vector<std::string> texts;
+    if (!field_.text.empty() && !field_.tokenized) {
+        texts.push_back(field_.text);
+    }
+    for (auto it = history_.rbegin(); it != history_.rend(); ++it) {
+        if (!it->tokenized) {
+            texts.push_back(it->text);
+        }
+    }
+    return texts;
+}
+
+void PromptCache::add_tokens(const std::string& text, const std::vector<int32_t>& tokens, uint64_t epoch) {
+    if (epoch != epoch_) {
+        return;
+    }
+    auto fill = [&](Piece& piece) {
+        if (!piece.tokenized && piece.text == text) {
+            piece.tokens = tokens;
+            piece.tokenized = true;
+            dirty_ = true;
+        }
+    };
+    fill(field_);
+    for (Piece& piece : history_) {
+        fill(piece);
+    }
+}
+
+const std::vector<int32_t>& PromptCache::tokens() {
+    if (!dirty_) {
+        return prompt_;
+    }
+
+    // Newest transcriptions first until the budget is spent; older ones are dropped for good
+    size_t n = 0;
+    size_t keep = 0;
+    for (auto it = history_.rbegin(); it != history_.rend() && n < budget_; ++it, ++keep) {
+        n += it->tokens.size();
+    }
+    history_.erase(history_.begin(), history_.end() - keep);
+
+    prompt_.clear();
+    prompt_.insert(prompt_.end(), field_.tokens.begin(), field_.tokens.end());
+    for (const Piece& piece : history_) {
+        prompt_.insert(prompt_.end(), piece.tokens.begin(), piece.tokens.end());
+    }
+    if (prompt_.size() > budget_) {
+        prompt_.erase(prompt_.begin(), prompt_.end() - budget_);
+    }
+    // Stay dirty while pieces wait for tokens, so the next call picks them up
+    dirty_ = !field_.text.empty() && !field_.tokenized && n < budget_;
+    for (const Piece& piece : history_) {
+        dirty_ = dirty_ || !piece.tokenized;
+    }
+    return prompt_;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * Session prompt for dictation continuity
+ *
+ * Each utterance is decoded with the tail of what came before it (the text
+ * already in the focused field, then recent transcriptions) as whisper
+ * prompt_tokens, so vocabulary, names and casing carry over. Every piece of
+ * text is tokenized once, by the caller (untokenized() / add_tokens()), so the
+ * lock guarding the cache is not held while the model is busy; tokens() only
+ * splices the cached tokens together under the token budget.
+ */
+class PromptCache {
+public:
+    static constexpr size_t kDefaultBudget = 96;  // whisper accepts up to n_text_ctx / 2 (224)
+
+    explicit PromptCache(size_t budget = kDefaultBudget) : budget_(budget) {}
+
+    /**
+     * Text preceding the cursor in the focused field (empty when unknown or private)
+     */
+    void set_field_context(const std::string& text);
+
+    /**
+     * Remember a finished transcription; repeats of the latest one are ignored
+     */
+    void append(const std::string& transcript);
+
+    /**
+     * Forget transcriptions and field context
+     */
+    void clear();
+
+    /**
+     * Drop cached tokens (model/vocabulary changed); text is kept and re-tokenized
+     */
+    void invalidate();
+
+    /**
+     * Text still waiting for tokens, and the epoch to hand back with them
+     */
+    std::vector<std::string> untokenized() const;
+    uint64_t epoch() const { return epoch_; }
+
+    /**
+     * Tokens for a text returned by untokenized(); dropped when the text is gone or the
+     * cache was invalidated since
+     */
+    void add_tokens(const std::string& text, const std::vector<int32_t>& tokens, uint64_t epoch);
+
+    /**
+     * Prompt for the next utterance, at most budget tokens, most recent text last
+     * Pieces without tokens yet are left out.
+     */
+    const std::vector<int32_t>& tokens();
+
+private:
+    struct Piece {
+        std::string text;
+        std::vector<int32_t> tokens;
+        bool tokenized = false;
+    };
+
+    size_t budget_;
+    uint64_t epoch_ = 0;  // Bumped by invalidate()
+    Piece field_;
+    std::deque<Piece> history_;  // Oldest first
+    std::vector<int32_t> prompt_;
+    bool dirty_ = false;
+};
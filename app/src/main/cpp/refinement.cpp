@@ -0,0 +1,75 @@
+#include "refinement.h"
+
+#include <chrono>
+#include <utility>
+
+#define LOG_TAG "RefinementJob"
+#include "hw_log.h"
+
+RefinementJob::~RefinementJob() {
+    std::lock_guard<std::mutex> control(control_);
+    cancel();
+    join();
+}
+
+uint64_t RefinementJob::start(std::shared_ptr<const AudioInput> audio, const TranscribeOptions& options) {
+    std::lock_guard<std::mutex> control(control_);
+    cancel();
+    join();
+
+    cancel_ = false;
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = Status::Running;
+        id = ++id_;
+        result_ = TranscribeResult();
+    }
+
+    TranscribeOptions run_options = options;
+    run_options.cancel = &cancel_;
+    thread_ = std::thread([this, audio = std::move(audio), run_options]() {
+        const auto start = std::chrono::steady_clock::now();
+        TranscribeResult result;
+        const bool ok = engine_transcribe_audio(*audio, run_options, result);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ok) {
+            LOGI("Refinement finished: %zu chars in %.0f ms", result.text.length(), ms);
+            status_ = Status::Done;
+            result_ = std::move(result);
+        } else {
+            LOGI("Refinement %s after %.0f ms", result.cancelled ? "cancelled" : "failed", ms);
+            status_ = result.cancelled ? Status::Cancelled : Status::Failed;
+        }
+        finished_.notify_all();
+    });
+    return id;
+}
+
+void RefinementJob::cancel() {
+    cancel_ = true;
+}
+
+RefinementJob::Status RefinementJob::wait(uint64_t id, int64_t timeout_ms, TranscribeResult& result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                       [this, id] { return status_ != Status::Running || id_ != id; });
+    if (id_ != id) {
+        return Status::Cancelled;
+    }
+    const Status status = status_;
+    if (status == Status::Done) {
+        result = std::move(result_);
+        result_ = TranscribeResult();
+        status_ = Status::Idle;
+    }
+    return status;
+}
+
+void RefinementJob::join() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
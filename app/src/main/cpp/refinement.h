@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "whisper_engine.h"
+
+/**
+ * Background refinement of a draft transcription
+ *
+ * The draft model answers a long dictation within a few hundred ms; the job then
+ * runs the main model over the same decoded audio on its own thread. Starting a
+ * new job, cancel() or destroying the job aborts a running one through
+ * TranscribeOptions::cancel, which whisper checks between graph nodes, so a new
+ * utterance never queues behind a stale refinement.
+ */
+class RefinementJob {
+public:
+    enum class Status {
+        Idle,       // Nothing started, or the last result was already taken
+        Running,
+        Done,
+        Failed,
+        Cancelled,
+    };
+
+    RefinementJob() = default;
+    ~RefinementJob();
+    RefinementJob(const RefinementJob&) = delete;
+    RefinementJob& operator=(const RefinementJob&) = delete;
+
+    /**
+     * Cancel any running job, then transcribe audio with options on a new thread
+     * Returns the job id to wait for.
+     */
+    uint64_t start(std::shared_ptr<const AudioInput> audio, const TranscribeOptions& options);
+
+    /**
+     * Ask the running job to stop; returns immediately
+     */
+    void cancel();
+
+    /**
+     * Wait up to timeout_ms for job id to finish
+     * On Done, result receives the transcription and the job becomes Idle; a job that was
+     * replaced by a newer one reports Cancelled.
+     */
+    Status wait(uint64_t id, int64_t timeout_ms, TranscribeResult& result);
+
+private:
+    void join();
+
+    std::mutex control_;  // Serializes start() and destruction
+    std::thread thread_;
+    std::atomic<bool> cancel_{false};
+
+    std::mutex mutex_;    // Guards status_ and result_
+    std::condition_variable finished_;
+    Status status_ = Status::Idle;
+    uint64_t id_ = 0;
+    TranscribeResult result_;
+};
@@ -0,0 +1,173 @@
+#include "repetition_guard.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+#include "confidence.h"
+
+#define LOG_TAG "RepetitionGuard"
+#include "hw_log.h"
+
+namespace {
+
+// Fast speech is ~5 tokens/s in English and up to twice that in scripts that tokenize
+// finely; the base leaves room for timestamps and a short utterance's punctuation
+constexpr int kCapBaseTokens = 16;
+constexpr int kCapTokensPerSecond = 12;
+// whisper's sample_len: half the 448-token text context
+constexpr int kWindowTokens = 224;
+
+// Word-level repeats collapsed after a stop
+constexpr int kCollapseMaxPeriod = 16;
+constexpr int kCollapseMinRepeats = 3;
+constexpr int kCollapseMinSpan = 6;
+
+struct Word {
+    int32_t id;
+    size_t end;  // Byte offset just past the word in the segment text
+};
+
+/**
+ * Words of text as ids that ignore case and punctuation ("Thank you." == "thank you,")
+ */
+std::vector<Word> split_words(const std::string& text) {
+    std::vector<Word> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+            i++;
+        }
+        std::string key;
+        while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (!std::ispunct(c)) {
+                key += static_cast<char>(std::tolower(c));
+            }
+            i++;
+        }
+        if (!key.empty()) {
+            words.push_back({static_cast<int32_t>(std::hash<std::string>()(key)), i});
+        }
+    }
+    return words;
+}
+
+std::vector<int32_t> word_ids(const std::vector<Word>& words) {
+    std::vector<int32_t> ids;
+    ids.reserve(words.size());
+    for (const Word& word : words) {
+        ids.push_back(word.id);
+    }
+    return ids;
+}
+
+} // namespace
+
+int repetition_period(const int32_t* tokens, size_t n_tokens, int max_period, int min_repeats, int min_span,
+                      int* n_repeats) {
+    const int n = static_cast<int>(n_tokens);
+    for (int period = 1; period <= max_period && period * min_repeats <= n; period++) {
+        const int32_t* unit = tokens + n - period;
+        int repeats = 1;
+        while ((repeats + 1) * period <= n &&
+               std::equal(unit, unit + period, tokens + n - (repeats + 1) * period)) {
+            repeats++;
+        }
+        if (repeats >= min_repeats && repeats * period >= min_span) {
+            if (n_repeats != nullptr) {
+                *n_repeats = repeats;
+            }
+            return period;
+        }
+    }
+    return 0;
+}
+
+void repetition_guard_filter(struct whisper_context* ctx, struct whisper_state* /*state*/,
+                             const whisper_token_data* tokens, int n_tokens, float* logits, void* user_data) {
+    RepetitionGuard* guard = static_cast<RepetitionGuard*>(user_data);
+    const RepetitionGuardOptions& options = guard->options;
+    const whisper_token eot = whisper_token_eot(ctx);
+
+    // Timestamps differ between the repeats of a loop; only the text tokens repeat
+    std::vector<int32_t> text_tokens;
+    text_tokens.reserve(n_tokens);
+    for (int i = 0; i < n_tokens; i++) {
+        if (tokens[i].id < eot) {
+            text_tokens.push_back(tokens[i].id);
+        }
+    }
+    const size_t n_text = text_tokens.size();
+    if (n_text == 0) {
+        return;
+    }
+
+    int repeats = 0;
+    const int period = repetition_period(text_tokens.data(), n_text, options.max_period, options.min_repeats,
+                                         options.min_span, &repeats);
+    bool stop = period > 0;
+    float ratio = 0.0f;
+    if (!stop && static_cast<int>(n_text) >= options.ratio_min_tokens &&
+        n_text % static_cast<size_t>(options.ratio_interval) == 0) {
+        std::string text;
+        for (const int32_t token : text_tokens) {
+            text += whisper_token_to_str(ctx, token);
+        }
+        ratio = compression_ratio(text);
+        stop = ratio > options.max_compression_ratio;
+    }
+    if (!stop) {
+        return;
+    }
+
+    // End of text is the only candidate left
+    const int n_vocab = whisper_n_vocab(ctx);
+    std::fill(logits, logits + n_vocab, -std::numeric_limits<float>::infinity());
+    logits[eot] = 0.0f;
+    guard->n_stops++;
+    if (period > 0) {
+        LOGI("Loop stopped after %zu text tokens: %d-token unit repeated %d times", n_text, period, repeats);
+    } else {
+        LOGI("Loop stopped after %zu text tokens: compression ratio %.2f", n_text, ratio);
+    }
+}
+
+int repetition_token_cap(size_t n_samples) {
+    const double seconds = static_cast<double>(n_samples) / WHISPER_SAMPLE_RATE;
+    const int cap = kCapBaseTokens + static_cast<int>(std::ceil(seconds * kCapTokensPerSecond));
+    return cap < kWindowTokens ? cap : 0;
+}
+
+size_t collapse_repetitions(std::vector<TranscribeSegment>& segments) {
+    size_t n_removed = 0;
+    std::vector<int32_t> previous;
+    std::vector<TranscribeSegment> kept;
+    kept.reserve(segments.size());
+    for (TranscribeSegment& segment : segments) {
+        std::vector<Word> words = split_words(segment.text);
+        int repeats = 0;
+        const int period = repetition_period(word_ids(words).data(), words.size(), kCollapseMaxPeriod,
+                                             kCollapseMinRepeats, kCollapseMinSpan, &repeats);
+        if (period > 0) {
+            const size_t n_keep = words.size() - static_cast<size_t>((repeats - 1) * period);
+            segment.text.erase(words[n_keep - 1].end);
+            segment.compression_ratio = compression_ratio(segment.text);
+            n_removed += words.size() - n_keep;
+            words.resize(n_keep);
+        }
+
+        std::vector<int32_t> ids = word_ids(words);
+        if (!ids.empty() && ids == previous && !kept.empty()) {
+            kept.back().t1_ms = segment.t1_ms;
+            n_removed += ids.size();
+            continue;
+        }
+        previous = std::move(ids);
+        kept.push_back(std::move(segment));
+    }
+    segments = std::move(kept);
+    return n_removed;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "whisper.h"
+#include "whisper_engine.h"
+
+/**
+ * Watchdog against decoder loops ("thank you thank you thank you ...")
+ *
+ * Left alone, whisper repeats until it reaches the token limit of the window,
+ * flags the window as failed and decodes it again at higher temperatures, so a
+ * one-second utterance can take ten. As a logits filter the guard sees every
+ * step of the decode: once the text tokens end in a unit repeated back to back,
+ * or the text compresses like a loop, it forces end-of-text. Stopping early keeps
+ * the sequence short enough that whisper's entropy check does not ask for a
+ * fallback. The repeats already emitted are collapsed afterwards.
+ *
+ * A token cap proportional to the duration of the audio bounds what the guard
+ * can't see: nobody says 200 tokens in two seconds.
+ */
+
+struct RepetitionGuardOptions {
+    int max_period = 16;               // Longest repeated unit looked for, in tokens
+    int min_repeats = 3;               // Back-to-back occurrences of the unit
+    int min_span = 12;                 // Tokens those occurrences must cover together
+    float max_compression_ratio = 2.4f; // whisper's own loop threshold
+    int ratio_min_tokens = 32;         // Compression is checked from this many text tokens on,
+    int ratio_interval = 8;            // every ratio_interval tokens
+};
+
+/**
+ * Length of the unit tokens end in when it repeats back to back (0 = no loop)
+ * n_repeats (optional) receives how often it occurs
+ */
+int repetition_period(const int32_t* tokens, size_t n_tokens, int max_period, int min_repeats, int min_span,
+                      int* n_repeats = nullptr);
+
+/**
+ * Guard of one transcription and the number of decodes it ended
+ * One guard may serve concurrent whisper_full calls on different states.
+ */
+struct RepetitionGuard {
+    RepetitionGuardOptions options;
+    std::atomic<int> n_stops{0};
+};
+
+/**
+ * whisper_logits_filter_callback; user_data is a RepetitionGuard
+ */
+void repetition_guard_filter(struct whisper_context* ctx, struct whisper_state* state,
+                             const whisper_token_data* tokens, int n_tokens, float* logits, void* user_data);
+
+/**
+ * Per-window token cap for audio of n_samples at 16 kHz (0 = the window's own limit is lower)
+ */
+int repetition_token_cap(size_t n_samples);
+
+/**
+ * Remove the output of loops the guard stopped: repeated word units at the end of a segment
+ * beyond their first occurrence, and segments repeating the previous one word for word
+ * Returns the number of words removed.
+ */
+size_t collapse_repetitions(std::vector<TranscribeSegment>& segments);
@@ -0,0 +1,228 @@
+#include "result_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "content_hash.h"
+#include "grammar_cache.h"
+
+#define LOG_TAG "ResultCache"
+#include "hw_log.h"
+
+namespace {
+
+constexpr char kIndexMagic[4] = {'H', 'W', 'R', 'C'};
+constexpr uint32_t kIndexVersion = 2;  // 2: per-segment confidence
+constexpr const char* kIndexName = "transcripts.hwidx";
+constexpr uint32_t kMaxStringBytes = 1u << 20;  // Sanity bound when reading a damaged index
+
+template <typename T>
+void put(FILE* f, const T& v) {
+    fwrite(&v, sizeof(v), 1, f);
+}
+
+void put_string(FILE* f, const std::string& s) {
+    put(f, static_cast<uint32_t>(s.size()));
+    fwrite(s.data(), 1, s.size(), f);
+}
+
+template <typename T>
+bool get(FILE* f, T& v) {
+    return fread(&v, sizeof(v), 1, f) == 1;
+}
+
+bool get_string(FILE* f, std::string& s) {
+    uint32_t n = 0;
+    if (!get(f, n) || n > kMaxStringBytes) {
+        return false;
+    }
+    s.resize(n);
+    return n == 0 || fread(&s[0], 1, n, f) == n;
+}
+
+} // namespace
+
+uint64_t result_options_hash(const TranscribeOptions& options) {
+    constexpr uint32_t kVersion = 2;
+    std::vector<uint8_t> bytes;
+    auto add = [&bytes](const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), p, p + size);
+    };
+    auto add_value = [&add](auto v) { add(&v, sizeof(v)); };
+
+    add_value(kVersion);
+    const std::string language = options.language.empty() ? "auto" : options.language;
+    add_value(static_cast<uint32_t>(language.size()));
+    add(language.data(), language.size());
+    add_value(static_cast<uint8_t>(options.translate));
+    add_value(static_cast<int32_t>(options.profile));
+    add_value(options.beam_size);
+    add_value(static_cast<uint8_t>(options.encoder_cache > 0 && options.encoder_cache_decode)); // Untimed greedy text on a hit
+    add_value(static_cast<uint8_t>(options.vad.enabled));
+    if (options.vad.enabled) {
+        add_value(options.vad.frame_ms);
+        add_value(options.vad.energy_margin_db);
+        add_value(options.vad.min_energy_db);
+        add_value(options.vad.max_noise_db);
+        add_value(options.vad.flatness_threshold);
+        add_value(options.vad.min_speech_ms);
+        add_value(options.vad.min_silence_ms);
+        add_value(options.vad.padding_ms);
+        add_value(options.vad.gap_ms);
+    }
+    add_value(options.stretch.factor);
+    add_value(options.stretch.frame_ms);
+    add_value(options.stretch.search_ms);
+    add_value(options.n_parallel == 1);  // Serial vs. chunked long-form
+    add_value(static_cast<uint32_t>(options.prompt_tokens.size()));
+    add(options.prompt_tokens.data(), options.prompt_tokens.size() * sizeof(int32_t));
+    add_value(options.grammar ? options.grammar->hash : 0);
+    if (options.grammar) {
+        add_value(options.grammar_penalty);
+    }
+    add(options.suppress_regex.c_str(), options.suppress_regex.size() + 1);
+    add_value(options.max_tokens);
+    add_value(static_cast<uint8_t>(options.repetition_guard));
+    add_value(static_cast<uint8_t>(options.detect.enabled));
+    if (options.detect.enabled) {
+        add_value(options.detect.prefix_ms);
+        for (const std::string& code : options.detect.candidates) {
+            add(code.c_str(), code.size() + 1);
+        }
+    }
+    return content_hash(bytes.data(), bytes.size());
+}
+
+void ResultCache::open(const std::string& dir, size_t capacity) {
+    const std::string path = dir.empty() ? std::string() : dir + "/" + kIndexName;
+    capacity_ = capacity > 0 ? capacity : kDefaultCapacity;
+    if (path == path_) {
+        return;
+    }
+    path_ = path;
+    entries_.clear();
+    if (!path_.empty() && load()) {
+        LOGI("Loaded %zu cached transcripts", entries_.size());
+    }
+}
+
+bool ResultCache::lookup(const ResultCacheKey& key, CachedTranscript& out) {
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (entries_[i].key == key) {
+            // Move to the most recently used end; the index is rewritten on the next store
+            Entry entry = std::move(entries_[i]);
+            entries_.erase(entries_.begin() + i);
+            entries_.push_back(std::move(entry));
+            out = entries_.back().transcript;
+            hits_++;
+            return true;
+        }
+    }
+    misses_++;
+    return false;
+}
+
+void ResultCache::store(const ResultCacheKey& key, const CachedTranscript& transcript) {
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (entries_[i].key == key) {
+            entries_.erase(entries_.begin() + i);
+            break;
+        }
+    }
+    entries_.push_back({key, transcript});
+    if (entries_.size() > capacity_) {
+        entries_.erase(entries_.begin(), entries_.begin() + (entries_.size() - capacity_));
+    }
+    save();
+}
+
+double ResultCache::hit_rate() const {
+    const uint64_t lookups = hits_ + misses_;
+    return lookups > 0 ? static_cast<double>(hits_) / lookups : 0.0;
+}
+
+bool ResultCache::load() {
+    FILE* f = fopen(path_.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint32_t count = 0;
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+              memcmp(magic, kIndexMagic, sizeof(magic)) == 0 &&
+              get(f, version) && version == kIndexVersion && get(f, count);
+
+    for (uint32_t i = 0; ok && i < count; i++) {
+        Entry entry;
+        uint64_t n_speech = 0;
+        uint32_t n_segments = 0;
+        ok = get(f, entry.key.audio) && get(f, entry.key.options) && get(f, entry.key.model) &&
+             get(f, n_speech) && get_string(f, entry.transcript.text) && get(f, n_segments) &&
+             n_segments <= kMaxStringBytes;
+        for (uint32_t s = 0; ok && s < n_segments; s++) {
+            TranscribeSegment segment;
+            ok = get(f, segment.t0_ms) && get(f, segment.t1_ms) && get_string(f, segment.text) &&
+                 get(f, segment.avg_logprob) && get(f, segment.no_speech_prob) &&
+                 get(f, segment.compression_ratio) && get(f, segment.n_tokens);
+            entry.transcript.segments.push_back(std::move(segment));
+        }
+        entry.transcript.n_speech_samples = static_cast<size_t>(n_speech);
+        if (ok) {
+            entries_.push_back(std::move(entry));
+        }
+    }
+    fclose(f);
+
+    if (!ok) {
+        LOGW("Discarding unreadable transcript index: %s", path_.c_str());
+        entries_.clear();
+        unlink(path_.c_str());
+    }
+    if (entries_.size() > capacity_) {
+        entries_.erase(entries_.begin(), entries_.begin() + (entries_.size() - capacity_));
+    }
+    return ok;
+}
+
+void ResultCache::save() const {
+    if (path_.empty()) {
+        return;
+    }
+
+    // Write-then-rename so a crash never leaves a truncated index behind
+    const std::string tmp_path = path_ + ".tmp";
+    FILE* f = fopen(tmp_path.c_str(), "wb");
+    if (f == nullptr) {
+        LOGE("Failed to write transcript index: %s", tmp_path.c_str());
+        return;
+    }
+    fwrite(kIndexMagic, 1, sizeof(kIndexMagic), f);
+    put(f, kIndexVersion);
+    put(f, static_cast<uint32_t>(entries_.size()));
+    for (const Entry& entry : entries_) {
+        put(f, entry.key.audio);
+        put(f, entry.key.options);
+        put(f, entry.key.model);
+        put(f, static_cast<uint64_t>(entry.transcript.n_speech_samples));
+        put_string(f, entry.transcript.text);
+        put(f, static_cast<uint32_t>(entry.transcript.segments.size()));
+        for (const TranscribeSegment& segment : entry.transcript.segments) {
+            put(f, segment.t0_ms);
+            put(f, segment.t1_ms);
+            put_string(f, segment.text);
+            put(f, segment.avg_logprob);
+            put(f, segment.no_speech_prob);
+            put(f, segment.compression_ratio);
+            put(f, segment.n_tokens);
+        }
+    }
+    const bool ok = ferror(f) == 0;
+    fclose(f);
+    if (!ok || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        LOGE("Failed to update transcript index: %s", path_.c_str());
+        unlink(tmp_path.c_str());
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "whisper_engine.h"
+
+/**
+ * Content-addressed transcription result cache
+ *
+ * Reprocessing a history item with unchanged settings produces the same text,
+ * so finished results are kept under (audio hash, options hash, model id).
+ * Entries live in memory and, when a directory is configured, in one small
+ * index file that survives process restarts. Least recently used entries are
+ * dropped beyond the capacity.
+ */
+
+struct ResultCacheKey {
+    uint64_t audio = 0;    // XXH64 of the PCM handed to the engine
+    uint64_t options = 0;  // Canonical hash of every option that can change the output
+    uint64_t model = 0;    // Fingerprint of the loaded model file
+
+    bool operator==(const ResultCacheKey& other) const {
+        return audio == other.audio && options == other.options && model == other.model;
+    }
+};
+
+/**
+ * Canonical hash of every option that can change the transcript for given PCM (ResultCacheKey::options)
+ * Thread counts and cache settings are left out; bump kVersion when decoding changes.
+ */
+uint64_t result_options_hash(const TranscribeOptions& options);
+
+struct CachedTranscript {
+    std::string text;
+    std::vector<TranscribeSegment> segments;
+    size_t n_speech_samples = 0;
+};
+
+class ResultCache {
+public:
+    static constexpr size_t kDefaultCapacity = 64;
+
+    /**
+     * Persist entries under dir (empty for memory only); loads an existing index
+     */
+    void open(const std::string& dir, size_t capacity = kDefaultCapacity);
+
+    /**
+     * Copy a cached result into out; counts towards the hit rate
+     */
+    bool lookup(const ResultCacheKey& key, CachedTranscript& out);
+
+    /**
+     * Insert or refresh an entry and rewrite the index file
+     */
+    void store(const ResultCacheKey& key, const CachedTranscript& transcript);
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * Hits / lookups, 0 before the first lookup
+     */
+    double hit_rate() const;
+
+private:
+    struct Entry {
+        ResultCacheKey key;
+        CachedTranscript transcript;
+    };
+
+    bool load();
+    void save() const;
+
+    std::string path_;
+    size_t capacity_ = kDefaultCapacity;
+    std::vector<Entry> entries_;  // Least recently used first
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,143 @@
+#include "time_stretch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "TimeStretch"
+#include "hw_log.h"
+
+namespace {
+
+constexpr float kMinFactor = 1.0f;
+constexpr float kMaxFactor = 1.5f;
+
+// Four partial sums keep the FP add chain short enough to pipeline
+float dot(const float* a, const float* b, size_t n) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// Normalized cross-correlation of the candidate against the template
+float similarity(const float* templ, const float* cand, size_t n) {
+    const float energy = dot(cand, cand, n);
+    return energy > 1e-9f ? dot(templ, cand, n) / std::sqrt(energy) : 0.0f;
+}
+
+} // namespace
+
+bool StretchMap::compress(const float* pcm, size_t n_samples, int sample_rate, const StretchOptions& options,
+                          std::vector<float>& out) {
+    anchors_.clear();
+    out.clear();
+
+    const float factor = std::min(kMaxFactor, std::max(kMinFactor, options.factor));
+    const size_t frame = static_cast<size_t>(sample_rate) * options.frame_ms / 1000 & ~static_cast<size_t>(1);
+    const size_t hop_out = frame / 2;
+    const size_t search = static_cast<size_t>(sample_rate) * options.search_ms / 1000;
+    if (factor <= kMinFactor || hop_out == 0 || n_samples < frame * 4) {
+        return false;
+    }
+
+    // Periodic Hann: overlapping halves sum to exactly 1 at 50% overlap
+    std::vector<float> window(frame);
+    for (size_t i = 0; i < frame; i++) {
+        window[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / frame);
+    }
+
+    const double hop_in = hop_out * static_cast<double>(factor);
+    const size_t last_start = n_samples - frame;
+    out.assign(static_cast<size_t>(n_samples / factor) + frame * 2, 0.0f);
+
+    size_t prev = 0;
+    size_t k = 0;
+    for (;; k++) {
+        const size_t nominal = static_cast<size_t>(std::lround(k * hop_in));
+        if (nominal > last_start || k * hop_out + frame > out.size()) {
+            break;
+        }
+
+        size_t pos = nominal;
+        if (k > 0) {
+            // The template is the natural continuation of the previous frame; search
+            // coarsely (step 2) and refine around the best match
+            const float* templ = pcm + prev + hop_out;
+            const size_t lo = nominal > search ? nominal - search : 0;
+            const size_t hi = std::min(last_start, nominal + search);
+            float best = -1e30f;
+            for (size_t c = lo; c <= hi; c += 2) {
+                const float s = similarity(templ, pcm + c, hop_out);
+                if (s > best) {
+                    best = s;
+                    pos = c;
+                }
+            }
+            const size_t coarse = pos;
+            for (size_t c : {coarse - 1, coarse + 1}) {
+                if (c < lo || c > hi) {
+                    continue;
+                }
+                const float s = similarity(templ, pcm + c, hop_out);
+                if (s > best) {
+                    best = s;
+                    pos = c;
+                }
+            }
+        }
+
+        float* dst = out.data() + k * hop_out;
+        const float* src = pcm + pos;
+        for (size_t i = 0; i < frame; i++) {
+            dst[i] += src[i] * window[i];
+        }
+        anchors_.push_back({k * hop_out, pos});
+        prev = pos;
+    }
+
+    // Complete the last frame's fading half and append the remaining input unchanged
+    const size_t tail_out = (k - 1) * hop_out + hop_out;
+    for (size_t i = 0; i < hop_out; i++) {
+        out[tail_out + i] += pcm[prev + hop_out + i] * (1.0f - window[hop_out + i]);
+    }
+    const size_t rest = n_samples - (prev + frame);
+    out.resize(tail_out + hop_out);
+    out.insert(out.end(), pcm + prev + frame, pcm + n_samples);
+    anchors_.push_back({tail_out + hop_out + rest, n_samples});
+
+    LOGI("Compressed %zu -> %zu samples (x%.2f)", n_samples, out.size(), static_cast<double>(n_samples) / out.size());
+    return true;
+}
+
+size_t StretchMap::to_source(size_t out_sample) const {
+    if (anchors_.empty()) {
+        return out_sample;
+    }
+    auto it = std::upper_bound(anchors_.begin(), anchors_.end(), out_sample,
+                               [](size_t pos, const Anchor& a) { return pos < a.out_pos; });
+    if (it == anchors_.begin()) {
+        return anchors_.front().in_pos;
+    }
+    if (it == anchors_.end()) {
+        return anchors_.back().in_pos;
+    }
+    const Anchor& a = *(it - 1);
+    const Anchor& b = *it;
+    const double t = static_cast<double>(out_sample - a.out_pos) / static_cast<double>(b.out_pos - a.out_pos);
+    // Neighbouring frames may be picked slightly out of order at low factors, so interpolate signed
+    const double in = static_cast<double>(a.in_pos) + t * (static_cast<double>(b.in_pos) - static_cast<double>(a.in_pos));
+    return static_cast<size_t>(std::max(0.0, in));
+}
+
+int64_t StretchMap::to_source_cs(int64_t out_cs, int sample_rate) const {
+    const size_t out = static_cast<size_t>(std::max<int64_t>(0, out_cs)) * sample_rate / 100;
+    return static_cast<int64_t>(to_source(out) * 100 / sample_rate);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WSOLA time compression ahead of whisper
+ *
+ * Speeds speech up by a constant factor without changing pitch: fixed-hop
+ * Hann-windowed frames are overlap-added, each taken from the input position
+ * (within a small search range) that best continues the previous frame's
+ * waveform. whisper tolerates moderately fast speech, and fewer samples mean
+ * fewer 30 s encoder windows on long recordings. Internal pauses are already
+ * collapsed by VadTimeline::pack, so this stage runs on packed speech.
+ */
+
+struct StretchOptions {
+    float factor = 1.0f;   // Speed-up, clamped to [1.0, 1.5]; 1.0 disables the stage
+    int frame_ms = 30;     // Analysis/synthesis frame (50% overlap on output)
+    int search_ms = 8;     // +/- range searched around the nominal input position
+};
+
+class StretchMap {
+public:
+    /**
+     * Compress pcm into out by options.factor and record the output -> input anchors
+     * Returns false (out left empty) when the factor is 1.0 or the input is too short
+     */
+    bool compress(const float* pcm, size_t n_samples, int sample_rate, const StretchOptions& options, std::vector<float>& out);
+
+    /**
+     * Input sample for an output sample, interpolated between frame anchors
+     */
+    size_t to_source(size_t out_sample) const;
+
+    /**
+     * Same as to_source for whisper's 10 ms timestamp units
+     */
+    int64_t to_source_cs(int64_t out_cs, int sample_rate) const;
+
+private:
+    struct Anchor {
+        size_t out_pos;
+        size_t in_pos;
+    };
+    std::vector<Anchor> anchors_;
+};
@@ -0,0 +1,323 @@
+/**
+ * hyperwhisper-audio-bench: Google Benchmark suite for the audio front-end
+ *
+ * Measures read_wav, int16/int32 -> float conversion, stereo downmix and
+ * resampling to 16 kHz on synthetic clips from 1 s to 30 min at 8/16/44.1/48 kHz,
+ * scalar and SIMD kernels side by side. Throughput is reported as items/s
+ * (samples) and bytes/s.
+ *
+ *   hyperwhisper-audio-bench [--benchmark_filter=Resample] [google benchmark flags]
+ *
+ * Real clips: set HYPERWHISPER_BENCH_WAV_DIR to a directory of WAV files and
+ * each file gets its own read_wav and read_wav+resample benchmark.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "audio_converter.h"
+#include "audio_kernels.h"
+
+#define LOG_TAG "AudioBench"
+#include "hw_log.h"
+
+namespace {
+
+constexpr int kDurationsS[] = {1, 10, 60, 300, 1800};
+constexpr int kSampleRates[] = {8000, 16000, 44100, 48000};
+constexpr int kTargetRate = 16000;
+
+// Deterministic speech-band signal with a little noise so no kernel sees constant input
+std::vector<float> synth_float(size_t n, int sample_rate) {
+    std::vector<float> out(n);
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f) * 0.05f;
+        const float t = static_cast<float>(i) / sample_rate;
+        out[i] = 0.4f * std::sin(2.0f * static_cast<float>(M_PI) * 220.0f * t)
+               + 0.2f * std::sin(2.0f * static_cast<float>(M_PI) * 1250.0f * t) + noise;
+    }
+    return out;
+}
+
+std::vector<int16_t> synth_pcm16(size_t n, int sample_rate) {
+    const std::vector<float> f = synth_float(n, sample_rate);
+    std::vector<int16_t> out(n);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<int16_t>(f[i] * 32767.0f);
+    }
+    return out;
+}
+
+std::vector<int32_t> synth_pcm32(size_t n, int sample_rate) {
+    const std::vector<float> f = synth_float(n, sample_rate);
+    std::vector<int32_t> out(n);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<int32_t>(f[i] * 2147483647.0f);
+    }
+    return out;
+}
+
+size_t n_samples(const benchmark::State& state) {
+    return static_cast<size_t>(state.range(0)) * static_cast<size_t>(state.range(1));
+}
+
+void set_throughput(benchmark::State& state, size_t items, size_t bytes) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(items));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+}
+
+// Args: {duration_s, sample_rate}
+void frontend_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"seconds", "hz"});
+    for (int seconds : kDurationsS) {
+        for (int rate : kSampleRates) {
+            b->Args({seconds, rate});
+        }
+    }
+    b->Unit(benchmark::kMicrosecond);
+}
+
+using Pcm16Fn = void (*)(const int16_t*, float*, size_t);
+using Pcm32Fn = void (*)(const int32_t*, float*, size_t);
+using StereoFn = void (*)(const float*, float*, size_t);
+using ResampleFn = void (*)(const float*, size_t, int, int, std::vector<float>&);
+using RmsPeakFn = void (*)(const float*, size_t, size_t, float*, float*);
+using PowerFn = void (*)(const float*, const float*, float*, size_t);
+
+void BM_Pcm16ToFloat(benchmark::State& state, Pcm16Fn fn) {
+    const size_t n = n_samples(state);
+    const std::vector<int16_t> in = synth_pcm16(n, static_cast<int>(state.range(1)));
+    std::vector<float> out(n);
+    for (auto _ : state) {
+        fn(in.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n, n * (sizeof(int16_t) + sizeof(float)));
+}
+
+void BM_Pcm32ToFloat(benchmark::State& state, Pcm32Fn fn) {
+    const size_t n = n_samples(state);
+    const std::vector<int32_t> in = synth_pcm32(n, static_cast<int>(state.range(1)));
+    std::vector<float> out(n);
+    for (auto _ : state) {
+        fn(in.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n, n * (sizeof(int32_t) + sizeof(float)));
+}
+
+void BM_StereoToMono(benchmark::State& state, StereoFn fn) {
+    const size_t n_frames = n_samples(state);
+    const std::vector<float> in = synth_float(n_frames * 2, static_cast<int>(state.range(1)));
+    std::vector<float> out(n_frames);
+    for (auto _ : state) {
+        fn(in.data(), out.data(), n_frames);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n_frames, n_frames * 3 * sizeof(float));
+}
+
+void BM_Resample(benchmark::State& state, ResampleFn fn) {
+    const int rate = static_cast<int>(state.range(1));
+    const size_t n = n_samples(state);
+    const std::vector<float> in = synth_float(n, rate);
+    std::vector<float> out;
+    for (auto _ : state) {
+        fn(in.data(), n, rate, kTargetRate, out);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n, (n + out.size()) * sizeof(float));
+}
+
+// 10 ms frames, as used by trim_silence
+void BM_FrameRmsPeak(benchmark::State& state, RmsPeakFn fn) {
+    const int rate = static_cast<int>(state.range(1));
+    const size_t n = n_samples(state);
+    const size_t frame_len = static_cast<size_t>(rate) / 100;
+    const size_t n_frames = n / frame_len;
+    const std::vector<float> in = synth_float(n, rate);
+    std::vector<float> rms(n_frames);
+    std::vector<float> peak(n_frames);
+    for (auto _ : state) {
+        fn(in.data(), n_frames, frame_len, rms.data(), peak.data());
+        benchmark::DoNotOptimize(rms.data());
+        benchmark::DoNotOptimize(peak.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n, n * sizeof(float));
+}
+
+// 201-bin STFT frames as produced by IncrementalMel, one per 160-sample hop
+void BM_PowerSpectrum(benchmark::State& state, PowerFn fn) {
+    const size_t n = n_samples(state);
+    const size_t n_bins = (n / 160) * 201;
+    const std::vector<float> re = synth_float(n_bins, static_cast<int>(state.range(1)));
+    const std::vector<float> im(re.rbegin(), re.rend());
+    std::vector<float> out(n_bins);
+    for (auto _ : state) {
+        fn(re.data(), im.data(), out.data(), n_bins);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    set_throughput(state, n, n_bins * 3 * sizeof(float));
+}
+
+// ---- read_wav on synthetic files -------------------------------------------
+
+void put_u16(FILE* f, uint16_t v) { fwrite(&v, sizeof(v), 1, f); }
+void put_u32(FILE* f, uint32_t v) { fwrite(&v, sizeof(v), 1, f); }
+
+std::string write_temp_wav(int seconds, int rate, int channels) {
+    char path[] = "/tmp/hw_audio_bench_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        return "";
+    }
+    FILE* f = fdopen(fd, "wb");
+    const std::vector<int16_t> pcm = synth_pcm16(static_cast<size_t>(seconds) * rate * channels, rate);
+    const uint32_t data_size = static_cast<uint32_t>(pcm.size() * sizeof(int16_t));
+
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, 16);
+    put_u16(f, 1);
+    put_u16(f, static_cast<uint16_t>(channels));
+    put_u32(f, static_cast<uint32_t>(rate));
+    put_u32(f, static_cast<uint32_t>(rate * channels * 2));
+    put_u16(f, static_cast<uint16_t>(channels * 2));
+    put_u16(f, 16);
+    fwrite("data", 1, 4, f);
+    put_u32(f, data_size);
+    fwrite(pcm.data(), sizeof(int16_t), pcm.size(), f);
+    fclose(f);
+    return path;
+}
+
+// Synthetic WAVs are written once per (duration, rate, channels) and removed at exit
+std::map<std::string, std::string>& temp_wavs() {
+    static std::map<std::string, std::string> files;
+    return files;
+}
+
+const std::string& synthetic_wav(int seconds, int rate, int channels) {
+    const std::string key = std::to_string(seconds) + "/" + std::to_string(rate) + "/" + std::to_string(channels);
+    auto it = temp_wavs().find(key);
+    if (it == temp_wavs().end()) {
+        it = temp_wavs().emplace(key, write_temp_wav(seconds, rate, channels)).first;
+    }
+    return it->second;
+}
+
+void BM_ReadWav(benchmark::State& state, int channels) {
+    const std::string& path = synthetic_wav(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), channels);
+    if (path.empty()) {
+        state.SkipWithError("failed to write temp WAV");
+        return;
+    }
+    std::vector<float> pcm;
+    int rate = 0;
+    for (auto _ : state) {
+        if (!read_wav(path.c_str(), pcm, rate)) {
+            state.SkipWithError("read_wav failed");
+            return;
+        }
+        benchmark::DoNotOptimize(pcm.data());
+    }
+    const size_t samples = n_samples(state) * static_cast<size_t>(channels);
+    set_throughput(state, samples, samples * sizeof(int16_t));
+}
+
+// ---- real clips --------------------------------------------------------------
+
+void BM_RealClip(benchmark::State& state, const std::string& path, bool resample) {
+    std::vector<float> pcm;
+    std::vector<float> resampled;
+    int rate = 0;
+    for (auto _ : state) {
+        if (!read_wav(path.c_str(), pcm, rate)) {
+            state.SkipWithError("read_wav failed");
+            return;
+        }
+        if (resample && rate != kTargetRate) {
+            resample_linear(pcm.data(), pcm.size(), rate, kTargetRate, resampled);
+            benchmark::DoNotOptimize(resampled.data());
+        }
+        benchmark::DoNotOptimize(pcm.data());
+    }
+    state.counters["audio_s"] = rate > 0 ? static_cast<double>(pcm.size()) / rate : 0.0;
+    set_throughput(state, pcm.size(), pcm.size() * sizeof(float));
+}
+
+void register_real_clips() {
+    const char* dir = getenv("HYPERWHISPER_BENCH_WAV_DIR");
+    if (dir == nullptr || dir[0] == '\0') {
+        return;
+    }
+    DIR* d = opendir(dir);
+    if (d == nullptr) {
+        fprintf(stderr, "HYPERWHISPER_BENCH_WAV_DIR: cannot open %s\n", dir);
+        return;
+    }
+    while (const struct dirent* entry = readdir(d)) {
+        const std::string name = entry->d_name;
+        if (name.size() < 5 || name.compare(name.size() - 4, 4, ".wav") != 0) {
+            continue;
+        }
+        const std::string path = std::string(dir) + "/" + name;
+        benchmark::RegisterBenchmark(("BM_RealClip_ReadWav/" + name).c_str(), BM_RealClip, path, false)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_RealClip_ReadWavResample/" + name).c_str(), BM_RealClip, path, true)
+            ->Unit(benchmark::kMillisecond);
+    }
+    closedir(d);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_Pcm16ToFloat, scalar, pcm16_to_float_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_Pcm16ToFloat, simd, pcm16_to_float_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_Pcm32ToFloat, scalar, pcm32_to_float_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_Pcm32ToFloat, simd, pcm32_to_float_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_StereoToMono, scalar, stereo_to_mono_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_StereoToMono, simd, stereo_to_mono_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_Resample, scalar, resample_linear_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_Resample, simd, resample_linear_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_FrameRmsPeak, scalar, frame_rms_peak_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_FrameRmsPeak, simd, frame_rms_peak_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_PowerSpectrum, scalar, power_spectrum_scalar)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_PowerSpectrum, simd, power_spectrum_simd)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_ReadWav, mono, 1)->Apply(frontend_args);
+BENCHMARK_CAPTURE(BM_ReadWav, stereo, 2)->Apply(frontend_args);
+
+int main(int argc, char** argv) {
+    hw_log_set_verbose(false);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    register_real_clips();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    for (const auto& entry : temp_wavs()) {
+        if (!entry.second.empty()) {
+            unlink(entry.second.c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+#
+# Fetch a fixed LibriSpeech test-clean subset (CC BY 4.0, openslr.org/12) for
+# hyperwhisper-regress and write librispeech.tsv next to this script.
+#
+#   tools/corpus/fetch_librispeech.sh [COUNT]   # default: first 40 utterances
+#
+# Requires curl, tar and ffmpeg. The archive is cached in $HW_CORPUS_CACHE
+# (default: ~/.cache/hyperwhisper) so repeat runs stay offline.
+
+set -euo pipefail
+
+COUNT="${1:-40}"
+HERE="$(cd "$(dirname "$0")" && pwd)"
+CACHE="${HW_CORPUS_CACHE:-$HOME/.cache/hyperwhisper}"
+ARCHIVE="$CACHE/test-clean.tar.gz"
+URL="https://www.openslr.org/resources/12/test-clean.tar.gz"
+OUT="$HERE/librispeech"
+MANIFEST="$HERE/librispeech.tsv"
+
+for tool in curl tar ffmpeg; do
+    command -v "$tool" > /dev/null || { echo "missing required tool: $tool" >&2; exit 1; }
+done
+
+mkdir -p "$CACHE" "$OUT"
+if [ ! -f "$ARCHIVE" ]; then
+    echo "Downloading LibriSpeech test-clean..."
+    curl -L --fail -o "$ARCHIVE.part" "$URL"
+    mv "$ARCHIVE.part" "$ARCHIVE"
+fi
+
+if [ ! -d "$CACHE/LibriSpeech/test-clean" ]; then
+    tar -xzf "$ARCHIVE" -C "$CACHE"
+fi
+
+# Utterance IDs sort deterministically, so the subset is the same on every machine
+{
+    echo "# LibriSpeech test-clean subset (CC BY 4.0), generated by fetch_librispeech.sh"
+    find "$CACHE/LibriSpeech/test-clean" -name '*.trans.txt' -print0 | sort -z | xargs -0 cat | sort | head -n "$COUNT" |
+    while read -r id text; do
+        speaker="${id%%-*}"
+        rest="${id#*-}"
+        chapter="${rest%%-*}"
+        flac="$CACHE/LibriSpeech/test-clean/$speaker/$chapter/$id.flac"
+        wav="$OUT/$id.wav"
+        if [ ! -f "$wav" ]; then
+            ffmpeg -loglevel error -y -i "$flac" -ar 16000 -ac 1 -c:a pcm_s16le "$wav" < /dev/null
+        fi
+        printf 'librispeech/%s.wav\t%s\n' "$id" "$text"
+    done
+} > "$MANIFEST"
+
+echo "Wrote $(grep -vc '^#' "$MANIFEST") clips to $MANIFEST"
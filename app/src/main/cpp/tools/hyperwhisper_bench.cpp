@@ -0,0 +1,342 @@
+/**
+ * hyperwhisper-bench: host benchmark driver for the native core
+ *
+ * Runs the same load -> read_wav -> transcribe path as the Android app on
+ * WAV files and prints real-time factor, per-phase timings and peak RSS as JSON.
+ *
+ *   hyperwhisper-bench -m ggml-base.bin [-l en] [-t 4] [-r 3] audio.wav...
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "whisper.h"
+#include "whisper_engine.h"
+#include "audio_converter.h"
+#include "cpu_features.h"
+#include "grammar_cache.h"
+#include "input_field.h"
+#include "tool_common.h"
+
+#define LOG_TAG "Bench"
+#include "hw_log.h"
+
+namespace {
+
+struct BenchArgs {
+    std::string model;
+    std::string cache_dir;
+    std::string grammar;
+    std::string field = "text";
+    std::string profile = "balanced";
+    std::vector<std::string> files;
+    TranscribeOptions options;
+    int repeat = 1;
+    bool incremental_mel = false;
+    bool verbose = false;
+};
+
+void print_usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL [options] FILE.wav...\n"
+            "\n"
+            "  -m, --model PATH      ggml model file\n"
+            "  -l, --language CODE   ISO-639-1 language (default: auto)\n"
+            "  -t, --threads N       decoder threads (default: %d)\n"
+            "  -r, --repeat N        transcribe every file N times (default: 1)\n"
+            "      --translate       translate to English\n"
+            "      --cache-dir DIR   persist the result cache under DIR\n"
+            "      --no-trim         keep leading/trailing silence\n"
+            "      --no-vad          feed the whole recording to whisper (skip speech detection)\n"
+            "      --speed F         WSOLA speed-up before whisper, 1.0-1.5 (default: 1.0 = off)\n"
+            "      --detect LANGS    up-front language detection among LANGS (comma list, or \"all\")\n"
+            "      --result-cache    reuse results of identical runs (in memory, or under --cache-dir)\n"
+            "      --encoder-cache N keep N encoder outputs; -r 2+ then measures decoder-only reprocessing\n"
+            "      --grammar FILE    constrain output to the GBNF grammar in FILE (start rule: root)\n"
+            "      --field TYPE      decode as for a text|number|phone|email|url input field\n"
+            "      --profile NAME    decoding profile: fast|balanced|accurate (default: balanced)\n"
+            "      --budget MS       latency budget per transcription (default: 0 = none)\n"
+            "      --no-repetition-guard  let decoder loops run to the token limit (and fall back)\n"
+            "      --incremental-mel compute the mel ahead of time, as the recorder does (16 kHz files)\n"
+            "  -p, --parallel N      chunk decoders for long recordings (default: auto, 1 = serial)\n"
+            "  -v, --verbose         print native logs to stderr\n",
+            argv0, TranscribeOptions().n_threads);
+}
+
+bool parse_args(int argc, char** argv, BenchArgs& args) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+
+        if (arg == "-m" || arg == "--model") {
+            const char* v = next();
+            if (!v) return false;
+            args.model = v;
+        } else if (arg == "-l" || arg == "--language") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.language = v;
+        } else if (arg == "-t" || arg == "--threads") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.n_threads = atoi(v);
+        } else if (arg == "-r" || arg == "--repeat") {
+            const char* v = next();
+            if (!v) return false;
+            args.repeat = atoi(v);
+        } else if (arg == "--translate") {
+            args.options.translate = true;
+        } else if (arg == "--cache-dir") {
+            const char* v = next();
+            if (!v) return false;
+            args.cache_dir = v;
+        } else if (arg == "-p" || arg == "--parallel") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.n_parallel = atoi(v);
+        } else if (arg == "--no-trim") {
+            args.options.trim.enabled = false;
+        } else if (arg == "--no-vad") {
+            args.options.vad.enabled = false;
+        } else if (arg == "--speed") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.stretch.factor = static_cast<float>(atof(v));
+        } else if (arg == "--detect") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.detect.enabled = true;
+            const std::string langs = v;
+            for (size_t pos = 0; langs != "all" && pos < langs.size();) {
+                const size_t comma = std::min(langs.find(',', pos), langs.size());
+                args.options.detect.candidates.push_back(langs.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else if (arg == "--result-cache") {
+            args.options.result_cache = true;
+        } else if (arg == "--encoder-cache") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.encoder_cache = atoi(v);
+            args.options.encoder_cache_decode = true;
+        } else if (arg == "--grammar") {
+            const char* v = next();
+            if (!v) return false;
+            args.grammar = v;
+        } else if (arg == "--field") {
+            const char* v = next();
+            if (!v) return false;
+            args.field = v;
+        } else if (arg == "--profile") {
+            const char* v = next();
+            if (!v) return false;
+            args.profile = v;
+        } else if (arg == "--budget") {
+            const char* v = next();
+            if (!v) return false;
+            args.options.budget_ms = atoi(v);
+        } else if (arg == "--no-repetition-guard") {
+            args.options.repetition_guard = false;
+        } else if (arg == "--incremental-mel") {
+            args.incremental_mel = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            args.verbose = true;
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return false;
+        } else {
+            args.files.push_back(arg);
+        }
+    }
+    return !args.model.empty() && !args.files.empty() && args.repeat > 0 && args.options.n_threads > 0;
+}
+
+/**
+ * Replay a WAV file through IncrementalMel in recorder-sized (100 ms) PCM16 reads
+ * Returns false when the file is not 16 kHz; push_ms receives the time spent during "recording"
+ */
+bool precompute_mel(const std::string& file, IncrementalMel& mel, double& push_ms) {
+    std::vector<float> pcm;
+    int sample_rate = 0;
+    if (!read_wav(file.c_str(), pcm, sample_rate) || sample_rate != IncrementalMel::kSampleRate) {
+        return false;
+    }
+    std::vector<int16_t> pcm16(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm16[i] = static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, pcm[i])) * 32767.0f));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t read = IncrementalMel::kSampleRate / 10;
+    for (size_t i = 0; i < pcm16.size(); i += read) {
+        mel.push(pcm16.data() + i, std::min(read, pcm16.size() - i));
+    }
+    mel.finish();
+    push_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    hw_log_set_verbose(args.verbose);
+
+    static const char* const kFieldNames[] = {"text", "number", "phone", "email", "url"};
+    const auto field_name = std::find(std::begin(kFieldNames), std::end(kFieldNames), args.field);
+    if (field_name == std::end(kFieldNames)) {
+        fprintf(stderr, "unknown field type: %s\n", args.field.c_str());
+        return 2;
+    }
+    const InputFieldConstraints& field =
+        input_field_constraints(input_field_type_from_int(static_cast<int>(field_name - std::begin(kFieldNames))));
+    if (field.grammar != nullptr && args.grammar.empty()) {
+        args.options.grammar = grammar_compile(field.grammar);
+        args.options.suppress_regex = field.suppress_regex != nullptr ? field.suppress_regex : "";
+        args.options.max_tokens = field.max_tokens;
+    }
+    bool profile_known = false;
+    for (int p = static_cast<int>(DecodeProfile::Fast); p <= static_cast<int>(DecodeProfile::Accurate); p++) {
+        if (args.profile == decode_profile_name(static_cast<DecodeProfile>(p))) {
+            args.options.profile = static_cast<DecodeProfile>(p);
+            profile_known = true;
+        }
+    }
+    if (!profile_known) {
+        fprintf(stderr, "unknown decoding profile: %s\n", args.profile.c_str());
+        return 2;
+    }
+    if (!args.grammar.empty()) {
+        std::ifstream in(args.grammar);
+        std::stringstream text;
+        text << in.rdbuf();
+        args.options.grammar = in ? grammar_compile(text.str()) : nullptr;
+        if (!args.options.grammar) {
+            fprintf(stderr, "failed to compile grammar: %s\n", args.grammar.c_str());
+            return 2;
+        }
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    if (!engine_load_model(args.model.c_str(), args.cache_dir.c_str())) {
+        fprintf(stderr, "failed to load model: %s\n", args.model.c_str());
+        return 1;
+    }
+    const double load_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - load_start).count();
+
+    int failures = 0;
+
+    printf("{\n");
+    printf("  \"model\": \"%s\",\n", json_escape(args.model).c_str());
+    printf("  \"multilingual\": %s,\n", engine_model_is_multilingual() ? "true" : "false");
+    ModelHparams hparams;
+    engine_model_hparams(hparams);
+    printf("  \"encoder_layers\": %d,\n", hparams.n_audio_layer);
+    printf("  \"decoder_layers\": %d,\n", hparams.n_text_layer);
+    printf("  \"mels\": %d,\n", hparams.n_mels);
+    printf("  \"ftype\": %d,\n", hparams.ftype);
+    printf("  \"cpu_variant\": \"%s\",\n", json_escape(cpu_features_variant(cpu_features_probe())).c_str());
+    printf("  \"backends\": \"%s\",\n", json_escape(cpu_backends_describe()).c_str());
+    printf("  \"system_info\": \"%s\",\n", json_escape(whisper_print_system_info()).c_str());
+    printf("  \"threads\": %d,\n", args.options.n_threads);
+    printf("  \"parallel\": %d,\n", args.options.n_parallel);
+    printf("  \"load_ms\": %.2f,\n", load_ms);
+    printf("  \"trim\": %s,\n", args.options.trim.enabled ? "true" : "false");
+    printf("  \"vad\": %s,\n", args.options.vad.enabled ? "true" : "false");
+    printf("  \"speed\": %.2f,\n", args.options.stretch.factor);
+    printf("  \"incremental_mel\": %s,\n", args.incremental_mel ? "true" : "false");
+    printf("  \"encoder_cache\": %d,\n", args.options.encoder_cache);
+    printf("  \"result_cache\": %s,\n", args.options.result_cache ? "true" : "false");
+    printf("  \"grammar\": \"%s\",\n", json_escape(args.grammar).c_str());
+    printf("  \"field\": \"%s\",\n", json_escape(args.field).c_str());
+    printf("  \"profile\": \"%s\",\n", decode_profile_name(args.options.profile));
+    printf("  \"budget_ms\": %d,\n", args.options.budget_ms);
+    printf("  \"repetition_guard\": %s,\n", args.options.repetition_guard ? "true" : "false");
+    printf("  \"runs\": [");
+
+    bool first = true;
+    for (const std::string& file : args.files) {
+        for (int r = 0; r < args.repeat; r++) {
+            // Mel work happens while recording, so it is reported but not part of total_ms
+            IncrementalMel mel(engine_model_n_mels());
+            double mel_push_ms = 0.0;
+            const bool have_mel = args.incremental_mel && precompute_mel(file, mel, mel_push_ms);
+
+            TranscribeResult result;
+            const bool ok = engine_transcribe_file(file.c_str(), args.options, result, have_mel ? &mel : nullptr);
+            if (!ok) {
+                failures++;
+            }
+
+            const double audio_s = static_cast<double>(result.n_samples) / WHISPER_SAMPLE_RATE;
+            const double speech_s = static_cast<double>(result.n_speech_samples) / WHISPER_SAMPLE_RATE;
+            const double trimmed_s = static_cast<double>(result.n_trimmed_leading + result.n_trimmed_trailing) / WHISPER_SAMPLE_RATE;
+            const double total_ms = result.timings.read_ms + result.timings.lookup_ms + result.timings.vad_ms +
+                                    result.timings.detect_ms + result.timings.stretch_ms +
+                                    result.timings.mel_ms + result.timings.full_ms;
+            const double rtf = audio_s > 0.0 ? (total_ms / 1000.0) / audio_s : 0.0;
+
+            printf("%s\n    {\n", first ? "" : ",");
+            first = false;
+            printf("      \"file\": \"%s\",\n", json_escape(file).c_str());
+            printf("      \"iteration\": %d,\n", r);
+            printf("      \"ok\": %s,\n", ok ? "true" : "false");
+            printf("      \"audio_s\": %.3f,\n", audio_s);
+            printf("      \"trimmed_s\": %.3f,\n", trimmed_s);
+            printf("      \"speech_s\": %.3f,\n", speech_s);
+            printf("      \"read_wav_ms\": %.2f,\n", result.timings.read_ms);
+            printf("      \"vad_ms\": %.2f,\n", result.timings.vad_ms);
+            printf("      \"stretch_ms\": %.2f,\n", result.timings.stretch_ms);
+            printf("      \"detect_ms\": %.2f,\n", result.timings.detect_ms);
+            printf("      \"language\": \"%s\",\n",
+                   result.languages.empty() ? "" : json_escape(result.languages[0].language).c_str());
+            printf("      \"language_prob\": %.3f,\n", result.languages.empty() ? 0.0f : result.languages[0].prob);
+            printf("      \"precomputed_mel\": %s,\n", result.precomputed_mel ? "true" : "false");
+            printf("      \"mel_push_ms\": %.2f,\n", mel_push_ms);
+            printf("      \"mel_ms\": %.2f,\n", result.timings.mel_ms);
+            printf("      \"encoder_cache_hit\": %s,\n", result.encoder_cache_hit ? "true" : "false");
+            printf("      \"result_cache_hit\": %s,\n", result.result_cache_hit ? "true" : "false");
+            printf("      \"lookup_ms\": %.3f,\n", result.timings.lookup_ms);
+            printf("      \"transcribe_ms\": %.2f,\n", result.timings.full_ms);
+            printf("      \"encode_ms\": %.2f,\n", result.timings.encode_ms);
+            printf("      \"decode_ms\": %.2f,\n", result.timings.decode_ms);
+            printf("      \"sample_ms\": %.2f,\n", result.timings.sample_ms);
+            printf("      \"rtf\": %.4f,\n", rtf);
+            printf("      \"profile\": \"%s\",\n", decode_profile_name(result.profile));
+            printf("      \"downgraded\": %s,\n", result.downgraded ? "true" : "false");
+            printf("      \"budget_exceeded\": %s,\n", result.budget_exceeded ? "true" : "false");
+            printf("      \"repetition_stops\": %d,\n", result.n_repetition_stops);
+            printf("      \"segments\": %d,\n", result.n_segments);
+            printf("      \"text\": \"%s\"\n", json_escape(result.text).c_str());
+            printf("    }");
+            fflush(stdout);
+        }
+    }
+
+    const EngineCacheStats cache = engine_cache_stats();
+    printf("\n  ],\n");
+    printf("  \"result_cache_hits\": %llu,\n", static_cast<unsigned long long>(cache.result_hits));
+    printf("  \"result_cache_misses\": %llu,\n", static_cast<unsigned long long>(cache.result_misses));
+    printf("  \"encoder_cache_hits\": %llu,\n", static_cast<unsigned long long>(cache.encoder_hits));
+    printf("  \"peak_rss_kb\": %ld\n", peak_rss_kb());
+    printf("}\n");
+
+    engine_unload_model();
+    return failures == 0 ? 0 : 1;
+}
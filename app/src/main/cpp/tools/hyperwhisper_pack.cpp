@@ -0,0 +1,147 @@
+/**
+ * hyperwhisper-pack: re-quantizes whisper GGML models
+ *
+ * Rewrites a model with its weight matrices at one tensor type and prints the
+ * per-group sizes (encoder, decoder, token embedding) as JSON, e.g.:
+ *
+ *   hyperwhisper-pack -m ggml-small.bin -o ggml-small-q8_0.bin --type q8_0
+ *
+ * whisper.cpp loads one weight type per file (see model_pack.h), so there is no
+ * per-group option. --inspect reports whether a file from another tool loads.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "ggml.h"
+#include "model_pack.h"
+#include "tool_common.h"
+
+#define LOG_TAG "Pack"
+#include "hw_log.h"
+
+namespace {
+
+struct PackArgs {
+    std::string model;
+    std::string output;
+    std::string type = "q8_0";
+    bool inspect = false;
+    bool verbose = false;
+};
+
+void print_usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL -o OUT [options]\n"
+            "       %s -m MODEL --inspect\n"
+            "\n"
+            "  -m, --model PATH      ggml model file to pack\n"
+            "  -o, --output PATH     packed model to write\n"
+            "  -t, --type TYPE       weight matrix type (default: q8_0)\n"
+            "      --inspect         print the tensor types of MODEL and whether whisper.cpp loads it as is\n"
+            "  -v, --verbose         print native logs to stderr\n"
+            "\n"
+            "TYPE is one of f32, f16, q4_0, q4_1, q5_0, q5_1, q8_0, q2_k, q3_k, q4_k, q5_k, q6_k\n",
+            argv0, argv0);
+}
+
+bool parse_args(int argc, char** argv, PackArgs& args) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+
+        if (arg == "-m" || arg == "--model") {
+            const char* v = next();
+            if (!v) return false;
+            args.model = v;
+        } else if (arg == "-o" || arg == "--output") {
+            const char* v = next();
+            if (!v) return false;
+            args.output = v;
+        } else if (arg == "-t" || arg == "--type") {
+            const char* v = next();
+            if (!v) return false;
+            args.type = v;
+        } else if (arg == "--inspect") {
+            args.inspect = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            args.verbose = true;
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return !args.model.empty() && (args.inspect || !args.output.empty());
+}
+
+const char* group_type_name(const PackLayout& layout, PackGroup group) {
+    const int g = static_cast<int>(group);
+    if (layout.group_mixed[g]) {
+        return "mixed";
+    }
+    return layout.group_types[g] == GGML_TYPE_COUNT ? "none" : ggml_type_name(layout.group_types[g]);
+}
+
+int inspect(const PackArgs& args) {
+    PackLayout layout;
+    if (!model_pack_inspect(args.model.c_str(), layout)) {
+        fprintf(stderr, "not a GGML whisper model: %s\n", args.model.c_str());
+        return 1;
+    }
+    printf("{\n");
+    printf("  \"model\": \"%s\",\n", json_escape(args.model).c_str());
+    printf("  \"header_type\": \"%s\",\n",
+           layout.header_type == GGML_TYPE_COUNT ? "unknown" : ggml_type_name(layout.header_type));
+    printf("  \"encoder\": \"%s\",\n", group_type_name(layout, PackGroup::Encoder));
+    printf("  \"decoder\": \"%s\",\n", group_type_name(layout, PackGroup::Decoder));
+    printf("  \"embedding\": \"%s\",\n", group_type_name(layout, PackGroup::Embedding));
+    printf("  \"loadable\": %s\n", layout.loadable() ? "true" : "false");
+    printf("}\n");
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    PackArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    hw_log_set_verbose(args.verbose);
+
+    if (args.inspect) {
+        return inspect(args);
+    }
+
+    ggml_type type;
+    if (!pack_type_from_name(args.type, type)) {
+        fprintf(stderr, "unknown type: %s\n", args.type.c_str());
+        return 2;
+    }
+
+    PackStats stats;
+    std::string error;
+    if (!model_pack(args.model.c_str(), args.output.c_str(), type, &stats, error)) {
+        fprintf(stderr, "packing failed: %s\n", error.c_str());
+        return 1;
+    }
+
+    const double mib = 1024.0 * 1024.0;
+    printf("{\n");
+    printf("  \"model\": \"%s\",\n", json_escape(args.model).c_str());
+    printf("  \"output\": \"%s\",\n", json_escape(args.output).c_str());
+    printf("  \"type\": \"%s\",\n", ggml_type_name(type));
+    printf("  \"tensors\": %d,\n", stats.n_tensors);
+    printf("  \"kept_at_source_type\": %d,\n", stats.n_kept);
+    printf("  \"in_mib\": %.1f,\n", stats.bytes_in / mib);
+    printf("  \"out_mib\": %.1f,\n", stats.bytes_out / mib);
+    printf("  \"encoder_mib\": %.1f,\n", stats.group_bytes[static_cast<int>(PackGroup::Encoder)] / mib);
+    printf("  \"decoder_mib\": %.1f,\n", stats.group_bytes[static_cast<int>(PackGroup::Decoder)] / mib);
+    printf("  \"embedding_mib\": %.1f,\n", stats.group_bytes[static_cast<int>(PackGroup::Embedding)] / mib);
+    printf("  \"other_mib\": %.1f\n", stats.group_bytes[static_cast<int>(PackGroup::Other)] / mib);
+    printf("}\n");
+    return 0;
+}
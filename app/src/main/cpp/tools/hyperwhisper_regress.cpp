@@ -0,0 +1,643 @@
+/**
+ * hyperwhisper-regress: end-to-end speed/accuracy regression harness
+ *
+ * Runs every model x thread count x sampling strategy x audio length (x WSOLA
+ * speed-up) over a speech corpus through the native core and records real-time factor, p50/p95
+ * latency, peak memory and WER per configuration. Exits non-zero when a
+ * configuration exceeds its thresholds or regresses against a saved baseline.
+ *
+ *   hyperwhisper-regress -m ggml-tiny.bin -m ggml-base.bin --corpus tools/corpus/manifest.tsv \
+ *       [--threads 1,4] [--strategies greedy,beam] [--lengths 0,30,60] [--speeds 1.0,1.25] [-r 3] \
+ *       [--thresholds tools/corpus/thresholds.tsv] [--baseline base.tsv] [--write-baseline out.tsv]
+ *
+ * Manifest: one "path<TAB>reference transcript" per line, paths relative to
+ * the manifest, '#' comments. Length 0 runs each clip on its own; N > 0 joins
+ * consecutive clips (0.5 s gaps) into items of at least N seconds.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "whisper.h"
+#include "whisper_engine.h"
+#include "audio_converter.h"
+#include "audio_kernels.h"
+#include "cpu_features.h"
+#include "tool_common.h"
+
+#define LOG_TAG "Regress"
+#include "hw_log.h"
+
+namespace {
+
+constexpr float kJoinGapS = 0.5f;
+constexpr int kBeamSize = 5;
+
+struct Clip {
+    std::string path;
+    std::string reference;
+    std::vector<float> pcm; // 16 kHz mono
+};
+
+struct Item {
+    std::string label;
+    std::string reference;
+    std::vector<float> pcm;
+};
+
+struct RegressArgs {
+    std::vector<std::string> models;
+    std::vector<std::string> corpora;
+    std::vector<int> threads = {4};
+    std::vector<std::string> strategies = {"greedy"};
+    std::vector<int> lengths = {0};
+    std::vector<float> speeds = {1.0f};
+    std::string language = "en";
+    std::string thresholds;
+    std::string baseline;
+    std::string write_baseline;
+    double tolerance = 0.15;      // relative slack on rtf / p95 vs baseline
+    double wer_tolerance = 0.01;  // absolute slack on WER vs baseline
+    int repeat = 3;
+    bool vad = true;
+    bool verbose = false;
+};
+
+struct ConfigResult {
+    std::string key;
+    std::string model;
+    std::string strategy;
+    int threads = 0;
+    std::string length;
+    float speed = 1.0f;
+    int runs = 0;
+    int failures = 0;
+    double audio_s = 0.0;
+    double rtf = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double wer = 0.0;
+    long peak_rss_kb = 0;
+};
+
+// model strategy threads length max_rtf max_p95_ms max_wer ('*' matches any, '-' disables a limit)
+struct Threshold {
+    std::string model, strategy, threads, length;
+    double max_rtf = -1.0, max_p95_ms = -1.0, max_wer = -1.0;
+};
+
+void print_usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL [-m MODEL...] --corpus MANIFEST [options]\n"
+            "\n"
+            "  -m, --model PATH          ggml model file (repeatable)\n"
+            "  -c, --corpus PATH         corpus manifest TSV (repeatable)\n"
+            "  -t, --threads LIST        thread counts (default: 4)\n"
+            "  -s, --strategies LIST     greedy,beam (default: greedy)\n"
+            "      --lengths LIST        item lengths in seconds, 0 = per clip (default: 0)\n"
+            "      --speeds LIST         WSOLA speed-ups, 1.0-1.5 (default: 1.0)\n"
+            "  -r, --repeat N            timed runs per item (default: 3)\n"
+            "  -l, --language CODE       decode language (default: en)\n"
+            "      --thresholds PATH     absolute limits TSV\n"
+            "      --baseline PATH       fail on regressions against this baseline TSV\n"
+            "      --write-baseline PATH save this run as a baseline TSV\n"
+            "      --tolerance F         relative rtf/p95 slack vs baseline (default: 0.15)\n"
+            "      --wer-tolerance F     absolute WER slack vs baseline (default: 0.01)\n"
+            "      --no-vad              feed whole items to whisper (skip speech detection)\n"
+            "  -v, --verbose             print native logs to stderr\n",
+            argv0);
+}
+
+bool parse_args(int argc, char** argv, RegressArgs& args) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+        const char* v = nullptr;
+
+        if (arg == "-m" || arg == "--model") {
+            if (!(v = next())) return false;
+            args.models.push_back(v);
+        } else if (arg == "-c" || arg == "--corpus") {
+            if (!(v = next())) return false;
+            args.corpora.push_back(v);
+        } else if (arg == "-t" || arg == "--threads") {
+            if (!(v = next())) return false;
+            args.threads = split_int_list(v);
+        } else if (arg == "-s" || arg == "--strategies") {
+            if (!(v = next())) return false;
+            args.strategies = split_list(v);
+        } else if (arg == "--lengths") {
+            if (!(v = next())) return false;
+            args.lengths = split_int_list(v);
+        } else if (arg == "--speeds") {
+            if (!(v = next())) return false;
+            args.speeds.clear();
+            for (const std::string& s : split_list(v)) {
+                args.speeds.push_back(static_cast<float>(atof(s.c_str())));
+            }
+        } else if (arg == "-r" || arg == "--repeat") {
+            if (!(v = next())) return false;
+            args.repeat = atoi(v);
+        } else if (arg == "-l" || arg == "--language") {
+            if (!(v = next())) return false;
+            args.language = v;
+        } else if (arg == "--thresholds") {
+            if (!(v = next())) return false;
+            args.thresholds = v;
+        } else if (arg == "--baseline") {
+            if (!(v = next())) return false;
+            args.baseline = v;
+        } else if (arg == "--write-baseline") {
+            if (!(v = next())) return false;
+            args.write_baseline = v;
+        } else if (arg == "--tolerance") {
+            if (!(v = next())) return false;
+            args.tolerance = atof(v);
+        } else if (arg == "--wer-tolerance") {
+            if (!(v = next())) return false;
+            args.wer_tolerance = atof(v);
+        } else if (arg == "--no-vad") {
+            args.vad = false;
+        } else if (arg == "-v" || arg == "--verbose") {
+            args.verbose = true;
+        } else {
+            if (arg != "-h" && arg != "--help") {
+                fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            }
+            return false;
+        }
+    }
+
+    for (const std::string& s : args.strategies) {
+        if (s != "greedy" && s != "beam") {
+            fprintf(stderr, "unknown strategy: %s\n", s.c_str());
+            return false;
+        }
+    }
+    for (int t : args.threads) {
+        if (t <= 0) return false;
+    }
+    for (float s : args.speeds) {
+        if (s < 1.0f || s > 1.5f) {
+            fprintf(stderr, "speed out of range [1.0, 1.5]: %.2f\n", s);
+            return false;
+        }
+    }
+    return !args.models.empty() && !args.corpora.empty() && !args.threads.empty() &&
+           !args.strategies.empty() && !args.lengths.empty() && !args.speeds.empty() && args.repeat > 0;
+}
+
+std::string basename_of(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string dirname_of(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+bool load_wav_16k(const std::string& path, std::vector<float>& pcm) {
+    std::vector<float> raw;
+    int rate = 0;
+    if (!read_wav(path.c_str(), raw, rate)) {
+        return false;
+    }
+    if (rate == WHISPER_SAMPLE_RATE) {
+        pcm = std::move(raw);
+    } else {
+        resample_linear(raw.data(), raw.size(), rate, WHISPER_SAMPLE_RATE, pcm);
+    }
+    return true;
+}
+
+bool load_corpus(const std::string& manifest, std::vector<Clip>& clips) {
+    std::ifstream in(manifest);
+    if (!in) {
+        fprintf(stderr, "cannot open corpus manifest: %s\n", manifest.c_str());
+        return false;
+    }
+    const std::string base = dirname_of(manifest);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            fprintf(stderr, "%s: malformed line: %s\n", manifest.c_str(), line.c_str());
+            return false;
+        }
+        Clip clip;
+        clip.path = line.substr(0, tab);
+        if (clip.path[0] != '/') {
+            clip.path = base + "/" + clip.path;
+        }
+        clip.reference = line.substr(tab + 1);
+        if (!load_wav_16k(clip.path, clip.pcm)) {
+            fprintf(stderr, "cannot read corpus clip: %s\n", clip.path.c_str());
+            return false;
+        }
+        clips.push_back(std::move(clip));
+    }
+    return true;
+}
+
+std::vector<Item> build_items(const std::vector<Clip>& clips, int length_s) {
+    std::vector<Item> items;
+    if (length_s <= 0) {
+        for (const Clip& clip : clips) {
+            items.push_back({basename_of(clip.path), clip.reference, clip.pcm});
+        }
+        return items;
+    }
+
+    // Join consecutive clips until each item reaches length_s; the remainder is dropped
+    const size_t target = static_cast<size_t>(length_s) * WHISPER_SAMPLE_RATE;
+    const size_t gap = static_cast<size_t>(kJoinGapS * WHISPER_SAMPLE_RATE);
+    Item current;
+    for (const Clip& clip : clips) {
+        if (!current.pcm.empty()) {
+            current.pcm.insert(current.pcm.end(), gap, 0.0f);
+            current.reference += " ";
+        }
+        current.pcm.insert(current.pcm.end(), clip.pcm.begin(), clip.pcm.end());
+        current.reference += clip.reference;
+        if (current.pcm.size() >= target) {
+            current.label = std::to_string(length_s) + "s#" + std::to_string(items.size());
+            items.push_back(std::move(current));
+            current = Item();
+        }
+    }
+    if (items.empty() && !current.pcm.empty()) {
+        // Corpus shorter than the requested length: keep one item with everything
+        current.label = std::to_string(length_s) + "s#0";
+        items.push_back(std::move(current));
+    }
+    return items;
+}
+
+// Lowercase, keep letters, digits and apostrophes, split on everything else
+std::vector<std::string> normalize_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '\'' || c >= 0x80) {
+            word += static_cast<char>(std::tolower(c));
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Word-level Levenshtein distance
+size_t word_errors(const std::vector<std::string>& ref, const std::vector<std::string>& hyp) {
+    std::vector<size_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); j++) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= ref.size(); i++) {
+        cur[0] = i;
+        for (size_t j = 1; j <= hyp.size(); j++) {
+            const size_t sub = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+            cur[j] = std::min({sub, prev[j] + 1, cur[j - 1] + 1});
+        }
+        std::swap(prev, cur);
+    }
+    return prev[hyp.size()];
+}
+
+// Nearest-rank percentile
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+std::string length_label(int length_s) {
+    return length_s <= 0 ? "clips" : std::to_string(length_s) + "s";
+}
+
+// Speed-up suffix for keys; 1.0 keeps the key format of baselines written before --speeds
+std::string speed_label(float speed) {
+    if (speed <= 1.0f) {
+        return "";
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "/x%.2f", speed);
+    return buf;
+}
+
+ConfigResult run_config(const std::string& model, const std::string& strategy, int threads, int length_s, float speed,
+                        const std::vector<Item>& items, const RegressArgs& args) {
+    ConfigResult r;
+    r.model = model;
+    r.strategy = strategy;
+    r.threads = threads;
+    r.length = length_label(length_s);
+    r.speed = speed;
+    r.key = model + "/" + strategy + "/t" + std::to_string(threads) + "/" + r.length + speed_label(speed);
+
+    TranscribeOptions options;
+    options.language = args.language;
+    options.n_threads = threads;
+    options.beam_size = strategy == "beam" ? kBeamSize : 0;
+    options.vad.enabled = args.vad;
+    options.stretch.factor = speed;
+
+    reset_peak_rss();
+
+    // Warm-up run so first-touch page faults and allocator growth stay out of the percentiles
+    if (!items.empty()) {
+        TranscribeResult warmup;
+        engine_transcribe_pcm(items[0].pcm, options, warmup);
+    }
+
+    std::vector<double> latencies;
+    double total_ms = 0.0;
+    size_t errors = 0;
+    size_t ref_words = 0;
+    for (const Item& item : items) {
+        for (int run = 0; run < args.repeat; run++) {
+            TranscribeResult result;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = engine_transcribe_pcm(item.pcm, options, result);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            r.runs++;
+            if (!ok) {
+                r.failures++;
+                continue;
+            }
+            latencies.push_back(ms);
+            total_ms += ms;
+            r.audio_s += static_cast<double>(item.pcm.size()) / WHISPER_SAMPLE_RATE;
+
+            // Decoding is deterministic at temperature 0, so score the first run only
+            if (run == 0) {
+                const std::vector<std::string> ref = normalize_words(item.reference);
+                errors += word_errors(ref, normalize_words(result.text));
+                ref_words += ref.size();
+                if (args.verbose) {
+                    fprintf(stderr, "[%s] %s: %s\n", r.key.c_str(), item.label.c_str(), result.text.c_str());
+                }
+            }
+        }
+    }
+
+    r.rtf = r.audio_s > 0.0 ? (total_ms / 1000.0) / r.audio_s : 0.0;
+    r.p50_ms = percentile(latencies, 50.0);
+    r.p95_ms = percentile(latencies, 95.0);
+    r.wer = ref_words > 0 ? static_cast<double>(errors) / ref_words : 0.0;
+    r.peak_rss_kb = current_peak_rss_kb();
+    return r;
+}
+
+double parse_limit(const std::string& s) {
+    return s == "-" ? -1.0 : atof(s.c_str());
+}
+
+bool load_thresholds(const std::string& path, std::vector<Threshold>& out) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot open thresholds: %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        Threshold t;
+        std::string rtf, p95, wer;
+        if (!(fields >> t.model >> t.strategy >> t.threads >> t.length >> rtf >> p95 >> wer)) {
+            fprintf(stderr, "%s: malformed line: %s\n", path.c_str(), line.c_str());
+            return false;
+        }
+        t.max_rtf = parse_limit(rtf);
+        t.max_p95_ms = parse_limit(p95);
+        t.max_wer = parse_limit(wer);
+        out.push_back(t);
+    }
+    return true;
+}
+
+bool field_matches(const std::string& pattern, const std::string& value) {
+    return pattern == "*" || pattern == value;
+}
+
+bool load_baseline(const std::string& path, std::map<std::string, ConfigResult>& out) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot open baseline: %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        ConfigResult r;
+        if (fields >> r.key >> r.rtf >> r.p50_ms >> r.p95_ms >> r.wer >> r.peak_rss_kb) {
+            out[r.key] = r;
+        }
+    }
+    return true;
+}
+
+bool write_baseline(const std::string& path, const std::vector<ConfigResult>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot write baseline: %s\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "# key\trtf\tp50_ms\tp95_ms\twer\tpeak_rss_kb\n");
+    for (const ConfigResult& r : results) {
+        fprintf(f, "%s\t%.4f\t%.2f\t%.2f\t%.4f\t%ld\n", r.key.c_str(), r.rtf, r.p50_ms, r.p95_ms, r.wer, r.peak_rss_kb);
+    }
+    return fclose(f) == 0;
+}
+
+std::vector<std::string> check_result(const ConfigResult& r, const std::vector<Threshold>& thresholds,
+                                      const std::map<std::string, ConfigResult>& baseline, const RegressArgs& args) {
+    std::vector<std::string> problems;
+    char buf[256];
+
+    if (r.failures > 0) {
+        snprintf(buf, sizeof(buf), "%d of %d runs failed", r.failures, r.runs);
+        problems.push_back(buf);
+    }
+
+    // Absolute limits describe the shipped (uncompressed) path; speed-up rows are trade-off data
+    for (const Threshold& t : thresholds) {
+        if (r.speed > 1.0f || !field_matches(t.model, r.model) || !field_matches(t.strategy, r.strategy) ||
+            !field_matches(t.threads, std::to_string(r.threads)) || !field_matches(t.length, r.length)) {
+            continue;
+        }
+        if (t.max_rtf >= 0.0 && r.rtf > t.max_rtf) {
+            snprintf(buf, sizeof(buf), "rtf %.3f > limit %.3f", r.rtf, t.max_rtf);
+            problems.push_back(buf);
+        }
+        if (t.max_p95_ms >= 0.0 && r.p95_ms > t.max_p95_ms) {
+            snprintf(buf, sizeof(buf), "p95 %.0f ms > limit %.0f ms", r.p95_ms, t.max_p95_ms);
+            problems.push_back(buf);
+        }
+        if (t.max_wer >= 0.0 && r.wer > t.max_wer) {
+            snprintf(buf, sizeof(buf), "wer %.4f > limit %.4f", r.wer, t.max_wer);
+            problems.push_back(buf);
+        }
+    }
+
+    const auto it = baseline.find(r.key);
+    if (it != baseline.end()) {
+        const ConfigResult& b = it->second;
+        if (b.rtf > 0.0 && r.rtf > b.rtf * (1.0 + args.tolerance)) {
+            snprintf(buf, sizeof(buf), "rtf %.3f regressed from baseline %.3f", r.rtf, b.rtf);
+            problems.push_back(buf);
+        }
+        if (b.p95_ms > 0.0 && r.p95_ms > b.p95_ms * (1.0 + args.tolerance)) {
+            snprintf(buf, sizeof(buf), "p95 %.0f ms regressed from baseline %.0f ms", r.p95_ms, b.p95_ms);
+            problems.push_back(buf);
+        }
+        if (r.wer > b.wer + args.wer_tolerance) {
+            snprintf(buf, sizeof(buf), "wer %.4f regressed from baseline %.4f", r.wer, b.wer);
+            problems.push_back(buf);
+        }
+    }
+    return problems;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    RegressArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    hw_log_set_verbose(args.verbose);
+
+    std::vector<Clip> clips;
+    for (const std::string& manifest : args.corpora) {
+        if (!load_corpus(manifest, clips)) {
+            return 2;
+        }
+    }
+    if (clips.empty()) {
+        fprintf(stderr, "corpus is empty\n");
+        return 2;
+    }
+
+    std::vector<Threshold> thresholds;
+    if (!args.thresholds.empty() && !load_thresholds(args.thresholds, thresholds)) {
+        return 2;
+    }
+    std::map<std::string, ConfigResult> baseline;
+    if (!args.baseline.empty() && !load_baseline(args.baseline, baseline)) {
+        return 2;
+    }
+
+    std::vector<ConfigResult> results;
+    std::vector<std::pair<std::string, std::string>> failures;
+    int load_failures = 0;
+
+    printf("{\n");
+    printf("  \"cpu_variant\": \"%s\",\n", json_escape(cpu_features_variant(cpu_features_probe())).c_str());
+    printf("  \"system_info\": \"%s\",\n", json_escape(whisper_print_system_info()).c_str());
+    printf("  \"clips\": %zu,\n", clips.size());
+    printf("  \"repeat\": %d,\n", args.repeat);
+    printf("  \"configs\": [");
+
+    bool first = true;
+    for (const std::string& model_path : args.models) {
+        const std::string model = basename_of(model_path);
+        if (!engine_load_model(model_path.c_str(), nullptr)) {
+            fprintf(stderr, "failed to load model: %s\n", model_path.c_str());
+            failures.emplace_back(model, "model failed to load");
+            load_failures++;
+            continue;
+        }
+        // Distilled and turbo checkpoints differ from tiny/base/small mainly in decoder depth
+        ModelHparams hparams;
+        engine_model_hparams(hparams);
+
+        for (int length_s : args.lengths) {
+            const std::vector<Item> items = build_items(clips, length_s);
+            for (const std::string& strategy : args.strategies) {
+                for (int threads : args.threads) {
+                    for (float speed : args.speeds) {
+                        const ConfigResult r = run_config(model, strategy, threads, length_s, speed, items, args);
+                        results.push_back(r);
+
+                        const std::vector<std::string> problems = check_result(r, thresholds, baseline, args);
+                        for (const std::string& p : problems) {
+                            failures.emplace_back(r.key, p);
+                        }
+
+                        printf("%s\n    {\n", first ? "" : ",");
+                        first = false;
+                        printf("      \"key\": \"%s\",\n", json_escape(r.key).c_str());
+                        printf("      \"model\": \"%s\",\n", json_escape(r.model).c_str());
+                        printf("      \"decoder_layers\": %d,\n", hparams.n_text_layer);
+                        printf("      \"mels\": %d,\n", hparams.n_mels);
+                        printf("      \"strategy\": \"%s\",\n", r.strategy.c_str());
+                        printf("      \"threads\": %d,\n", r.threads);
+                        printf("      \"length\": \"%s\",\n", r.length.c_str());
+                        printf("      \"speed\": %.2f,\n", r.speed);
+                        printf("      \"items\": %zu,\n", items.size());
+                        printf("      \"runs\": %d,\n", r.runs);
+                        printf("      \"failed_runs\": %d,\n", r.failures);
+                        printf("      \"audio_s\": %.3f,\n", r.audio_s);
+                        printf("      \"rtf\": %.4f,\n", r.rtf);
+                        printf("      \"p50_ms\": %.2f,\n", r.p50_ms);
+                        printf("      \"p95_ms\": %.2f,\n", r.p95_ms);
+                        printf("      \"wer\": %.4f,\n", r.wer);
+                        printf("      \"peak_rss_kb\": %ld,\n", r.peak_rss_kb);
+                        printf("      \"ok\": %s\n", problems.empty() ? "true" : "false");
+                        printf("    }");
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+        engine_unload_model();
+    }
+
+    printf("\n  ],\n");
+    printf("  \"regressions\": [");
+    for (size_t i = 0; i < failures.size(); i++) {
+        printf("%s\n    {\"key\": \"%s\", \"reason\": \"%s\"}", i == 0 ? "" : ",",
+               json_escape(failures[i].first).c_str(), json_escape(failures[i].second).c_str());
+    }
+    printf("%s]\n", failures.empty() ? "" : "\n  ");
+    printf("}\n");
+
+    for (const auto& f : failures) {
+        fprintf(stderr, "REGRESSION %s: %s\n", f.first.c_str(), f.second.c_str());
+    }
+
+    if (!args.write_baseline.empty() && load_failures == 0) {
+        write_baseline(args.write_baseline, results);
+    }
+    return failures.empty() ? 0 : 1;
+}
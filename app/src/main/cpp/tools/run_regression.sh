@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+#
+# Host speed/accuracy regression run over every WhisperModel variant
+#
+#   app/src/main/cpp/tools/run_regression.sh [--baseline FILE] [--write-baseline FILE] [extra hyperwhisper-regress args]
+#
+# Builds the host tools, fetches the models (same URLs as WhisperModel in
+# Models.kt) and the LibriSpeech subset, then runs hyperwhisper-regress across
+# thread counts, greedy/beam sampling and 30/60 s long-form items. Exits
+# non-zero on any regression.
+#
+# Environment: HW_MODELS (default "tiny base small"; add e.g. "distil-small.en large-v3-turbo-q5_0"
+# to compare the reduced-decoder checkpoints on the same corpus), HW_THREADS (default "1,4,8"),
+# HW_SPEEDS (WSOLA speed-ups, default "1.0"; e.g. "1.0,1.25,1.5" for the RTF/WER trade-off),
+# HW_BUILD_DIR (default build-host), HW_MODEL_CACHE (default ~/.cache/hyperwhisper/models)
+
+set -euo pipefail
+
+HERE="$(cd "$(dirname "$0")" && pwd)"
+SRC="$(cd "$HERE/.." && pwd)"
+BUILD="${HW_BUILD_DIR:-build-host}"
+MODELS="${HW_MODELS:-tiny base small}"
+THREADS="${HW_THREADS:-1,4,8}"
+SPEEDS="${HW_SPEEDS:-1.0}"
+MODEL_CACHE="${HW_MODEL_CACHE:-$HOME/.cache/hyperwhisper/models}"
+
+cmake -S "$SRC" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release > /dev/null
+cmake --build "$BUILD" -j"$(nproc)" --target hyperwhisper-regress
+
+"$HERE/corpus/fetch_librispeech.sh"
+
+# distil-whisper publishes its GGML conversions next to the checkpoints
+model_url() {
+    case "$1" in
+        distil-*) echo "https://hf.co/distil-whisper/$1/resolve/main/ggml-$1.bin" ;;
+        *) echo "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-$1.bin" ;;
+    esac
+}
+
+mkdir -p "$MODEL_CACHE"
+model_args=()
+for name in $MODELS; do
+    file="$MODEL_CACHE/ggml-$name.bin"
+    if [ ! -f "$file" ]; then
+        echo "Downloading ggml-$name.bin..."
+        curl -L --fail -o "$file.part" "$(model_url "$name")"
+        mv "$file.part" "$file"
+    fi
+    model_args+=(-m "$file")
+done
+
+"$BUILD/bin/hyperwhisper-regress" \
+    "${model_args[@]}" \
+    --corpus "$HERE/corpus/manifest.tsv" \
+    --corpus "$HERE/corpus/librispeech.tsv" \
+    --threads "$THREADS" \
+    --strategies greedy,beam \
+    --lengths 0,30,60 \
+    --speeds "$SPEEDS" \
+    --thresholds "$HERE/corpus/thresholds.tsv" \
+    "$@"
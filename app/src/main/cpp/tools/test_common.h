@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * Minimal check macros for the host tests run by ctest (no framework dependency)
+ */
+
+#include <cstdio>
+
+inline int g_test_failures = 0;
+
+#define EXPECT(cond)                                                              \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            fprintf(stderr, "%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_test_failures++;                                                    \
+        }                                                                         \
+    } while (0)
+
+#define EXPECT_EQ(a, b)                                                                         \
+    do {                                                                                        \
+        if (!((a) == (b))) {                                                                    \
+            fprintf(stderr, "%s:%d: EXPECT_EQ(%s, %s) failed\n", __FILE__, __LINE__, #a, #b);   \
+            g_test_failures++;                                                                  \
+        }                                                                                       \
+    } while (0)
+
+/**
+ * Exit code for main: non-zero when any check failed
+ */
+inline int test_result(const char* name) {
+    if (g_test_failures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, g_test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * test-incremental-mel: IncrementalMel::build against whisper_pcm_to_mel
+ *
+ * Feeds a synthetic recording through IncrementalMel in uneven reads and
+ * builds the mel for whole, trimmed and VAD-packed ranges (hop-aligned and
+ * not). Every spectrogram is checked frame by frame against a double-precision
+ * port of whisper.cpp's log_mel_spectrogram on the joined PCM (whisper.h has
+ * no accessor for the mel it computes). With a model path argument the same
+ * inputs also go through whisper itself: whisper_pcm_to_mel and whisper_set_mel
+ * with the built mel must yield the same first decoder step.
+ *
+ *   test-incremental-mel [ggml-model.bin]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "whisper.h"
+#include "audio_kernels.h"
+#include "incremental_mel.h"
+#include "vad.h"
+#include "test_common.h"
+
+namespace {
+
+constexpr int kSampleRate = IncrementalMel::kSampleRate;
+constexpr size_t kFrameSize = IncrementalMel::kFrameSize;
+constexpr size_t kFrameStep = IncrementalMel::kFrameStep;
+constexpr size_t kGap = kSampleRate / 10;     // VadOptions::gap_ms default
+constexpr float kMelTolerance = 2e-3f;        // Normalized mel units ((log10 + 4) / 4)
+constexpr float kLogitTolerance = 0.1f;
+
+struct Case {
+    const char* name;
+    std::vector<MelRange> ranges;
+    size_t gap;
+};
+
+/**
+ * 4 s of tone bursts on a rising chirp over low noise: frames shifted by part of a hop differ clearly
+ */
+std::vector<int16_t> make_recording() {
+    const size_t n = static_cast<size_t>(kSampleRate) * 4;
+    std::vector<int16_t> pcm(n);
+    uint32_t seed = 12345;
+    double phase = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double t = static_cast<double>(i) / kSampleRate;
+        phase += 2.0 * M_PI * (200.0 + 700.0 * t) / kSampleRate;
+        const double envelope = std::fmod(t, 0.3) < 0.15 ? 0.5 : 0.05;
+        seed = seed * 1664525u + 1013904223u;
+        const double noise = (static_cast<double>(seed >> 8) / (1u << 24) - 0.5) * 0.002;
+        pcm[i] = static_cast<int16_t>(std::lround((envelope * std::sin(phase) + noise) * 32767.0));
+    }
+    return pcm;
+}
+
+double hz_to_mel(double hz) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double logstep = std::log(6.4) / 27.0;
+    return hz < min_log_hz ? hz / f_sp : min_log_hz / f_sp + std::log(hz / min_log_hz) / logstep;
+}
+
+double mel_to_hz(double mel) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_mel = 1000.0 / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    return mel < min_log_mel ? mel * f_sp : 1000.0 * std::exp(logstep * (mel - min_log_mel));
+}
+
+/**
+ * whisper.cpp's log_mel_spectrogram (reflective 200-sample head, 30 s of zeros, Hann, |DFT|^2,
+ * Slaney filters as in mel_filters.npz, log10, clamp to max - 8, (x + 4) / 4), in double precision
+ */
+std::vector<float> reference_mel(const std::vector<float>& pcm, int n_mels, int& n_len) {
+    const size_t n = pcm.size();
+    const size_t pad = kFrameSize / 2;
+    std::vector<double> padded(n + static_cast<size_t>(kSampleRate) * 30 + 2 * pad, 0.0);
+    std::copy(pcm.begin(), pcm.end(), padded.begin() + pad);
+    for (size_t j = 0; j < pad; j++) {
+        padded[j] = pad - j < n ? pcm[pad - j] : 0.0;
+    }
+    n_len = static_cast<int>((padded.size() - kFrameSize) / kFrameStep);
+
+    const size_t n_bins = kFrameSize / 2 + 1;
+    std::vector<double> filters(static_cast<size_t>(n_mels) * n_bins, 0.0);
+    const double max_mel = hz_to_mel(kSampleRate / 2.0);
+    for (int m = 0; m < n_mels; m++) {
+        const double lo = mel_to_hz(max_mel * m / (n_mels + 1));
+        const double mid = mel_to_hz(max_mel * (m + 1) / (n_mels + 1));
+        const double hi = mel_to_hz(max_mel * (m + 2) / (n_mels + 1));
+        for (size_t k = 0; k < n_bins; k++) {
+            const double f = static_cast<double>(k) * kSampleRate / kFrameSize;
+            const double w = std::max(0.0, std::min((f - lo) / (mid - lo), (hi - f) / (hi - mid)));
+            filters[m * n_bins + k] = w * 2.0 / (hi - lo);
+        }
+    }
+
+    std::vector<double> hann(kFrameSize);
+    for (size_t i = 0; i < kFrameSize; i++) {
+        hann[i] = 0.5 * (1.0 - std::cos(2.0 * M_PI * i / kFrameSize));
+    }
+
+    std::vector<float> mel(static_cast<size_t>(n_mels) * n_len, -10.0f);
+    std::vector<double> power(n_bins);
+    double mmax = -1e20;
+    for (int i = 0; i < n_len; i++) {
+        const size_t offset = static_cast<size_t>(i) * kFrameStep;
+        // Frames past the audio see only zeros
+        if (offset >= n + pad) {
+            mmax = std::max(mmax, -10.0);
+            continue;
+        }
+        for (size_t k = 0; k < n_bins; k++) {
+            double re = 0.0, im = 0.0;
+            for (size_t t = 0; t < kFrameSize; t++) {
+                const double x = padded[offset + t] * hann[t];
+                const double angle = 2.0 * M_PI * static_cast<double>(k * t % kFrameSize) / kFrameSize;
+                re += x * std::cos(angle);
+                im -= x * std::sin(angle);
+            }
+            power[k] = re * re + im * im;
+        }
+        for (int m = 0; m < n_mels; m++) {
+            double sum = 0.0;
+            for (size_t k = 0; k < n_bins; k++) {
+                sum += filters[m * n_bins + k] * power[k];
+            }
+            const double v = std::log10(std::max(sum, 1e-10));
+            mel[static_cast<size_t>(m) * n_len + i] = static_cast<float>(v);
+            mmax = std::max(mmax, v);
+        }
+    }
+    for (float& v : mel) {
+        v = static_cast<float>((std::max(static_cast<double>(v), mmax - 8.0) + 4.0) / 4.0);
+    }
+    return mel;
+}
+
+/**
+ * The PCM whisper sees for ranges: VadTimeline::pack, as the engine joins VAD intervals
+ */
+std::vector<float> joined_pcm(const std::vector<float>& recording, const Case& c) {
+    std::vector<SpeechInterval> intervals;
+    for (const MelRange& range : c.ranges) {
+        intervals.push_back({range.start, range.end});
+    }
+    VadTimeline timeline;
+    std::vector<float> out;
+    timeline.pack(recording.data(), intervals, c.gap, out);
+    return out;
+}
+
+/**
+ * Logits of the first decoder step after encoding the context's current mel
+ */
+bool first_step_logits(whisper_context* ctx, std::vector<float>& logits) {
+    if (whisper_encode(ctx, 0, 4) != 0) {
+        return false;
+    }
+    std::vector<whisper_token> tokens = {whisper_token_sot(ctx)};
+    if (whisper_is_multilingual(ctx)) {
+        tokens.push_back(whisper_token_lang(ctx, whisper_lang_id("en")));
+        tokens.push_back(whisper_token_transcribe(ctx));
+    }
+    tokens.push_back(whisper_token_not(ctx));
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (whisper_decode(ctx, &tokens[i], 1, static_cast<int>(i), 4) != 0) {
+            return false;
+        }
+    }
+    const float* out = whisper_get_logits(ctx);
+    logits.assign(out, out + whisper_n_vocab(ctx));
+    return true;
+}
+
+void compare_with_whisper(whisper_context* ctx, const Case& c, const std::vector<float>& pcm,
+                          const std::vector<float>& built, int n_len) {
+    std::vector<float> expected, actual;
+    EXPECT(whisper_pcm_to_mel(ctx, pcm.data(), static_cast<int>(pcm.size()), 4) == 0);
+    EXPECT(first_step_logits(ctx, expected));
+    EXPECT(whisper_set_mel(ctx, built.data(), n_len, whisper_model_n_mels(ctx)) == 0);
+    EXPECT(first_step_logits(ctx, actual));
+    EXPECT_EQ(expected.size(), actual.size());
+    if (expected.empty() || expected.size() != actual.size()) {
+        return;
+    }
+
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++) {
+        max_diff = std::max(max_diff, std::fabs(expected[i] - actual[i]));
+    }
+    const auto best = [](const std::vector<float>& v) { return std::max_element(v.begin(), v.end()) - v.begin(); };
+    printf("  %-16s whisper logits max diff %.5f\n", c.name, max_diff);
+    EXPECT(max_diff < kLogitTolerance);
+    EXPECT_EQ(best(expected), best(actual));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::vector<int16_t> recording = make_recording();
+    const size_t n = recording.size();
+    std::vector<float> recording_f(n);
+    pcm16_to_float(recording.data(), recording_f.data(), n);
+
+    whisper_context* ctx = nullptr;
+    if (argc > 1) {
+        whisper_context_params cparams = whisper_context_default_params();
+        cparams.use_gpu = false;
+        ctx = whisper_init_from_file_with_params(argv[1], cparams);
+        EXPECT(ctx != nullptr);
+    } else {
+        printf("No model given: checking against the reference mel only\n");
+    }
+    const int n_mels = ctx != nullptr ? whisper_model_n_mels(ctx) : 80;
+
+    // Uneven reads, starting below the 200-sample reflection pad
+    IncrementalMel mel(n_mels);
+    const size_t reads[] = {37, 1601, 160, 4003};
+    for (size_t pos = 0, i = 0; pos < n; i++) {
+        const size_t count = std::min(reads[i % 4], n - pos);
+        mel.push(recording.data() + pos, count);
+        pos += count;
+    }
+    mel.finish();
+    EXPECT_EQ(mel.n_samples(), n);
+
+    const std::vector<Case> cases = {
+        {"whole", {{0, n}}, 0},
+        {"trimmed", {{1234, n - 777}}, 0},
+        {"vad-aligned", {{3200, 20800}, {32000, 48000}}, kGap},
+        {"vad-unaligned", {{1111, 20005}, {27777, 50001}, {55555, 63333}}, kGap},
+    };
+    for (const Case& c : cases) {
+        const std::vector<float> pcm = joined_pcm(recording_f, c);
+        std::vector<float> built;
+        int n_len = 0;
+        size_t n_audio = 0;
+        mel.build(c.ranges, c.gap, built, n_len, n_audio);
+        EXPECT_EQ(n_audio, pcm.size());
+
+        int ref_len = 0;
+        const std::vector<float> ref = reference_mel(pcm, n_mels, ref_len);
+        EXPECT_EQ(n_len, ref_len);
+        if (n_len != ref_len) {
+            continue;
+        }
+        float max_diff = 0.0f;
+        size_t worst = 0;
+        for (size_t i = 0; i < ref.size(); i++) {
+            const float diff = std::fabs(ref[i] - built[i]);
+            if (diff > max_diff) {
+                max_diff = diff;
+                worst = i % static_cast<size_t>(n_len);
+            }
+        }
+        printf("  %-16s %d frames, max mel diff %.6f (frame %zu)\n", c.name, n_len, max_diff, worst);
+        EXPECT(max_diff < kMelTolerance);
+
+        if (ctx != nullptr) {
+            compare_with_whisper(ctx, c, pcm, built, n_len);
+        }
+    }
+
+    if (ctx != nullptr) {
+        whisper_free(ctx);
+    }
+    return test_result("test-incremental-mel");
+}
@@ -0,0 +1,82 @@
+/**
+ * test-long-form: overlap_word_count and drop_leading_words, as the chunk merge uses them
+ *
+ *   test-long-form
+ */
+
+#include <string>
+#include "long_form.h"
+#include "test_common.h"
+
+namespace {
+
+void test_overlap_word_count() {
+    // Two shared words across the cut are removed
+    EXPECT_EQ(overlap_word_count(" we went to the park", " the park was closed"), 2u);
+    // Case and punctuation do not matter
+    EXPECT_EQ(overlap_word_count(" We went to the Park.", " the park, was closed"), 2u);
+    // The longest match wins
+    EXPECT_EQ(overlap_word_count(" a b c a b", " a b c a b d"), 5u);
+
+    // One shared word is below the default min_words: likely said twice, not overlap
+    EXPECT_EQ(overlap_word_count(" I said that", " that was it"), 0u);
+    EXPECT_EQ(overlap_word_count(" no", " no no"), 0u);
+    // ...unless the caller accepts single words
+    EXPECT_EQ(overlap_word_count(" I said that", " that was it", 12, 1), 1u);
+
+    // max_words bounds the search
+    EXPECT_EQ(overlap_word_count(" one two three four", " one two three four five", 3), 0u);
+    EXPECT_EQ(overlap_word_count(" x one two three", " one two three y", 3), 3u);
+
+    // Nothing shared, or nothing to compare
+    EXPECT_EQ(overlap_word_count(" we went home", " the park was closed"), 0u);
+    EXPECT_EQ(overlap_word_count("", " the park"), 0u);
+    EXPECT_EQ(overlap_word_count(" the park", ""), 0u);
+}
+
+void test_drop_leading_words() {
+    std::string one = " park was closed";
+    EXPECT_EQ(drop_leading_words(one, 1), 1u);
+    EXPECT_EQ(one, std::string(" was closed"));
+
+    std::string two = " the park was closed";
+    EXPECT_EQ(drop_leading_words(two, 2), 2u);
+    EXPECT_EQ(two, std::string(" was closed"));
+
+    // Punctuation-only tokens are dropped along with the words but not counted
+    std::string dashed = " - the park - was closed";
+    EXPECT_EQ(drop_leading_words(dashed, 2), 2u);
+    EXPECT_EQ(dashed, std::string(" - was closed"));
+
+    // Fewer words than requested: everything goes, the count says how many were there
+    std::string short_text = " the park";
+    EXPECT_EQ(drop_leading_words(short_text, 3), 2u);
+    EXPECT(short_text.empty());
+
+    std::string untouched = " the park";
+    EXPECT_EQ(drop_leading_words(untouched, 0), 0u);
+    EXPECT_EQ(untouched, std::string(" the park"));
+}
+
+void test_merge() {
+    // The chunk merge: count against the merged tail, then drop across segments
+    const std::string tail = " and then we went to the park";
+    std::string first = " the";
+    std::string second = " park was closed.";
+    size_t remaining = overlap_word_count(tail, first + second);
+    EXPECT_EQ(remaining, 2u);
+    remaining -= drop_leading_words(first, remaining);
+    remaining -= drop_leading_words(second, remaining);
+    EXPECT_EQ(remaining, 0u);
+    EXPECT(first.empty());
+    EXPECT_EQ(second, std::string(" was closed."));
+}
+
+} // namespace
+
+int main() {
+    test_overlap_word_count();
+    test_drop_leading_words();
+    test_merge();
+    return test_result("test-long-form");
+}
@@ -0,0 +1,184 @@
+/**
+ * test-result-cache: ResultCache hits and misses across audio, model and option changes
+ *
+ *   test-result-cache
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "result_cache.h"
+#include "test_common.h"
+
+namespace {
+
+constexpr uint64_t kAudio = 0x1234;
+constexpr uint64_t kModel = 0x5678;
+
+ResultCacheKey key_for(const TranscribeOptions& options, uint64_t audio = kAudio, uint64_t model = kModel) {
+    ResultCacheKey key;
+    key.audio = audio;
+    key.options = result_options_hash(options);
+    key.model = model;
+    return key;
+}
+
+CachedTranscript transcript(const std::string& text) {
+    CachedTranscript t;
+    t.text = text;
+    TranscribeSegment segment;
+    segment.t0_ms = 0;
+    segment.t1_ms = 1500;
+    segment.text = text;
+    segment.avg_logprob = -0.25f;
+    segment.n_tokens = 4;
+    t.segments.push_back(segment);
+    t.n_speech_samples = 24000;
+    return t;
+}
+
+bool hits(ResultCache& cache, const ResultCacheKey& key) {
+    CachedTranscript out;
+    return cache.lookup(key, out);
+}
+
+void test_hit_and_miss() {
+    ResultCache cache;
+    cache.open("");
+    const TranscribeOptions options;
+    const ResultCacheKey key = key_for(options);
+
+    CachedTranscript out;
+    EXPECT(!cache.lookup(key, out));
+    cache.store(key, transcript(" hello there"));
+    EXPECT(cache.lookup(key, out));
+    EXPECT_EQ(out.text, std::string(" hello there"));
+    EXPECT_EQ(out.segments.size(), 1u);
+    EXPECT_EQ(out.n_speech_samples, 24000u);
+
+    // Other audio or another model never hit
+    EXPECT(!hits(cache, key_for(options, kAudio + 1)));
+    EXPECT(!hits(cache, key_for(options, kAudio, kModel + 1)));
+
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 3u);
+    EXPECT(cache.hit_rate() == 0.25);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+void test_option_changes() {
+    ResultCache cache;
+    cache.open("");
+    TranscribeOptions base;
+    base.language = "en";
+    cache.store(key_for(base), transcript(" hello there"));
+
+    // Options that change the transcript miss
+    const auto misses_with = [&](auto change) {
+        TranscribeOptions changed = base;
+        change(changed);
+        return !hits(cache, key_for(changed));
+    };
+    EXPECT(misses_with([](TranscribeOptions& o) { o.language = "de"; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.language = "auto"; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.translate = true; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.profile = DecodeProfile::Fast; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.beam_size = 5; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.vad.enabled = false; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.vad.padding_ms = 300; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.stretch.factor = 1.25f; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.n_parallel = 1; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.prompt_tokens = {50364, 1012}; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.suppress_regex = "[0-9]"; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.max_tokens = 32; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.repetition_guard = false; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.detect.enabled = true; }));
+    EXPECT(misses_with([](TranscribeOptions& o) { o.encoder_cache = 2; o.encoder_cache_decode = true; }));
+
+    // Threads and cache settings do not change the text, so they still hit
+    const auto hits_with = [&](auto change) {
+        TranscribeOptions changed = base;
+        change(changed);
+        return hits(cache, key_for(changed));
+    };
+    EXPECT(hits_with([](TranscribeOptions& o) { o.n_threads = 8; }));
+    EXPECT(hits_with([](TranscribeOptions& o) { o.n_threads_long = 6; }));
+    EXPECT(hits_with([](TranscribeOptions& o) { o.result_cache = true; }));
+    EXPECT(hits_with([](TranscribeOptions& o) { o.encoder_cache = 2; }));
+    EXPECT(hits_with([](TranscribeOptions& o) { o.budget_ms = 5000; }));
+
+    // VAD tuning only matters while VAD runs; "" and "auto" are the same request
+    TranscribeOptions no_vad = base;
+    no_vad.vad.enabled = false;
+    cache.store(key_for(no_vad), transcript(" hello there"));
+    TranscribeOptions no_vad_tuned = no_vad;
+    no_vad_tuned.vad.padding_ms = 300;
+    EXPECT(hits(cache, key_for(no_vad_tuned)));
+
+    TranscribeOptions empty_language;
+    TranscribeOptions auto_language;
+    auto_language.language = "auto";
+    EXPECT_EQ(result_options_hash(empty_language), result_options_hash(auto_language));
+}
+
+void test_capacity() {
+    ResultCache cache;
+    cache.open("", 2);
+    const TranscribeOptions options;
+    cache.store(key_for(options, 1), transcript(" one"));
+    cache.store(key_for(options, 2), transcript(" two"));
+    // Looking up 1 makes 2 the least recently used
+    EXPECT(hits(cache, key_for(options, 1)));
+    cache.store(key_for(options, 3), transcript(" three"));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT(hits(cache, key_for(options, 1)));
+    EXPECT(!hits(cache, key_for(options, 2)));
+    EXPECT(hits(cache, key_for(options, 3)));
+}
+
+void test_persistence() {
+    char dir[] = "/tmp/hw-result-cache-XXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        EXPECT(!"mkdtemp failed");
+        return;
+    }
+    TranscribeOptions options;
+    options.language = "en";
+    {
+        ResultCache cache;
+        cache.open(dir);
+        cache.store(key_for(options), transcript(" kept across restarts"));
+    }
+
+    // A new process (a fresh cache on the same directory) hits, with the segments intact
+    ResultCache reopened;
+    reopened.open(dir);
+    EXPECT_EQ(reopened.size(), 1u);
+    CachedTranscript out;
+    EXPECT(reopened.lookup(key_for(options), out));
+    EXPECT_EQ(out.text, std::string(" kept across restarts"));
+    EXPECT_EQ(out.segments.size(), 1u);
+    if (!out.segments.empty()) {
+        EXPECT_EQ(out.segments[0].t1_ms, 1500);
+        EXPECT(out.segments[0].avg_logprob == -0.25f);
+        EXPECT_EQ(out.segments[0].n_tokens, 4);
+    }
+    options.translate = true;
+    EXPECT(!reopened.lookup(key_for(options), out));
+
+    const std::string index = std::string(dir) + "/transcripts.hwidx";
+    unlink(index.c_str());
+    rmdir(dir);
+}
+
+} // namespace
+
+int main() {
+    test_hit_and_miss();
+    test_option_changes();
+    test_capacity();
+    test_persistence();
+    return test_result("test-result-cache");
+}
@@ -0,0 +1,166 @@
+/**
+ * test-vad: vad_detect and VadTimeline on synthetic tone and silence
+ *
+ *   test-vad
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "vad.h"
+#include "test_common.h"
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+
+/**
+ * Room tone around -80 dBFS (below VadOptions::min_energy_db, but not digital silence)
+ */
+std::vector<float> silence(size_t n, uint32_t& seed) {
+    std::vector<float> out(n);
+    for (float& v : out) {
+        seed = seed * 1664525u + 1013904223u;
+        v = (static_cast<float>(seed >> 8) / (1u << 24) - 0.5f) * 2e-4f;
+    }
+    return out;
+}
+
+void append_tone(std::vector<float>& pcm, double seconds, double hz) {
+    const size_t n = static_cast<size_t>(seconds * kSampleRate);
+    for (size_t i = 0; i < n; i++) {
+        pcm.push_back(0.3f * static_cast<float>(std::sin(2.0 * M_PI * hz * i / kSampleRate)));
+    }
+}
+
+void append_silence(std::vector<float>& pcm, double seconds, uint32_t& seed) {
+    const std::vector<float> s = silence(static_cast<size_t>(seconds * kSampleRate), seed);
+    pcm.insert(pcm.end(), s.begin(), s.end());
+}
+
+size_t at(double seconds) {
+    return static_cast<size_t>(seconds * kSampleRate);
+}
+
+void test_silence() {
+    const VadOptions options;
+    const std::vector<float> zeros(at(2.0), 0.0f);
+    EXPECT(vad_detect(zeros.data(), zeros.size(), kSampleRate, options).empty());
+
+    uint32_t seed = 1;
+    const std::vector<float> room = silence(at(2.0), seed);
+    EXPECT(vad_detect(room.data(), room.size(), kSampleRate, options).empty());
+
+    EXPECT(vad_detect(nullptr, 0, kSampleRate, options).empty());
+}
+
+void test_tones() {
+    const VadOptions options;
+    const size_t pad = at(options.padding_ms / 1000.0);
+
+    // 1 s silence, 1 s tone, 1 s silence, 1 s tone, 1 s silence: two padded intervals
+    uint32_t seed = 2;
+    std::vector<float> pcm;
+    append_silence(pcm, 1.0, seed);
+    append_tone(pcm, 1.0, 440.0);
+    append_silence(pcm, 1.0, seed);
+    append_tone(pcm, 1.0, 220.0);
+    append_silence(pcm, 1.0, seed);
+
+    const std::vector<SpeechInterval> intervals = vad_detect(pcm.data(), pcm.size(), kSampleRate, options);
+    EXPECT_EQ(intervals.size(), 2u);
+    if (intervals.size() == 2) {
+        EXPECT_EQ(intervals[0].start, at(1.0) - pad);
+        EXPECT_EQ(intervals[0].end, at(2.0) + pad);
+        EXPECT_EQ(intervals[1].start, at(3.0) - pad);
+        EXPECT_EQ(intervals[1].end, at(4.0) + pad);
+    }
+
+    // A pause shorter than min_silence_ms stays inside one interval
+    std::vector<float> bridged;
+    append_silence(bridged, 1.0, seed);
+    append_tone(bridged, 0.5, 440.0);
+    append_silence(bridged, 0.2, seed);
+    append_tone(bridged, 0.5, 440.0);
+    append_silence(bridged, 1.0, seed);
+    const std::vector<SpeechInterval> one = vad_detect(bridged.data(), bridged.size(), kSampleRate, options);
+    EXPECT_EQ(one.size(), 1u);
+    if (one.size() == 1) {
+        EXPECT_EQ(one[0].start, at(1.0) - pad);
+        EXPECT_EQ(one[0].end, at(2.2) + pad);
+    }
+
+    // A burst shorter than min_speech_ms is dropped
+    std::vector<float> click;
+    append_silence(click, 1.0, seed);
+    append_tone(click, 0.04, 1000.0);
+    append_silence(click, 1.0, seed);
+    EXPECT(vad_detect(click.data(), click.size(), kSampleRate, options).empty());
+
+    // A tone from the first sample clamps the padding at 0
+    std::vector<float> leading;
+    append_tone(leading, 1.0, 440.0);
+    append_silence(leading, 1.0, seed);
+    const std::vector<SpeechInterval> clamped = vad_detect(leading.data(), leading.size(), kSampleRate, options);
+    EXPECT_EQ(clamped.size(), 1u);
+    if (clamped.size() == 1) {
+        EXPECT_EQ(clamped[0].start, 0u);
+        EXPECT_EQ(clamped[0].end, at(1.0) + pad);
+    }
+}
+
+void test_timeline() {
+    std::vector<float> pcm(at(5.0));
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = static_cast<float>(i % 1000) / 1000.0f + 0.001f;
+    }
+    const std::vector<SpeechInterval> intervals = {{at(0.8), at(2.2)}, {at(2.8), at(4.2)}};
+    const size_t gap = at(0.1);
+    const size_t len0 = intervals[0].end - intervals[0].start;
+    const size_t len1 = intervals[1].end - intervals[1].start;
+
+    VadTimeline timeline;
+    std::vector<float> packed;
+    timeline.pack(pcm.data(), intervals, gap, packed);
+    EXPECT_EQ(packed.size(), len0 + gap + len1);
+    if (packed.size() != len0 + gap + len1) {
+        return;
+    }
+
+    // Intervals copied in order, silence in between
+    EXPECT(packed[0] == pcm[intervals[0].start]);
+    EXPECT(packed[len0 - 1] == pcm[intervals[0].end - 1]);
+    bool gap_silent = true;
+    for (size_t i = len0; i < len0 + gap; i++) {
+        gap_silent = gap_silent && packed[i] == 0.0f;
+    }
+    EXPECT(gap_silent);
+    EXPECT(packed[len0 + gap] == pcm[intervals[1].start]);
+    EXPECT(packed.back() == pcm[intervals[1].end - 1]);
+
+    // Packed positions map back to the recording; the gap snaps to the end of the first interval
+    EXPECT_EQ(timeline.to_source(0), intervals[0].start);
+    EXPECT_EQ(timeline.to_source(1234), intervals[0].start + 1234);
+    EXPECT_EQ(timeline.to_source(len0 + gap / 2), intervals[0].end);
+    EXPECT_EQ(timeline.to_source(len0 + gap), intervals[1].start);
+    EXPECT_EQ(timeline.to_source(len0 + gap + 500), intervals[1].start + 500);
+    EXPECT_EQ(timeline.to_source(packed.size() + 1000), intervals[1].end);
+
+    // Centiseconds: 1.0 s into the packed audio is 1.8 s into the recording
+    EXPECT_EQ(timeline.to_source_cs(100, kSampleRate), 180);
+    EXPECT_EQ(timeline.to_source_cs(-5, kSampleRate), 80);
+
+    // An empty timeline is the identity
+    VadTimeline identity;
+    EXPECT_EQ(identity.to_source(4321), 4321u);
+}
+
+} // namespace
+
+int main() {
+    test_silence();
+    test_tones();
+    test_timeline();
+    return test_result("test-vad");
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+/**
+ * Small helpers shared by the host tools (JSON output, memory, argument lists)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+inline std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 2);
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out;
+}
+
+inline long peak_rss_kb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kilobytes on Linux
+}
+
+/**
+ * Reset the kernel's peak RSS counter (Linux >= 4.0) so the next
+ * current_peak_rss_kb() covers only what ran in between
+ */
+inline bool reset_peak_rss() {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f == nullptr) {
+        return false;
+    }
+    const bool ok = fputs("5", f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+
+/**
+ * Peak RSS since the last reset_peak_rss() (VmHWM), falling back to the process lifetime peak
+ */
+inline long current_peak_rss_kb() {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f != nullptr) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            long kb = 0;
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+                fclose(f);
+                return kb;
+            }
+        }
+        fclose(f);
+    }
+    return peak_rss_kb();
+}
+
+inline std::vector<std::string> split_list(const std::string& s, char sep = ',') {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        const size_t end = s.find(sep, start);
+        const std::string item = s.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (!item.empty()) {
+            out.push_back(item);
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+inline std::vector<int> split_int_list(const std::string& s) {
+    std::vector<int> out;
+    for (const std::string& item : split_list(s)) {
+        out.push_back(atoi(item.c_str()));
+    }
+    return out;
+}
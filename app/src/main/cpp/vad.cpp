@@ -0,0 +1,221 @@
+#include "vad.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#define LOG_TAG "Vad"
+#include "hw_log.h"
+
+namespace {
+
+constexpr size_t kFftSize = 512;
+constexpr float kEnergyFloorDb = -90.0f;
+constexpr float kNoisePercentile = 0.10f;
+
+// In-place iterative radix-2 FFT
+void fft(std::vector<std::complex<float>>& a) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const float angle = -2.0f * static_cast<float>(M_PI) / static_cast<float>(len);
+        const std::complex<float> wlen(std::cos(angle), std::sin(angle));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<float> w(1.0f, 0.0f);
+            for (size_t k = 0; k < len / 2; k++) {
+                const std::complex<float> u = a[i + k];
+                const std::complex<float> v = a[i + k + len / 2] * w;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+                w *= wlen;
+            }
+        }
+    }
+}
+
+struct FrameFeatures {
+    float energy_db;
+    float flatness;
+};
+
+/**
+ * Spectral flatness (geometric / arithmetic mean of the power spectrum) over
+ * the 100 Hz - 4 kHz voice band: near 0 for harmonic speech, near 1 for noise
+ */
+float spectral_flatness(const float* frame, size_t n, int sample_rate,
+                        const std::vector<float>& window, std::vector<std::complex<float>>& buf) {
+    std::fill(buf.begin(), buf.end(), std::complex<float>(0.0f, 0.0f));
+    for (size_t i = 0; i < n && i < kFftSize; i++) {
+        buf[i] = std::complex<float>(frame[i] * window[i], 0.0f);
+    }
+    fft(buf);
+
+    const size_t lo = std::max<size_t>(1, 100 * kFftSize / sample_rate);
+    const size_t hi = std::min(kFftSize / 2, 4000 * kFftSize / sample_rate);
+    double log_sum = 0.0;
+    double sum = 0.0;
+    for (size_t k = lo; k < hi; k++) {
+        const double p = std::norm(buf[k]) + 1e-12;
+        log_sum += std::log(p);
+        sum += p;
+    }
+    const double count = static_cast<double>(hi - lo);
+    if (count <= 0.0 || sum <= 0.0) {
+        return 1.0f;
+    }
+    return static_cast<float>(std::exp(log_sum / count) / (sum / count));
+}
+
+std::vector<FrameFeatures> analyze(const float* pcm, size_t n_samples, int sample_rate, size_t frame_len) {
+    std::vector<float> window(frame_len);
+    for (size_t i = 0; i < frame_len; i++) {
+        window[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / (frame_len - 1));
+    }
+    std::vector<std::complex<float>> buf(kFftSize);
+
+    std::vector<FrameFeatures> frames;
+    frames.reserve(n_samples / frame_len + 1);
+    for (size_t start = 0; start < n_samples; start += frame_len) {
+        const size_t len = std::min(frame_len, n_samples - start);
+        double energy = 0.0;
+        for (size_t i = 0; i < len; i++) {
+            energy += static_cast<double>(pcm[start + i]) * pcm[start + i];
+        }
+        const double mean = energy / static_cast<double>(len);
+        FrameFeatures f;
+        f.energy_db = mean > 0.0 ? std::max(kEnergyFloorDb, static_cast<float>(10.0 * std::log10(mean))) : kEnergyFloorDb;
+        f.flatness = len == frame_len ? spectral_flatness(pcm + start, len, sample_rate, window, buf) : 1.0f;
+        frames.push_back(f);
+    }
+    return frames;
+}
+
+} // namespace
+
+std::vector<SpeechInterval> vad_detect(const float* pcm, size_t n_samples, int sample_rate, const VadOptions& options) {
+    std::vector<SpeechInterval> intervals;
+    const size_t frame_len = static_cast<size_t>(sample_rate) * options.frame_ms / 1000;
+    if (n_samples == 0 || frame_len < 2 || frame_len > kFftSize) {
+        return intervals;
+    }
+
+    const std::vector<FrameFeatures> frames = analyze(pcm, n_samples, sample_rate, frame_len);
+
+    // Noise floor: low percentile of frame energies (recordings start and end with room tone),
+    // ignoring digital silence from recorder warm-up. Trimmed clips may have no room tone left,
+    // so the percentile is capped at an absolute level.
+    std::vector<float> energies;
+    energies.reserve(frames.size());
+    for (const FrameFeatures& f : frames) {
+        if (f.energy_db > kEnergyFloorDb) {
+            energies.push_back(f.energy_db);
+        }
+    }
+    float noise_db = kEnergyFloorDb;
+    if (!energies.empty()) {
+        const size_t nth = static_cast<size_t>(kNoisePercentile * (energies.size() - 1));
+        std::nth_element(energies.begin(), energies.begin() + nth, energies.end());
+        noise_db = std::min(energies[nth], options.max_noise_db);
+    }
+    const float threshold_db = std::max(noise_db + options.energy_margin_db, options.min_energy_db);
+
+    // Loud frames always count; moderately loud frames need a voiced (non-flat) spectrum
+    std::vector<bool> speech(frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        const FrameFeatures& f = frames[i];
+        speech[i] = f.energy_db > threshold_db + options.energy_margin_db ||
+                    (f.energy_db > threshold_db && f.flatness < options.flatness_threshold);
+    }
+
+    // Runs of speech frames -> intervals, bridging short pauses and dropping short bursts
+    const size_t min_speech = std::max<size_t>(1, static_cast<size_t>(options.min_speech_ms / options.frame_ms));
+    const size_t min_silence = static_cast<size_t>(options.min_silence_ms / options.frame_ms);
+    std::vector<std::pair<size_t, size_t>> runs; // frame ranges [first, last)
+    for (size_t i = 0; i < speech.size();) {
+        if (!speech[i]) {
+            i++;
+            continue;
+        }
+        size_t j = i;
+        while (j < speech.size() && speech[j]) {
+            j++;
+        }
+        if (!runs.empty() && i - runs.back().second <= min_silence) {
+            runs.back().second = j;
+        } else {
+            runs.emplace_back(i, j);
+        }
+        i = j;
+    }
+
+    const size_t pad = static_cast<size_t>(sample_rate) * options.padding_ms / 1000;
+    for (const auto& run : runs) {
+        if (run.second - run.first < min_speech) {
+            continue;
+        }
+        SpeechInterval iv;
+        iv.start = run.first * frame_len > pad ? run.first * frame_len - pad : 0;
+        iv.end = std::min(n_samples, run.second * frame_len + pad);
+        if (!intervals.empty() && iv.start <= intervals.back().end) {
+            intervals.back().end = std::max(intervals.back().end, iv.end);
+        } else {
+            intervals.push_back(iv);
+        }
+    }
+
+    size_t kept = 0;
+    for (const SpeechInterval& iv : intervals) {
+        kept += iv.end - iv.start;
+    }
+    LOGI("VAD: noise floor %.1f dB, %zu intervals, %zu of %zu samples kept",
+         noise_db, intervals.size(), kept, n_samples);
+    return intervals;
+}
+
+void VadTimeline::pack(const float* pcm, const std::vector<SpeechInterval>& intervals, size_t gap_samples, std::vector<float>& out) {
+    spans_.clear();
+    out.clear();
+
+    size_t total = 0;
+    for (const SpeechInterval& iv : intervals) {
+        total += iv.end - iv.start + gap_samples;
+    }
+    out.reserve(total);
+
+    for (const SpeechInterval& iv : intervals) {
+        if (!out.empty()) {
+            out.insert(out.end(), gap_samples, 0.0f);
+        }
+        spans_.push_back({out.size(), iv.start, iv.end - iv.start});
+        out.insert(out.end(), pcm + iv.start, pcm + iv.end);
+    }
+}
+
+size_t VadTimeline::to_source(size_t packed_sample) const {
+    if (spans_.empty()) {
+        return packed_sample;
+    }
+    // Last span starting at or before the position
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), packed_sample,
+                               [](size_t pos, const Span& s) { return pos < s.packed_start; });
+    if (it == spans_.begin()) {
+        return spans_.front().source_start;
+    }
+    --it;
+    const size_t offset = std::min(packed_sample - it->packed_start, it->length);
+    return it->source_start + offset;
+}
+
+int64_t VadTimeline::to_source_cs(int64_t packed_cs, int sample_rate) const {
+    const size_t packed = static_cast<size_t>(std::max<int64_t>(0, packed_cs)) * sample_rate / 100;
+    return static_cast<int64_t>(to_source(packed) * 100 / sample_rate);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lightweight voice activity detection (energy + spectral flatness)
+ *
+ * Runs on 16 kHz mono PCM before whisper_full so leading/trailing silence and
+ * long pauses never reach the encoder. Speech intervals are padded, packed
+ * into a compact buffer, and timestamps from whisper are mapped back to the
+ * original recording timeline with VadTimeline.
+ */
+
+struct VadOptions {
+    bool enabled = true;
+    int frame_ms = 20;
+    float energy_margin_db = 10.0f;   // Speech must be this far above the estimated noise floor
+    float min_energy_db = -60.0f;     // ...and above this absolute level (dBFS)
+    float max_noise_db = -45.0f;      // Cap on the estimated floor: clips that are speech throughout set it too high
+    float flatness_threshold = 0.45f; // Spectral flatness above this looks like noise, not voice
+    int min_speech_ms = 120;          // Drop speech bursts shorter than this (clicks, taps)
+    int min_silence_ms = 400;         // Pauses shorter than this stay inside one interval
+    int padding_ms = 200;             // Context kept before and after every interval
+    int gap_ms = 100;                 // Silence inserted between packed intervals
+};
+
+/**
+ * Half-open sample range [start, end) in the source recording
+ */
+struct SpeechInterval {
+    size_t start = 0;
+    size_t end = 0;
+};
+
+/**
+ * Detect padded, merged speech intervals in pcm
+ */
+std::vector<SpeechInterval> vad_detect(const float* pcm, size_t n_samples, int sample_rate, const VadOptions& options);
+
+/**
+ * Maps positions in the packed buffer back to the source recording
+ */
+class VadTimeline {
+public:
+    /**
+     * Copy intervals of pcm into out, separated by gap_samples of silence
+     */
+    void pack(const float* pcm, const std::vector<SpeechInterval>& intervals, size_t gap_samples, std::vector<float>& out);
+
+    /**
+     * Source sample for a packed sample; positions inside a gap snap to the end of the previous interval
+     */
+    size_t to_source(size_t packed_sample) const;
+
+    /**
+     * Same as to_source for whisper's 10 ms timestamp units
+     */
+    int64_t to_source_cs(int64_t packed_cs, int sample_rate) const;
+
+private:
+    struct Span {
+        size_t packed_start;
+        size_t source_start;
+        size_t length;
+    };
+    std::vector<Span> spans_;
+};
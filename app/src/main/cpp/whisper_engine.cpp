@@ -0,0 +1,1221 @@
+#include "whisper_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <sys/stat.h>
+#include "whisper.h"
+#include "audio_converter.h"
+#include "audio_kernels.h"
+#include "confidence.h"
+#include "content_hash.h"
+#include "encoder_cache.h"
+#include "grammar_cache.h"
+#include "long_form.h"
+#include "model_header.h"
+#include "model_pack.h"
+#include "repetition_guard.h"
+#include "result_cache.h"
+
+#define LOG_TAG "WhisperEngine"
+#include "hw_log.h"
+
+// Global context handle
+static struct whisper_context* g_context = nullptr;
+
+// Serializes model load/unload against running transcriptions
+static std::mutex g_mutex;
+
+// Extra whisper_states for parallel long-form decoding, created on demand and freed with the model
+static std::vector<struct whisper_state*> g_state_pool;
+static constexpr size_t kMaxStates = 4;
+static constexpr size_t kMaxStatesLarge = 2;
+static constexpr int kMinThreadsPerChunk = 2;
+
+// States of recent single-window runs, reused when the same audio is decoded again
+static EncoderCache g_encoder_cache;
+
+// Finished results, persisted under the load-time cache dir; keyed with the loaded model
+static ResultCache g_result_cache;
+static uint64_t g_model_id = 0;
+
+// Header of the loaded model file
+static ModelHparams g_hparams;
+
+// Decode wall time per 30 s window of recent serial runs, by profile (0 = not measured yet);
+// latency budgets predict from it
+static double g_window_ms[3] = {0.0, 0.0, 0.0};
+
+// Draft model for instant first results; its own lock so it runs alongside the main model
+static struct whisper_context* g_draft_context = nullptr;
+static std::mutex g_draft_mutex;
+
+static void free_state_pool() {
+    for (struct whisper_state* state : g_state_pool) {
+        whisper_free_state(state);
+    }
+    g_state_pool.clear();
+    g_encoder_cache.clear();
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Recording-level mel handed in by engine_transcribe_file
+ * offset is the recording sample at which the pcm given to the engine starts (trimmed edge)
+ */
+struct MelSource {
+    const IncrementalMel* mel = nullptr;
+    size_t offset = 0;
+};
+
+/**
+ * Spectrogram ready for whisper_set_mel
+ */
+struct PreparedMel {
+    std::vector<float> data;
+    int n_len = 0;
+    size_t n_samples = 0; // Audio the mel represents, excluding padding
+};
+
+static bool transcribe_pcm(const std::vector<float>& pcm, const TranscribeOptions& options, TranscribeResult& result,
+                           const MelSource& mel_source, bool has_sound);
+
+/**
+ * Identity of a model file for the result cache: path, size and modification time
+ * A replaced or re-downloaded file gets a new id, so its old results are never reused
+ */
+static uint64_t model_file_id(const char* model_path) {
+    struct stat st {};
+    if (stat(model_path, &st) != 0) {
+        return 0;
+    }
+    const uint64_t stamp[2] = { static_cast<uint64_t>(st.st_size), static_cast<uint64_t>(st.st_mtime) };
+    return content_hash(model_path, strlen(model_path), content_hash(stamp, sizeof(stamp)));
+}
+
+bool engine_load_model(const char* model_path, const char* cache_dir) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    LOGI("Loading model from: %s (cache: %s)", model_path, cache_dir ? cache_dir : "");
+
+    // Release previous model if loaded
+    free_state_pool();
+    if (g_context != nullptr) {
+        whisper_free(g_context);
+        g_context = nullptr;
+    }
+
+    g_hparams = ModelHparams();
+    ModelHparams hparams;
+    std::string error;
+    if (!model_hparams_read(model_path, hparams)) {
+        LOGE("Not a GGML whisper model: %s", model_path);
+        return false;
+    }
+    if (!model_hparams_validate(hparams, error)) {
+        LOGE("Unsupported model: %s", error.c_str());
+        return false;
+    }
+    LOGI("Model: %s", model_hparams_describe(hparams).c_str());
+    // whisper.cpp creates every weight matrix at the header's type and rejects the rest
+    PackLayout layout;
+    if (model_pack_inspect(model_path, layout) && !layout.loadable()) {
+        LOGE("Weight types differ between groups: whisper.cpp loads one type only (re-pack it with hyperwhisper-pack)");
+        return false;
+    }
+
+    // Load model
+    const auto load_start = std::chrono::steady_clock::now();
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = false;
+    g_context = whisper_init_from_file_with_params(model_path, cparams);
+    if (g_context == nullptr) {
+        LOGE("Failed to load model");
+        return false;
+    }
+
+    g_model_id = model_file_id(model_path);
+    g_result_cache.open(cache_dir != nullptr ? cache_dir : "");
+    std::fill(std::begin(g_window_ms), std::end(g_window_ms), 0.0);
+    g_hparams = hparams;
+
+    LOGI("Model loaded successfully in %.0f ms (%s)", elapsed_ms(load_start),
+         whisper_is_multilingual(g_context) ? "multilingual" : "English-only");
+    return true;
+}
+
+void engine_unload_model() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_context != nullptr) {
+        LOGI("Unloading model");
+        free_state_pool();
+        whisper_free(g_context);
+        g_context = nullptr;
+        g_model_id = 0;
+        g_hparams = ModelHparams();
+    }
+}
+
+bool engine_is_model_loaded() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_context != nullptr;
+}
+
+EngineCacheStats engine_cache_stats() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    EngineCacheStats stats;
+    stats.result_hits = g_result_cache.hits();
+    stats.result_misses = g_result_cache.misses();
+    stats.result_entries = g_result_cache.size();
+    stats.encoder_hits = g_encoder_cache.hits();
+    stats.encoder_misses = g_encoder_cache.misses();
+    return stats;
+}
+
+bool engine_tokenize(const std::string& text, std::vector<int32_t>& tokens) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    tokens.clear();
+    if (g_context == nullptr) {
+        return false;
+    }
+    // A token covers at least one byte
+    std::vector<whisper_token> buf(text.size() + 1);
+    const int n = whisper_tokenize(g_context, text.c_str(), buf.data(), static_cast<int>(buf.size()));
+    if (n < 0) {
+        LOGE("Tokenization failed for %zu bytes", text.size());
+        return false;
+    }
+    tokens.assign(buf.begin(), buf.begin() + n);
+    return true;
+}
+
+int engine_model_n_mels() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_context != nullptr ? whisper_model_n_mels(g_context) : 0;
+}
+
+bool engine_model_hparams(ModelHparams& out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    out = g_hparams;
+    return g_context != nullptr;
+}
+
+bool engine_model_is_multilingual() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_context != nullptr && whisper_is_multilingual(g_context);
+}
+
+bool engine_read_audio(const char* audio_path, const TrimOptions& trim, AudioInput& audio) {
+    const auto read_start = std::chrono::steady_clock::now();
+    audio = AudioInput();
+    if (!read_wav(audio_path, audio.pcm, audio.sample_rate)) {
+        LOGE("Failed to read WAV file");
+        return false;
+    }
+
+    LOGI("Audio loaded: %zu samples, %d Hz", audio.pcm.size(), audio.sample_rate);
+    if (audio.sample_rate != WHISPER_SAMPLE_RATE && audio.sample_rate > 0) {
+        LOGW("Resampling %d Hz audio to %d Hz", audio.sample_rate, WHISPER_SAMPLE_RATE);
+        std::vector<float> resampled;
+        resample_linear(audio.pcm.data(), audio.pcm.size(), audio.sample_rate, WHISPER_SAMPLE_RATE, resampled);
+        audio.pcm = std::move(resampled);
+    }
+    audio.n_recorded = audio.pcm.size();
+    audio.trim = trim_silence(audio.pcm, WHISPER_SAMPLE_RATE, trim);
+    audio.read_ms = elapsed_ms(read_start);
+    return true;
+}
+
+/**
+ * Report a transcription of trimmed audio on the untrimmed recording timeline
+ */
+static void apply_trim(const AudioInput& audio, TranscribeResult& result) {
+    result.timings.read_ms = audio.read_ms;
+    result.n_samples = audio.n_recorded;
+    result.n_trimmed_leading = audio.trim.leading;
+    result.n_trimmed_trailing = audio.trim.trailing;
+    const int64_t offset_ms = static_cast<int64_t>(audio.trim.leading) * 1000 / WHISPER_SAMPLE_RATE;
+    for (TranscribeSegment& segment : result.segments) {
+        segment.t0_ms += offset_ms;
+        segment.t1_ms += offset_ms;
+    }
+}
+
+bool engine_transcribe_file(const char* audio_path, const TranscribeOptions& options, TranscribeResult& result,
+                            const IncrementalMel* mel) {
+    LOGI("Transcribing: %s, language: %s, translate: %d",
+         audio_path, options.language.c_str(), options.translate);
+
+    // Read WAV file and extract PCM samples
+    AudioInput audio;
+    if (!engine_read_audio(audio_path, options.trim, audio)) {
+        return false;
+    }
+
+    // The incremental mel only describes the recording as captured (16 kHz, same length)
+    MelSource mel_source;
+    if (mel != nullptr && audio.sample_rate == WHISPER_SAMPLE_RATE && mel->finished() &&
+        mel->n_samples() == audio.n_recorded) {
+        mel_source.mel = mel;
+        mel_source.offset = audio.trim.leading;
+    } else if (mel != nullptr) {
+        LOGW("Precomputed mel does not match the recording (%zu vs %zu samples), ignoring",
+             mel->n_samples(), audio.n_recorded);
+    }
+
+    const bool ok = transcribe_pcm(audio.pcm, options, result, mel_source, audio.trim.sound);
+    apply_trim(audio, result);
+    return ok;
+}
+
+bool engine_transcribe_audio(const AudioInput& audio, const TranscribeOptions& options, TranscribeResult& result) {
+    const bool ok = transcribe_pcm(audio.pcm, options, result, MelSource(), audio.trim.sound);
+    apply_trim(audio, result);
+    return ok;
+}
+
+// Token cap for grammar-constrained phrases unless the options set one
+static constexpr int kGrammarMaxTokens = 32;
+
+static bool abort_requested(void* user_data) {
+    return static_cast<const std::atomic<bool>*>(user_data)->load(std::memory_order_relaxed);
+}
+
+/**
+ * Deadline of a call with a latency budget
+ * whisper polls abort_callback between graph nodes, so the deadline stops it mid-window;
+ * encoder_begin_callback runs before each window and declines one that won't fit (pace).
+ */
+struct DecodeBudget {
+    std::chrono::steady_clock::time_point deadline;
+    const std::atomic<bool>* cancel = nullptr;
+    bool pace = false;      // Decline windows that won't fit; only while a cheaper profile is left
+    std::chrono::steady_clock::time_point run_start; // Of the current whisper_full
+    int n_windows = 0;      // Windows started by the current whisper_full
+    bool declined = false;
+
+    bool expired() const { return std::chrono::steady_clock::now() >= deadline; }
+};
+
+static bool budget_abort(void* user_data) {
+    const DecodeBudget* budget = static_cast<const DecodeBudget*>(user_data);
+    return (budget->cancel != nullptr && budget->cancel->load(std::memory_order_relaxed)) || budget->expired();
+}
+
+static bool budget_window_begin(struct whisper_context* /*ctx*/, struct whisper_state* /*state*/,
+                                void* user_data) {
+    DecodeBudget* budget = static_cast<DecodeBudget*>(user_data);
+    const auto now = std::chrono::steady_clock::now();
+    if (budget->pace && budget->n_windows > 0 &&
+        now + (now - budget->run_start) / budget->n_windows > budget->deadline) {
+        budget->declined = true;
+        return false;
+    }
+    budget->n_windows++;
+    return true;
+}
+
+static bool cancel_requested(const TranscribeOptions& options) {
+    return options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed);
+}
+
+static struct whisper_full_params make_params(const TranscribeOptions& options, const char* language, int n_threads,
+                                              const DecodeBudget* budget = nullptr, RepetitionGuard* guard = nullptr) {
+    const DecodeProfileParams& profile = decode_profile_params(options.profile);
+    const int beam_size = options.beam_size > 1 ? options.beam_size : profile.beam_size;
+    const bool beam = beam_size > 1;
+    struct whisper_full_params params = whisper_full_default_params(
+        beam ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+    if (beam) {
+        params.beam_search.beam_size = beam_size;
+    }
+    params.greedy.best_of = profile.best_of;
+    params.temperature_inc = profile.temperature_inc;
+    params.print_progress = false;
+    params.print_special = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.translate = options.translate;
+    params.n_threads = n_threads;
+    params.offset_ms = 0;
+    // Context comes only from prompt_tokens, never from whatever an earlier call left in the state
+    params.no_context = true;
+    if (!options.prompt_tokens.empty()) {
+        params.prompt_tokens = options.prompt_tokens.data();
+        params.prompt_n_tokens = static_cast<int>(options.prompt_tokens.size());
+    }
+    params.single_segment = false;
+    if (options.grammar) {
+        // Commands and field values are one short phrase: no timestamps, one segment, bounded length
+        params.grammar_rules = const_cast<const whisper_grammar_element**>(options.grammar->rules.data());
+        params.n_grammar_rules = options.grammar->rules.size();
+        params.i_start_rule = options.grammar->start_rule;
+        params.grammar_penalty = options.grammar_penalty;
+        params.no_timestamps = true;
+        params.single_segment = true;
+        params.max_tokens = kGrammarMaxTokens;
+    }
+    if (options.max_tokens > 0) {
+        params.max_tokens = options.max_tokens;
+    }
+    if (!options.suppress_regex.empty()) {
+        params.suppress_regex = options.suppress_regex.c_str();
+    }
+    if (guard != nullptr) {
+        params.logits_filter_callback = repetition_guard_filter;
+        params.logits_filter_callback_user_data = guard;
+    }
+    if (budget != nullptr) {
+        params.abort_callback = budget_abort;
+        params.abort_callback_user_data = const_cast<DecodeBudget*>(budget);
+    } else if (options.cancel != nullptr) {
+        params.abort_callback = abort_requested;
+        params.abort_callback_user_data = const_cast<std::atomic<bool>*>(options.cancel);
+    }
+    params.language = language;
+    return params;
+}
+
+static const char* language_or_auto(const TranscribeOptions& options) {
+    if (!options.language.empty() && options.language != "auto") {
+        return options.language.c_str();
+    }
+    return "auto";
+}
+
+/**
+ * English-only models have no language or task tokens: the language is always English
+ * and there is nothing to translate, so neither detection nor a translate pass runs
+ */
+static void pin_english_only(struct whisper_context* ctx, TranscribeOptions& options) {
+    if (whisper_is_multilingual(ctx)) {
+        return;
+    }
+    if (options.translate || language_or_auto(options) != std::string("en")) {
+        LOGI("English-only model: transcribing as en (requested %s%s)", language_or_auto(options),
+             options.translate ? ", translate" : "");
+    }
+    options.language = "en";
+    options.translate = false;
+    options.detect.enabled = false;
+}
+
+/**
+ * Append segments of a finished whisper_full run, shifted by offset samples
+ * Timestamps stay in whisper's 10 ms units until the caller converts them
+ */
+static void collect_segments(struct whisper_context* ctx, struct whisper_state* state, size_t offset,
+                             std::vector<TranscribeSegment>& out) {
+    const int64_t offset_cs = static_cast<int64_t>(offset * 100 / WHISPER_SAMPLE_RATE);
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n = state != nullptr ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(ctx);
+    for (int i = 0; i < n; i++) {
+        TranscribeSegment segment;
+        int n_tokens = 0;
+        if (state != nullptr) {
+            segment.text = whisper_full_get_segment_text_from_state(state, i);
+            segment.t0_ms = whisper_full_get_segment_t0_from_state(state, i) + offset_cs;
+            segment.t1_ms = whisper_full_get_segment_t1_from_state(state, i) + offset_cs;
+            segment.no_speech_prob = whisper_full_get_segment_no_speech_prob_from_state(state, i);
+            n_tokens = whisper_full_n_tokens_from_state(state, i);
+        } else {
+            segment.text = whisper_full_get_segment_text(ctx, i);
+            segment.t0_ms = whisper_full_get_segment_t0(ctx, i) + offset_cs;
+            segment.t1_ms = whisper_full_get_segment_t1(ctx, i) + offset_cs;
+            segment.no_speech_prob = whisper_full_get_segment_no_speech_prob(ctx, i);
+            n_tokens = whisper_full_n_tokens(ctx, i);
+        }
+
+        // Text tokens only: timestamps and other specials say nothing about recognition quality
+        float sum_logprob = 0.0f;
+        for (int j = 0; j < n_tokens; j++) {
+            const whisper_token_data token = state != nullptr ? whisper_full_get_token_data_from_state(state, i, j)
+                                                              : whisper_full_get_token_data(ctx, i, j);
+            if (token.id < eot) {
+                sum_logprob += token.plog;
+                segment.n_tokens++;
+            }
+        }
+        segment.avg_logprob = segment.n_tokens > 0 ? sum_logprob / segment.n_tokens : 0.0f;
+        segment.compression_ratio = compression_ratio(segment.text);
+        out.push_back(std::move(segment));
+    }
+}
+
+static bool count_encode(struct whisper_context* /*ctx*/, struct whisper_state* /*state*/, void* user_data) {
+    ++*static_cast<int*>(user_data);
+    return true;
+}
+
+/**
+ * One whisper_full pass over all samples, on the context's default state or on state
+ * n_encodes (optional) receives the number of encoder windows whisper ran
+ * budget (optional) bounds the run: windows it declines are decoded with the Fast profile,
+ * and at its deadline the segments finished so far are the result
+ * guard (optional) ends decoder loops
+ */
+static bool transcribe_serial(struct whisper_context* ctx, const float* samples, size_t n_samples,
+                              const TranscribeOptions& options, TranscribeResult& result,
+                              const PreparedMel* mel = nullptr, struct whisper_state* state = nullptr,
+                              int* n_encodes = nullptr, DecodeBudget* budget = nullptr,
+                              RepetitionGuard* guard = nullptr) {
+    struct whisper_full_params params =
+        make_params(options, language_or_auto(options), options.n_threads, budget, guard);
+    if (budget != nullptr) {
+        budget->run_start = std::chrono::steady_clock::now();
+        budget->n_windows = 0;
+        budget->declined = false;
+        params.encoder_begin_callback = budget_window_begin;
+        params.encoder_begin_callback_user_data = budget;
+    } else if (n_encodes != nullptr) {
+        *n_encodes = 0;
+        params.encoder_begin_callback = count_encode;
+        params.encoder_begin_callback_user_data = n_encodes;
+    }
+
+    // With a preset mel whisper_full skips whisper_pcm_to_mel; duration_ms stops it at the end
+    // of the audio instead of decoding the 30 s of padding
+    const int n_mels = whisper_model_n_mels(ctx);
+    const int mel_ret = mel == nullptr ? -1
+        : state != nullptr ? whisper_set_mel_with_state(ctx, state, mel->data.data(), mel->n_len, n_mels)
+                           : whisper_set_mel(ctx, mel->data.data(), mel->n_len, n_mels);
+    if (mel != nullptr && mel_ret == 0) {
+        params.duration_ms = static_cast<int>(mel->n_samples * 1000 / WHISPER_SAMPLE_RATE);
+        samples = nullptr;
+        n_samples = 0;
+        result.precomputed_mel = true;
+    } else if (mel != nullptr) {
+        LOGW("whisper_set_mel failed, computing mel from samples");
+    }
+
+    auto run = [&](const struct whisper_full_params& run_params, const float* run_samples, size_t run_n_samples) {
+        return state != nullptr
+            ? whisper_full_with_state(ctx, state, run_params, run_samples, static_cast<int>(run_n_samples))
+            : whisper_full(ctx, run_params, run_samples, static_cast<int>(run_n_samples));
+    };
+    // A failed run past the deadline still holds the windows it finished
+    auto check = [&](int ret) {
+        if (ret != 0 && cancel_requested(options)) {
+            LOGI("Transcription cancelled");
+            result.cancelled = true;
+            return false;
+        }
+        if (ret != 0 && (budget == nullptr || !budget->expired())) {
+            LOGE("Transcription failed with code: %d", ret);
+            return false;
+        }
+        result.budget_exceeded = ret != 0;
+        return true;
+    };
+
+    int ret = run(params, samples, n_samples);
+    if (budget != nullptr && n_encodes != nullptr) {
+        *n_encodes = budget->n_windows;
+    }
+    if (!check(ret)) {
+        return false;
+    }
+
+    // whisper only exposes timings of the default state
+    const struct whisper_timings* timings = state == nullptr ? whisper_get_timings(ctx) : nullptr;
+    if (timings != nullptr) {
+        result.timings.sample_ms = timings->sample_ms;
+        result.timings.encode_ms = timings->encode_ms;
+        result.timings.decode_ms = timings->decode_ms + timings->batchd_ms + timings->prompt_ms;
+    }
+
+    collect_segments(ctx, state, 0, result.segments);
+
+    // A window declined for time: the rest is decoded greedily from where the text stops
+    if (ret == 0 && budget != nullptr && budget->declined) {
+        const int64_t resume_cs = result.segments.empty()
+            ? static_cast<int64_t>(budget->n_windows) * WHISPER_CHUNK_SIZE * 100
+            : result.segments.back().t1_ms;
+        const size_t n_total = samples != nullptr ? n_samples : mel->n_samples;
+        const size_t resume = std::min(n_total, static_cast<size_t>(resume_cs) * WHISPER_SAMPLE_RATE / 100);
+
+        TranscribeOptions fast = options;
+        fast.profile = DecodeProfile::Fast;
+        fast.beam_size = 0;
+        const int lang_id = state != nullptr ? whisper_full_lang_id_from_state(state) : whisper_full_lang_id(ctx);
+        if (lang_id >= 0) {
+            fast.language = whisper_lang_str(lang_id);
+        }
+        LOGI("Latency budget: %s too slow after %d windows, finishing from %.1f s with %s",
+             decode_profile_name(options.profile), budget->n_windows,
+             static_cast<double>(resume) / WHISPER_SAMPLE_RATE, decode_profile_name(fast.profile));
+        result.downgraded = true;
+        result.profile = fast.profile;
+
+        budget->pace = false;
+        budget->run_start = std::chrono::steady_clock::now();
+        budget->n_windows = 0;
+        struct whisper_full_params fast_params =
+            make_params(fast, language_or_auto(fast), options.n_threads, budget, guard);
+        fast_params.encoder_begin_callback = budget_window_begin;
+        fast_params.encoder_begin_callback_user_data = budget;
+        if (resume < n_total) {
+            if (samples != nullptr) {
+                ret = run(fast_params, samples + resume, n_samples - resume);
+            } else {
+                fast_params.offset_ms = static_cast<int>(resume * 1000 / WHISPER_SAMPLE_RATE);
+                fast_params.duration_ms = params.duration_ms - fast_params.offset_ms;
+                ret = run(fast_params, nullptr, 0);
+            }
+            if (!check(ret)) {
+                return false;
+            }
+            collect_segments(ctx, state, samples != nullptr ? resume : 0, result.segments);
+        }
+    }
+
+    if (result.budget_exceeded) {
+        LOGW("Latency budget exhausted: returning %zu segments decoded in time", result.segments.size());
+    } else {
+        LOGI("Transcription complete: %zu segments", result.segments.size());
+    }
+    return true;
+}
+
+/**
+ * Grow the state pool to n states (bounded by memory-based cap); returns the usable count
+ */
+static size_t state_cap() {
+    // Each state carries its own KV cache and compute buffers; keep larger models to fewer states
+    return whisper_model_n_audio_layer(g_context) > 6 ? kMaxStatesLarge : kMaxStates;
+}
+
+static size_t ensure_state_pool(size_t n) {
+    n = std::min(n, state_cap());
+    while (g_state_pool.size() < n) {
+        struct whisper_state* state = whisper_init_state(g_context);
+        if (state == nullptr) {
+            LOGW("Failed to create whisper_state, continuing with %zu", g_state_pool.size());
+            break;
+        }
+        g_state_pool.push_back(state);
+    }
+    return g_state_pool.size();
+}
+
+static bool transcribe_chunks(const float* samples, const std::vector<AudioChunk>& chunks,
+                              const TranscribeOptions& options, TranscribeResult& result,
+                              DecodeBudget* latency = nullptr, RepetitionGuard* guard = nullptr) {
+    const int budget = options.n_threads_long > 0
+        ? options.n_threads_long
+        : std::max(options.n_threads, static_cast<int>(std::thread::hardware_concurrency()));
+    size_t workers = options.n_parallel > 1
+        ? static_cast<size_t>(options.n_parallel)
+        : static_cast<size_t>(std::max(1, budget / kMinThreadsPerChunk));
+    workers = ensure_state_pool(std::min(workers, chunks.size()));
+    if (workers < 2) {
+        // Not enough memory for a second state: one pass over everything is cheaper than serial chunks
+        return transcribe_serial(g_context, samples, chunks.back().end, options, result, nullptr, nullptr, nullptr,
+                                 latency, guard);
+    }
+    const int threads_per_worker = std::max(1, budget / static_cast<int>(workers));
+
+    // Chunks must agree on the language, so auto-detect once on the first chunk
+    std::string language = language_or_auto(options);
+    if (language == "auto" && !options.translate) {
+        struct whisper_state* state = g_state_pool[0];
+        const AudioChunk& first = chunks.front();
+        if (whisper_pcm_to_mel_with_state(g_context, state, samples + first.start,
+                                          static_cast<int>(first.end - first.start), budget) == 0) {
+            const int lang_id = whisper_lang_auto_detect_with_state(g_context, state, 0, budget, nullptr);
+            if (lang_id >= 0) {
+                language = whisper_lang_str(lang_id);
+            }
+        }
+    }
+
+    LOGI("Decoding %zu chunks on %zu states x %d threads (language %s)",
+         chunks.size(), workers, threads_per_worker, language.c_str());
+
+    std::vector<std::vector<TranscribeSegment>> chunk_segments(chunks.size());
+    std::vector<uint8_t> chunk_done(chunks.size(), 0);
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> n_done{0};
+    std::atomic<bool> failed{false};
+    std::atomic<bool> fast{false};
+    const auto start = std::chrono::steady_clock::now();
+    TranscribeOptions fast_options = options;
+    fast_options.profile = DecodeProfile::Fast;
+    fast_options.beam_size = 0;
+
+    // Chunks not started yet switch to Fast once the pace so far would overrun the budget
+    auto switch_to_fast = [&](size_t i) {
+        const size_t done = n_done;
+        if (latency == nullptr || !latency->pace || fast || done == 0) {
+            return false;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const auto per_chunk = (now - start) * static_cast<int64_t>(workers) / static_cast<int64_t>(done);
+        const int64_t rounds = static_cast<int64_t>((chunks.size() - i + workers - 1) / workers);
+        return now + per_chunk * rounds > latency->deadline && !fast.exchange(true);
+    };
+
+    auto worker = [&](struct whisper_state* state) {
+        const struct whisper_full_params params =
+            make_params(options, language.c_str(), threads_per_worker, latency, guard);
+        const struct whisper_full_params fast_params =
+            make_params(fast_options, language.c_str(), threads_per_worker, latency, guard);
+        for (size_t i = next_chunk++; i < chunks.size() && !failed; i = next_chunk++) {
+            if (switch_to_fast(i)) {
+                LOGI("Latency budget: %s too slow, chunks from %zu on with %s", decode_profile_name(options.profile),
+                     i, decode_profile_name(fast_options.profile));
+            }
+            const AudioChunk& chunk = chunks[i];
+            const int ret = whisper_full_with_state(g_context, state, fast ? fast_params : params, samples + chunk.start,
+                                                    static_cast<int>(chunk.end - chunk.start));
+            if (ret != 0) {
+                if (!cancel_requested(options) && (latency == nullptr || !latency->expired())) {
+                    LOGE("Chunk %zu failed with code: %d", i, ret);
+                }
+                failed = true;
+                return;
+            }
+            collect_segments(g_context, state, chunk.start, chunk_segments[i]);
+            chunk_done[i] = 1;
+            n_done++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < workers; w++) {
+        threads.emplace_back(worker, g_state_pool[w]);
+    }
+    worker(g_state_pool[0]);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    if (fast) {
+        result.downgraded = true;
+        result.profile = fast_options.profile;
+    }
+
+    // Past the deadline the result is the leading run of finished chunks
+    size_t n_merged = chunks.size();
+    if (failed) {
+        if (cancel_requested(options)) {
+            LOGI("Transcription cancelled");
+            result.cancelled = true;
+            return false;
+        }
+        if (latency == nullptr || !latency->expired()) {
+            return false;
+        }
+        n_merged = std::find(chunk_done.begin(), chunk_done.end(), 0) - chunk_done.begin();
+        result.budget_exceeded = true;
+        LOGW("Latency budget exhausted: returning %zu of %zu chunks", n_merged, chunks.size());
+    }
+
+    // Merge in order, dropping words repeated across overlapping cuts
+    std::string tail;
+    for (size_t i = 0; i < n_merged; i++) {
+        std::vector<TranscribeSegment>& segments = chunk_segments[i];
+        if (chunks[i].overlaps_prev && !segments.empty()) {
+            std::string head;
+            for (const TranscribeSegment& segment : segments) {
+                head += segment.text;
+            }
+            size_t remaining = overlap_word_count(tail, head);
+            for (TranscribeSegment& segment : segments) {
+                if (remaining == 0) {
+                    break;
+                }
+                remaining -= drop_leading_words(segment.text, remaining);
+            }
+            segments.erase(std::remove_if(segments.begin(), segments.end(),
+                                          [](const TranscribeSegment& s) { return s.text.find_first_not_of(" \t\n") == std::string::npos; }),
+                           segments.end());
+        }
+        for (TranscribeSegment& segment : segments) {
+            tail += segment.text;
+            result.segments.push_back(std::move(segment));
+        }
+        // Only the end of the merged text matters for the next overlap
+        if (tail.size() > 512) {
+            tail.erase(0, tail.size() - 512);
+        }
+    }
+
+    LOGI("Transcription complete: %zu segments from %zu chunks", result.segments.size(), chunks.size());
+    return true;
+}
+
+/**
+ * Language probabilities for the first prefix_ms of samples, restricted to the candidates
+ * Runs on the default state; whisper_full recomputes its mel afterwards.
+ */
+static bool detect_language(const float* samples, size_t n_samples, const LanguageDetectOptions& options,
+                            int n_threads, std::vector<LanguageProb>& out) {
+    out.clear();
+    if (!whisper_is_multilingual(g_context)) {
+        out.push_back({"en", 1.0f});
+        return true;
+    }
+
+    const size_t n_prefix = std::min(n_samples, static_cast<size_t>(WHISPER_SAMPLE_RATE) * options.prefix_ms / 1000);
+    if (n_prefix == 0 || whisper_pcm_to_mel(g_context, samples, static_cast<int>(n_prefix), n_threads) != 0) {
+        LOGE("Failed to compute mel for language detection");
+        return false;
+    }
+    std::vector<float> probs(whisper_lang_max_id() + 1, 0.0f);
+    if (whisper_lang_auto_detect(g_context, 0, n_threads, probs.data()) < 0) {
+        LOGE("Language detection failed");
+        return false;
+    }
+
+    std::vector<int> ids;
+    for (const std::string& code : options.candidates) {
+        const int id = whisper_lang_id(code.c_str());
+        if (id >= 0 && std::find(ids.begin(), ids.end(), id) == ids.end()) {
+            ids.push_back(id);
+        }
+    }
+    if (ids.empty()) {
+        for (int id = 0; id < static_cast<int>(probs.size()); id++) {
+            ids.push_back(id);
+        }
+    }
+
+    float total = 0.0f;
+    for (int id : ids) {
+        total += probs[id];
+    }
+    std::sort(ids.begin(), ids.end(), [&probs](int a, int b) { return probs[a] > probs[b]; });
+    for (int id : ids) {
+        if (static_cast<int>(out.size()) >= std::max(1, options.top_k)) {
+            break;
+        }
+        out.push_back({whisper_lang_str(id), total > 0.0f ? probs[id] / total : 0.0f});
+    }
+    return !out.empty();
+}
+
+bool engine_detect_language_file(const char* audio_path, const LanguageDetectOptions& options, int n_threads,
+                                 std::vector<LanguageProb>& out) {
+    std::vector<float> pcm;
+    int sample_rate = 0;
+    if (!read_wav(audio_path, pcm, sample_rate)) {
+        LOGE("Failed to read WAV file");
+        return false;
+    }
+    if (sample_rate != WHISPER_SAMPLE_RATE && sample_rate > 0) {
+        std::vector<float> resampled;
+        resample_linear(pcm.data(), pcm.size(), sample_rate, WHISPER_SAMPLE_RATE, resampled);
+        pcm = std::move(resampled);
+    }
+    trim_silence(pcm, WHISPER_SAMPLE_RATE, TrimOptions());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_context == nullptr) {
+        LOGE("Model not loaded");
+        return false;
+    }
+    const auto detect_start = std::chrono::steady_clock::now();
+    const bool ok = detect_language(pcm.data(), pcm.size(), options, n_threads, out);
+    if (ok) {
+        LOGI("Detected language %s (p=%.2f) in %.0f ms", out[0].language.c_str(), out[0].prob, elapsed_ms(detect_start));
+    }
+    return ok;
+}
+
+/**
+ * Re-decode cached audio with the current language/task; false on a miss or when
+ * the cached run has no usable language
+ */
+static bool decode_cached(uint64_t key, size_t n_samples, const TranscribeOptions& options, int token_cap,
+                          TranscribeResult& result) {
+    int cached_lang = -1;
+    struct whisper_state* state = g_encoder_cache.find(key, cached_lang);
+    if (state == nullptr) {
+        return false;
+    }
+
+    CachedDecodeRequest request;
+    const std::string language = language_or_auto(options);
+    request.lang_id = language == "auto" ? cached_lang : whisper_lang_id(language.c_str());
+    request.translate = options.translate;
+    request.prompt.assign(options.prompt_tokens.begin(), options.prompt_tokens.end());
+    request.n_threads = options.n_threads;
+    request.max_tokens = token_cap;
+    request.stop_repetition = options.repetition_guard;
+    if (request.lang_id < 0 && whisper_is_multilingual(g_context)) {
+        return false;
+    }
+
+    const auto decode_start = std::chrono::steady_clock::now();
+    CachedDecodeResult decoded;
+    if (!encoder_cache_decode(g_context, state, request, decoded)) {
+        return false;
+    }
+    result.timings.decode_ms = elapsed_ms(decode_start);
+    TranscribeSegment segment;
+    segment.text = std::move(decoded.text);
+    segment.n_tokens = decoded.n_tokens;
+    segment.avg_logprob = decoded.n_tokens > 0 ? decoded.sum_logprob / decoded.n_tokens : 0.0f;
+    segment.compression_ratio = compression_ratio(segment.text);
+    segment.t1_ms = static_cast<int64_t>(n_samples * 100 / WHISPER_SAMPLE_RATE);
+    result.segments.push_back(std::move(segment));
+    result.encoder_cache_hit = true;
+    LOGI("Encoder cache hit: decoder only (%llu hits / %llu misses)",
+         static_cast<unsigned long long>(g_encoder_cache.hits()),
+         static_cast<unsigned long long>(g_encoder_cache.misses()));
+    return true;
+}
+
+/**
+ * Map whisper's segment timestamps (10 ms units on the audio it was given) back to the
+ * recording in milliseconds, through the stretch map and then the VAD timeline when used,
+ * and assemble text and confidence
+ */
+static void finish_segments(const StretchMap* stretch, const VadTimeline* timeline, TranscribeResult& result) {
+    for (TranscribeSegment& segment : result.segments) {
+        if (stretch != nullptr) {
+            segment.t0_ms = stretch->to_source_cs(segment.t0_ms, WHISPER_SAMPLE_RATE);
+            segment.t1_ms = stretch->to_source_cs(segment.t1_ms, WHISPER_SAMPLE_RATE);
+        }
+        if (timeline != nullptr) {
+            segment.t0_ms = timeline->to_source_cs(segment.t0_ms, WHISPER_SAMPLE_RATE);
+            segment.t1_ms = timeline->to_source_cs(segment.t1_ms, WHISPER_SAMPLE_RATE);
+        }
+        segment.t0_ms *= 10;
+        segment.t1_ms *= 10;
+        result.text += segment.text;
+    }
+    result.n_segments = static_cast<int>(result.segments.size());
+    result.confidence = summarize_confidence(result.segments, result.text);
+}
+
+bool engine_transcribe_pcm(const std::vector<float>& pcm, const TranscribeOptions& options, TranscribeResult& result) {
+    return transcribe_pcm(pcm, options, result, MelSource(), false);
+}
+
+/**
+ * has_sound: edge trimming found sustained sound in pcm, so an empty VAD result is not trusted
+ */
+static bool transcribe_pcm(const std::vector<float>& pcm, const TranscribeOptions& options, TranscribeResult& result,
+                           const MelSource& mel_source, bool has_sound) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const auto call_start = std::chrono::steady_clock::now();
+    result = TranscribeResult();
+    result.n_samples = pcm.size();
+    result.profile = options.profile;
+
+    if (g_context == nullptr) {
+        LOGE("Model not loaded");
+        return false;
+    }
+
+    ResultCacheKey result_key;
+    if (options.result_cache && g_model_id != 0) {
+        const auto lookup_start = std::chrono::steady_clock::now();
+        result_key.audio = content_hash_pcm(pcm.data(), pcm.size());
+        result_key.options = result_options_hash(options);
+        result_key.model = g_model_id;
+        CachedTranscript cached;
+        const bool hit = g_result_cache.lookup(result_key, cached);
+        result.timings.lookup_ms = elapsed_ms(lookup_start);
+        LOGI("Result cache %s in %.2f ms (hit rate %.0f%% over %llu lookups)", hit ? "hit" : "miss",
+             result.timings.lookup_ms, g_result_cache.hit_rate() * 100.0,
+             static_cast<unsigned long long>(g_result_cache.hits() + g_result_cache.misses()));
+        if (hit) {
+            result.text = std::move(cached.text);
+            result.segments = std::move(cached.segments);
+            result.n_segments = static_cast<int>(result.segments.size());
+            result.n_speech_samples = cached.n_speech_samples;
+            result.confidence = summarize_confidence(result.segments, result.text);
+            result.result_cache_hit = true;
+            return true;
+        }
+    }
+
+    // Drop silence before the encoder sees it; timestamps are mapped back through the timeline
+    const float* samples = pcm.data();
+    size_t n_samples = pcm.size();
+    std::vector<float> speech;
+    VadTimeline timeline;
+    std::vector<SpeechInterval> intervals;
+    const size_t gap_samples = static_cast<size_t>(WHISPER_SAMPLE_RATE) * options.vad.gap_ms / 1000;
+    if (options.vad.enabled) {
+        const auto vad_start = std::chrono::steady_clock::now();
+        intervals = vad_detect(pcm.data(), pcm.size(), WHISPER_SAMPLE_RATE, options.vad);
+        if (intervals.empty() && has_sound) {
+            LOGW("VAD kept nothing of audio with sound, decoding it unpacked");
+            intervals.push_back({0, pcm.size()});
+        }
+        timeline.pack(pcm.data(), intervals, gap_samples, speech);
+        result.timings.vad_ms = elapsed_ms(vad_start);
+
+        if (speech.empty()) {
+            LOGI("No speech detected, skipping transcription");
+            return true;
+        }
+        samples = speech.data();
+        n_samples = speech.size();
+    }
+
+    // Loop guard of this call; the token cap follows the speech before any speed-up
+    RepetitionGuard guard;
+    RepetitionGuard* run_guard = options.repetition_guard ? &guard : nullptr;
+    const int token_cap = options.repetition_guard ? repetition_token_cap(n_samples) : 0;
+
+    // Optional speed-up; timestamps go back through the stretch map, then the VAD timeline
+    std::vector<float> compressed;
+    StretchMap stretch;
+    if (options.stretch.factor > 1.0f) {
+        const auto stretch_start = std::chrono::steady_clock::now();
+        if (stretch.compress(samples, n_samples, WHISPER_SAMPLE_RATE, options.stretch, compressed)) {
+            samples = compressed.data();
+            n_samples = compressed.size();
+        }
+        result.timings.stretch_ms = elapsed_ms(stretch_start);
+    }
+    result.n_speech_samples = n_samples;
+
+    // Restricted language identification instead of whisper_full's own auto-detect pass
+    TranscribeOptions run_options = options;
+    pin_english_only(g_context, run_options);
+    const bool detect = run_options.detect.enabled && std::string(language_or_auto(run_options)) == "auto";
+    if (detect) {
+        const auto detect_start = std::chrono::steady_clock::now();
+        if (detect_language(samples, n_samples, run_options.detect, run_options.n_threads, result.languages)) {
+            run_options.language = result.languages[0].language;
+            LOGI("Detected language %s (p=%.2f)", run_options.language.c_str(), result.languages[0].prob);
+        }
+        result.timings.detect_ms = elapsed_ms(detect_start);
+    }
+
+    // Latency budget: start cheaper when recent runs say the profile cannot make it
+    const int n_windows = static_cast<int>((n_samples + WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE - 1) /
+                                           (WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE));
+    DecodeBudget budget;
+    if (run_options.budget_ms > 0) {
+        budget.deadline = call_start + std::chrono::milliseconds(run_options.budget_ms);
+        budget.cancel = run_options.cancel;
+        const double left_ms = run_options.budget_ms - elapsed_ms(call_start);
+        while (run_options.profile != DecodeProfile::Fast && run_options.beam_size <= 1) {
+            const double predicted_ms = g_window_ms[static_cast<int>(run_options.profile)] * n_windows;
+            if (predicted_ms <= left_ms) {
+                break;
+            }
+            const DecodeProfile cheaper = decode_profile_downgrade(run_options.profile);
+            LOGI("Latency budget: %s expected to take %.0f of %.0f ms left, using %s",
+                 decode_profile_name(run_options.profile), predicted_ms, left_ms, decode_profile_name(cheaper));
+            run_options.profile = cheaper;
+            result.downgraded = true;
+        }
+        result.profile = run_options.profile;
+        budget.pace = run_options.profile != DecodeProfile::Fast && run_options.beam_size <= 1;
+    }
+    DecodeBudget* run_budget = run_options.budget_ms > 0 ? &budget : nullptr;
+
+    // Long recordings are decoded as parallel chunks on a pool of whisper_states
+    std::vector<AudioChunk> chunks;
+    if (run_options.n_parallel != 1) {
+        chunks = plan_chunks(samples, n_samples, WHISPER_SAMPLE_RATE, ChunkOptions());
+    }
+
+    // A mel computed during recording covers single-pass runs on uncompressed audio: the
+    // packed speech is the same recording ranges, so its frames are selected instead of recomputed
+    PreparedMel prepared;
+    const bool use_mel = mel_source.mel != nullptr && chunks.size() <= 1 && compressed.empty() &&
+                         mel_source.mel->n_mels() == whisper_model_n_mels(g_context);
+    if (use_mel) {
+        const auto mel_start = std::chrono::steady_clock::now();
+        std::vector<MelRange> ranges;
+        if (run_options.vad.enabled) {
+            for (const SpeechInterval& interval : intervals) {
+                ranges.push_back({mel_source.offset + interval.start, mel_source.offset + interval.end});
+            }
+        } else {
+            ranges.push_back({mel_source.offset, mel_source.offset + pcm.size()});
+        }
+        mel_source.mel->build(ranges, run_options.vad.enabled ? gap_samples : 0, prepared.data, prepared.n_len, prepared.n_samples);
+        result.timings.mel_ms = elapsed_ms(mel_start);
+    }
+
+    // Single-window audio seen before (same samples after VAD/stretch) only needs the decoder
+    const bool cacheable = run_options.encoder_cache > 0 && chunks.size() <= 1 &&
+                           n_samples <= static_cast<size_t>(WHISPER_SAMPLE_RATE) * 30;
+    const uint64_t encoder_key = cacheable ? content_hash_pcm(samples, n_samples) : 0;
+
+    if (cancel_requested(run_options)) {
+        LOGI("Transcription cancelled before decoding");
+        result.cancelled = true;
+        return false;
+    }
+
+    LOGI("Starting transcription...");
+    whisper_reset_timings(g_context);
+    const auto full_start = std::chrono::steady_clock::now();
+    bool ok = false;
+    // The cached decode is plain greedy text; constrained runs go through whisper_full
+    const bool constrained = run_options.grammar || !run_options.suppress_regex.empty() || run_options.max_tokens > 0;
+    const bool beam = run_options.beam_size > 1 || decode_profile_params(run_options.profile).beam_size > 1;
+    // The duration cap joins after the cached-decode check, which applies it by itself
+    const int max_tokens = run_options.max_tokens > 0 ? run_options.max_tokens
+                         : run_options.grammar        ? kGrammarMaxTokens
+                                                      : 0;
+    if (token_cap > 0 && (max_tokens == 0 || token_cap < max_tokens)) {
+        run_options.max_tokens = token_cap;
+    }
+    // Only callers that opted into the decoder-only path get its simpler output (see encoder_cache.h)
+    if (cacheable && run_options.encoder_cache_decode && !beam && !constrained &&
+        decode_cached(encoder_key, n_samples, run_options, token_cap, result)) {
+        ok = true;
+    } else if (chunks.size() > 1) {
+        ok = transcribe_chunks(samples, chunks, run_options, result, run_budget, run_guard);
+    } else {
+        struct whisper_state* state = cacheable
+            ? g_encoder_cache.acquire(g_context, std::min(static_cast<size_t>(run_options.encoder_cache), state_cap()))
+            : nullptr;
+        int n_encodes = 0;
+        ok = transcribe_serial(g_context, samples, n_samples, run_options, result, use_mel ? &prepared : nullptr,
+                               state, &n_encodes, run_budget, run_guard);
+        // whisper may seek to a later window within short audio; only a single pass at offset 0 is reusable
+        if (ok && state != nullptr && n_encodes == 1 && !result.budget_exceeded) {
+            g_encoder_cache.commit(state, encoder_key, whisper_full_lang_id_from_state(state));
+        }
+    }
+    result.timings.full_ms = elapsed_ms(full_start);
+
+    if (!ok) {
+        return false;
+    }
+
+    result.n_repetition_stops = guard.n_stops;
+    if (result.n_repetition_stops > 0) {
+        const size_t n_words = collapse_repetitions(result.segments);
+        LOGI("Repetition guard ended %d decodes, %zu repeated words dropped", result.n_repetition_stops, n_words);
+    }
+
+    // Serial runs that kept their profile to the end teach the budget what a window costs
+    const bool partial = result.downgraded || result.budget_exceeded;
+    if (chunks.size() <= 1 && !result.encoder_cache_hit && !partial && !beam && n_windows > 0) {
+        double& window_ms = g_window_ms[static_cast<int>(run_options.profile)];
+        const double observed = result.timings.full_ms / n_windows;
+        window_ms = window_ms > 0.0 ? 0.7 * window_ms + 0.3 * observed : observed;
+    }
+
+    // Segment timestamps are on the packed (and compressed) timeline; map them back to the recording
+    finish_segments(compressed.empty() ? nullptr : &stretch, run_options.vad.enabled ? &timeline : nullptr, result);
+
+    // Results cut short by the budget are not what these options produce
+    if (run_options.result_cache && g_model_id != 0 && !partial) {
+        CachedTranscript transcript;
+        transcript.text = result.text;
+        transcript.segments = result.segments;
+        transcript.n_speech_samples = result.n_speech_samples;
+        g_result_cache.store(result_key, transcript);
+    }
+
+    LOGI("Final transcription: %zu chars in %.0f ms (%zu of %zu samples after VAD/stretch)",
+         result.text.length(), result.timings.full_ms, result.n_speech_samples, result.n_samples);
+    LOGI("Confidence: avg logprob %.2f over %d tokens, no-speech %.2f, compression ratio %.2f",
+         result.confidence.avg_logprob, result.confidence.n_tokens, result.confidence.no_speech_prob,
+         result.confidence.compression_ratio);
+    return true;
+}
+
+bool engine_load_draft_model(const char* model_path) {
+    std::lock_guard<std::mutex> lock(g_draft_mutex);
+    LOGI("Loading draft model from: %s", model_path);
+    if (g_draft_context != nullptr) {
+        whisper_free(g_draft_context);
+        g_draft_context = nullptr;
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = false;
+    g_draft_context = whisper_init_from_file_with_params(model_path, cparams);
+    if (g_draft_context == nullptr) {
+        LOGE("Failed to load draft model");
+        return false;
+    }
+    LOGI("Draft model loaded in %.0f ms", elapsed_ms(load_start));
+    return true;
+}
+
+void engine_unload_draft_model() {
+    std::lock_guard<std::mutex> lock(g_draft_mutex);
+    if (g_draft_context != nullptr) {
+        LOGI("Unloading draft model");
+        whisper_free(g_draft_context);
+        g_draft_context = nullptr;
+    }
+}
+
+bool engine_is_draft_model_loaded() {
+    std::lock_guard<std::mutex> lock(g_draft_mutex);
+    return g_draft_context != nullptr;
+}
+
+bool engine_transcribe_draft(const AudioInput& audio, const TranscribeOptions& options, TranscribeResult& result) {
+    std::lock_guard<std::mutex> lock(g_draft_mutex);
+    result = TranscribeResult();
+
+    if (g_draft_context == nullptr) {
+        LOGE("Draft model not loaded");
+        return false;
+    }
+
+    const float* samples = audio.pcm.data();
+    size_t n_samples = audio.pcm.size();
+    std::vector<float> speech;
+    VadTimeline timeline;
+    if (options.vad.enabled) {
+        const auto vad_start = std::chrono::steady_clock::now();
+        std::vector<SpeechInterval> intervals = vad_detect(samples, n_samples, WHISPER_SAMPLE_RATE, options.vad);
+        if (intervals.empty() && audio.trim.sound) {
+            LOGW("VAD kept nothing of audio with sound, drafting it unpacked");
+            intervals.push_back({0, n_samples});
+        }
+        timeline.pack(samples, intervals, static_cast<size_t>(WHISPER_SAMPLE_RATE) * options.vad.gap_ms / 1000, speech);
+        result.timings.vad_ms = elapsed_ms(vad_start);
+        if (speech.empty()) {
+            LOGI("No speech detected, skipping draft");
+            apply_trim(audio, result);
+            return true;
+        }
+        samples = speech.data();
+        n_samples = speech.size();
+    }
+    result.n_speech_samples = n_samples;
+
+    // Tiny loops more readily than the larger models
+    TranscribeOptions draft_options = options;
+    pin_english_only(g_draft_context, draft_options);
+    RepetitionGuard guard;
+    const int token_cap = options.repetition_guard ? repetition_token_cap(n_samples) : 0;
+    if (token_cap > 0 && (options.max_tokens == 0 || token_cap < options.max_tokens)) {
+        draft_options.max_tokens = token_cap;
+    }
+
+    whisper_reset_timings(g_draft_context);
+    const auto full_start = std::chrono::steady_clock::now();
+    const bool ok = transcribe_serial(g_draft_context, samples, n_samples, draft_options, result, nullptr, nullptr,
+                                      nullptr, nullptr, options.repetition_guard ? &guard : nullptr);
+    result.timings.full_ms = elapsed_ms(full_start);
+    if (!ok) {
+        return false;
+    }
+    result.n_repetition_stops = guard.n_stops;
+    if (result.n_repetition_stops > 0) {
+        collapse_repetitions(result.segments);
+    }
+
+    finish_segments(nullptr, options.vad.enabled ? &timeline : nullptr, result);
+    apply_trim(audio, result);
+    LOGI("Draft transcription: %zu chars in %.0f ms", result.text.length(), result.timings.full_ms);
+    return true;
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "audio_converter.h"
+#include "decode_profile.h"
+#include "incremental_mel.h"
+#include "model_header.h"
+#include "time_stretch.h"
+#include "vad.h"
+
+struct CompiledGrammar;
+
+/**
+ * Platform-neutral transcription core
+ * Shared by the Android JNI bridge and the host tools so both run the exact
+ * same load -> read_wav -> transcribe path.
+ */
+
+/**
+ * Up-front language identification for "auto" transcriptions
+ * One encoder pass on a speech prefix, as whisper_full's own auto-detect does,
+ * but restricted to the candidate languages and with the probabilities exposed
+ * so callers can cache a confident result.
+ */
+struct LanguageDetectOptions {
+    bool enabled = false;
+    std::vector<std::string> candidates;  // ISO-639-1 codes; empty allows every language
+    int prefix_ms = 10000;                // Leading speech analysed (the encoder pads to 30 s anyway)
+    int top_k = 3;
+};
+
+struct LanguageProb {
+    std::string language;
+    float prob = 0.0f;  // Renormalized over the candidate set
+};
+
+struct TranscribeOptions {
+    std::string language;   // ISO-639-1 code, empty or "auto" to auto-detect
+    bool translate = false;
+    int n_threads = 4;      // Use 4 threads for mobile
+    DecodeProfile profile = DecodeProfile::Balanced; // Sampling strategy (see decode_profile.h)
+    int beam_size = 0;      // > 1 forces beam search of this width, overriding the profile
+    int budget_ms = 0;      // Wall-clock budget from the start of the call (0 = none), see below
+    TrimOptions trim;       // Edge silence cut right after read_wav (file input only)
+    VadOptions vad;         // Only detected speech intervals reach whisper_full
+    StretchOptions stretch; // WSOLA speed-up of the speech fed to whisper (factor 1.0 = off)
+    int n_parallel = 0;     // Concurrent chunk decoders for recordings over ~30 s (0 = auto, 1 = serial)
+    int n_threads_long = 0; // Thread budget split across parallel chunks (0 = all cores)
+    int encoder_cache = 0;  // Single-window runs whose encoder output is kept for reprocessing (0 = off)
+    bool encoder_cache_decode = false; // Let a hit skip whisper_full: greedy, no fallback, one untimed segment
+    bool result_cache = false; // Return stored results for identical audio, options and model
+    LanguageDetectOptions detect; // Replaces whisper_full's auto-detect when language is "auto"
+    std::vector<int32_t> prompt_tokens; // Preceding context (see PromptCache), decoded before each window
+    std::shared_ptr<const CompiledGrammar> grammar; // Constrain output to a GBNF grammar (see GrammarCache)
+    float grammar_penalty = 100.0f; // Logit penalty for tokens the grammar rejects
+    std::string suppress_regex;     // Tokens matching it are never sampled (see input_field.h)
+    int max_tokens = 0;             // Per-segment token cap (0 = none, or 32 under a grammar)
+    bool repetition_guard = true;   // Stop decoder loops early, cap tokens by duration (see repetition_guard.h)
+    const std::atomic<bool>* cancel = nullptr; // Aborts the run between graph nodes once set (see RefinementJob)
+};
+
+/*
+ * Latency budget (TranscribeOptions::budget_ms)
+ * A profile whose recent per-window decode time predicts an overrun starts one step cheaper.
+ * During a serial run, a 30 s window that would end past the deadline at the pace of the
+ * windows before it is not started; the rest of the audio is decoded with the Fast profile.
+ * Chunked runs switch the chunks not yet started to Fast the same way. At the deadline itself
+ * whisper is stopped and the text of the windows finished by then is returned.
+ */
+
+/**
+ * Per-phase timings in milliseconds
+ */
+struct TranscribeTimings {
+    double read_ms = 0.0;     // WAV decode, PCM conversion and edge trimming
+    double lookup_ms = 0.0;   // Result cache: hashing the PCM and the lookup
+    double vad_ms = 0.0;      // Speech detection and packing
+    double detect_ms = 0.0;   // Up-front language identification
+    double stretch_ms = 0.0;  // WSOLA time compression
+    double mel_ms = 0.0;      // Assembling a precomputed mel (0 when whisper computed it)
+    double full_ms = 0.0;     // whisper_full wall time
+    double sample_ms = 0.0;   // Token sampling (whisper internal)
+    double encode_ms = 0.0;   // Encoder (whisper internal, context's default state only)
+    double decode_ms = 0.0;   // Decoder, incl. batched and prompt passes (whisper internal, or wall time on a cache hit)
+};
+
+/**
+ * Segment with timestamps on the original recording timeline (milliseconds)
+ */
+struct TranscribeSegment {
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+    std::string text;
+    float avg_logprob = 0.0f;       // Mean log-probability of the segment's text tokens
+    float no_speech_prob = 0.0f;    // whisper's no-speech probability for the window (0 when unknown)
+    float compression_ratio = 0.0f; // Text bytes / zlib bytes; repetition loops score high
+    int n_tokens = 0;               // Text tokens behind avg_logprob
+};
+
+/**
+ * Whole-transcript confidence, the signals whisper's own temperature fallback uses
+ * (it retries below avg_logprob -1.0 or above compression_ratio 2.4, and treats
+ * no_speech_prob > 0.6 with a low avg_logprob as silence)
+ */
+struct TranscriptConfidence {
+    float avg_logprob = 0.0f;       // Token-weighted over all segments
+    float no_speech_prob = 0.0f;    // Highest of any segment
+    float compression_ratio = 0.0f; // Of the full text
+    int n_tokens = 0;
+};
+
+struct TranscribeResult {
+    std::string text;
+    int n_segments = 0;
+    std::vector<TranscribeSegment> segments;
+    size_t n_samples = 0;        // 16 kHz mono samples in the recording
+    size_t n_trimmed_leading = 0;  // Edge silence cut before VAD
+    size_t n_trimmed_trailing = 0;
+    size_t n_speech_samples = 0; // Samples fed to whisper after VAD and time compression
+    bool precomputed_mel = false;  // Mel came from IncrementalMel instead of whisper_pcm_to_mel
+    bool encoder_cache_hit = false; // Decoded from a cached encoder output; one segment, no timestamps
+    bool result_cache_hit = false;  // Text and segments came from the result cache
+    std::vector<LanguageProb> languages; // Top-k of the up-front detection, most likely first
+    bool cancelled = false;      // Stopped through options.cancel; text and segments are empty
+    DecodeProfile profile = DecodeProfile::Balanced; // Profile the run finished with
+    bool downgraded = false;     // The budget moved (part of) the run to a cheaper profile
+    bool budget_exceeded = false; // Stopped at the deadline; text covers the windows finished by then
+    int n_repetition_stops = 0;  // Decodes the repetition guard ended; their repeats are collapsed
+    TranscriptConfidence confidence;
+    TranscribeTimings timings;
+};
+
+/**
+ * Decoded 16 kHz recording, read once and shared by several transcriptions of it
+ * (the draft model's and the main model's refinement)
+ */
+struct AudioInput {
+    std::vector<float> pcm;   // After resampling and edge trimming
+    int sample_rate = 0;      // Of the file as recorded
+    size_t n_recorded = 0;    // Samples before trimming
+    TrimResult trim;
+    double read_ms = 0.0;
+};
+
+/**
+ * Load a model, replacing any loaded one
+ * cache_dir persists the result cache (null or empty to keep it in memory)
+ */
+bool engine_load_model(const char* model_path, const char* cache_dir);
+
+/**
+ * Free the loaded model
+ */
+void engine_unload_model();
+
+/**
+ * Check if a model is loaded
+ */
+bool engine_is_model_loaded();
+
+/**
+ * Mel bins the loaded model expects (80, or 128 for large-v3); 0 when no model is loaded
+ */
+int engine_model_n_mels();
+
+/**
+ * Header hyperparameters of the loaded model (layer counts, mel bins, tensor type)
+ * false when no model is loaded
+ */
+bool engine_model_hparams(ModelHparams& out);
+
+/**
+ * Whether the loaded model is multilingual; English-only checkpoints (*.en) always
+ * transcribe English, so language detection and translation are skipped for them
+ */
+bool engine_model_is_multilingual();
+
+/**
+ * Tokenize text with the loaded model's vocabulary
+ */
+bool engine_tokenize(const std::string& text, std::vector<int32_t>& tokens);
+
+/**
+ * Identify the spoken language of a WAV file without transcribing it
+ * out receives up to options.top_k candidates, most likely first
+ */
+bool engine_detect_language_file(const char* audio_path, const LanguageDetectOptions& options, int n_threads,
+                                 std::vector<LanguageProb>& out);
+
+/**
+ * Lookup counters of the transcription caches since the process started
+ */
+struct EngineCacheStats {
+    uint64_t result_hits = 0;
+    uint64_t result_misses = 0;
+    size_t result_entries = 0;
+    uint64_t encoder_hits = 0;
+    uint64_t encoder_misses = 0;
+};
+
+EngineCacheStats engine_cache_stats();
+
+/**
+ * Read a WAV file and transcribe it
+ * mel (optional) is the finished IncrementalMel of the same recording; it replaces
+ * whisper's own mel computation when the audio reaches whisper in a single pass
+ */
+bool engine_transcribe_file(const char* audio_path, const TranscribeOptions& options, TranscribeResult& result,
+                            const IncrementalMel* mel = nullptr);
+
+/**
+ * Read, resample and trim a WAV file for engine_transcribe_audio / engine_transcribe_draft
+ */
+bool engine_read_audio(const char* audio_path, const TrimOptions& trim, AudioInput& audio);
+
+/**
+ * Transcribe audio read by engine_read_audio; timestamps are on the untrimmed recording
+ */
+bool engine_transcribe_audio(const AudioInput& audio, const TranscribeOptions& options, TranscribeResult& result);
+
+/**
+ * Transcribe 16 kHz mono float PCM
+ */
+bool engine_transcribe_pcm(const std::vector<float>& pcm, const TranscribeOptions& options, TranscribeResult& result);
+
+/**
+ * Draft model, resident next to the main model
+ * A small model (tiny) answers long dictations within a few hundred ms while the main
+ * model refines the same audio in the background. Both have their own lock, so a draft
+ * never waits for a running refinement.
+ */
+bool engine_load_draft_model(const char* model_path);
+
+void engine_unload_draft_model();
+
+bool engine_is_draft_model_loaded();
+
+/**
+ * Transcribe with the draft model
+ * One serial whisper_full pass behind the VAD; result/encoder caches, chunked decoding,
+ * time compression and up-front language detection are main-model features.
+ */
+bool engine_transcribe_draft(const AudioInput& audio, const TranscribeOptions& options, TranscribeResult& result);
@@ -1,55 +1,216 @@
 #include <jni.h>
+#include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
-#include <android/log.h>
-#include "whisper.h"
+#include "whisper_engine.h"
+#include "cpu_features.h"
+#include "endpoint.h"
+#include "grammar_cache.h"
+#include "incremental_mel.h"
+#include "input_field.h"
+#include "model_pack.h"
+#include "prompt_cache.h"
+#include "refinement.h"
 
 #define LOG_TAG "WhisperJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "hw_log.h"
 
-// Global context handle
-static struct whisper_context* g_context = nullptr;
+// Session settings applied to every nativeTranscribe call, and the last call's segments
+static std::mutex g_session_mutex;
+static VadOptions g_vad_options;
+static StretchOptions g_stretch_options;
+static std::vector<TranscribeSegment> g_last_segments;
+static TranscriptConfidence g_last_confidence;
+// Recent recordings whose encoder output is kept, so reprocessing runs the decoder only
+static constexpr int kEncoderCacheEntries = 2;
+// Restricted language detection for "auto" requests, and the language it settled on for this
+// session once a detection was confident enough
+static LanguageDetectOptions g_detect_options;
+static float g_language_threshold = 0.8f;
+static std::string g_session_language;
+// Text before the cursor and recent transcriptions, fed to each utterance as prompt tokens
+static PromptCache g_prompt_cache;
+// Grammars compiled this session, and the one constraining transcriptions (null = free text)
+static GrammarCache g_grammar_cache;
+static std::shared_ptr<const CompiledGrammar> g_grammar;
+// Kind of field being dictated into; its grammar applies while no explicit grammar is set
+static InputFieldType g_field_type = InputFieldType::Text;
+static std::shared_ptr<const CompiledGrammar> g_field_grammar;
+// Mel finished for a recording, consumed by the next nativeTranscribe of the same file
+static std::unique_ptr<IncrementalMel> g_pending_mel;
+static std::string g_pending_mel_path;
+// Main-model pass over the audio of the last draft, and the options it runs with
+static RefinementJob g_refinement;
+static uint64_t g_refinement_id = 0;
+static TranscribeOptions g_refinement_options;
 
-// Forward declaration
-extern bool read_wav(const char* filename, std::vector<float>& pcm_data, int& sample_rate);
+static std::vector<std::string> to_strings(JNIEnv* env, jobjectArray array) {
+    std::vector<std::string> out;
+    const jsize n = array != nullptr ? env->GetArrayLength(array) : 0;
+    for (jsize i = 0; i < n; i++) {
+        auto item = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+        const char* chars = env->GetStringUTFChars(item, nullptr);
+        out.emplace_back(chars);
+        env->ReleaseStringUTFChars(item, chars);
+        env->DeleteLocalRef(item);
+    }
+    return out;
+}
+
+/**
+ * Tokenize prompt context added since the last call
+ * Runs without g_session_mutex: engine_tokenize waits for the model, which a transcription
+ * may hold for seconds.
+ */
+static void tokenize_prompt_context() {
+    std::vector<std::string> texts;
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        texts = g_prompt_cache.untokenized();
+        epoch = g_prompt_cache.epoch();
+    }
+    if (texts.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<int32_t>> tokens(texts.size());
+    std::vector<bool> ok(texts.size());
+    for (size_t i = 0; i < texts.size(); i++) {
+        ok[i] = engine_tokenize(texts[i], tokens[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    for (size_t i = 0; i < texts.size(); i++) {
+        if (ok[i]) {
+            g_prompt_cache.add_tokens(texts[i], tokens[i], epoch);
+        }
+    }
+}
+
+/**
+ * Options for a transcription under the current session settings, with the dictation
+ * context as prompt unless with_prompt is false
+ * Caller holds g_session_mutex, after tokenize_prompt_context().
+ */
+static TranscribeOptions session_options(const char* lang, bool translate, bool with_prompt = true) {
+    TranscribeOptions options;
+    options.language = lang;
+    options.translate = translate;
+    options.encoder_cache = kEncoderCacheEntries;
+    options.result_cache = true;
+    options.vad = g_vad_options;
+    options.stretch = g_stretch_options;
+    // Constrained phrases (commands, field values) neither use nor extend the dictation context
+    options.grammar = g_grammar;
+    if (!options.grammar && g_field_grammar) {
+        const InputFieldConstraints& field = input_field_constraints(g_field_type);
+        options.grammar = g_field_grammar;
+        options.suppress_regex = field.suppress_regex != nullptr ? field.suppress_regex : "";
+        options.max_tokens = field.max_tokens;
+    }
+    if (!options.grammar && with_prompt) {
+        options.prompt_tokens = g_prompt_cache.tokens();
+    }
+    if (options.language.empty() || options.language == "auto") {
+        if (!g_session_language.empty()) {
+            options.language = g_session_language;
+        } else {
+            options.detect = g_detect_options;
+        }
+    }
+    return options;
+}
+
+/**
+ * Publish a finished transcription to the session: last segments and confidence and, unless
+ * extend_context is false, prompt context and (after a confident detection) the session language
+ * Caller holds g_session_mutex.
+ */
+static void record_result(const TranscribeOptions& options, bool ok, const TranscribeResult& result,
+                          bool extend_context = true) {
+    g_last_segments = ok ? result.segments : std::vector<TranscribeSegment>();
+    g_last_confidence = ok ? result.confidence : TranscriptConfidence();
+    if (!extend_context) {
+        return;
+    }
+    if (ok && !options.grammar) {
+        g_prompt_cache.append(result.text);
+    }
+    if (ok && !result.languages.empty() && result.languages[0].prob >= g_language_threshold &&
+        g_session_language.empty() && options.detect.enabled) {
+        g_session_language = result.languages[0].language;
+        LOGI("Session language set to %s (p=%.2f)", g_session_language.c_str(), result.languages[0].prob);
+    }
+}
 
 extern "C" {
 
+/**
+ * Load the ggml CPU backend variant best suited to this device
+ * libDir is the app's native library directory holding libggml-cpu-*.so
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeInitBackends(
+    JNIEnv* env,
+    jobject thiz,
+    jstring libDir
+) {
+    const char* lib_dir = env->GetStringUTFChars(libDir, nullptr);
+    cpu_backends_load(lib_dir);
+    env->ReleaseStringUTFChars(libDir, lib_dir);
+}
+
+/**
+ * Describe the CPU variant selected at runtime (HWCAP probe + ggml backend features)
+ */
+JNIEXPORT jstring JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetCpuVariant(
+    JNIEnv* env,
+    jobject thiz
+) {
+    const std::string variant = cpu_features_variant(cpu_features_probe());
+    const std::string description = variant + " (" + cpu_backends_describe() + ")";
+    return env->NewStringUTF(description.c_str());
+}
+
 /**
  * Load whisper model from file path
+ * The result cache persists to cacheDir (empty to keep it in memory)
  */
 JNIEXPORT jboolean JNICALL
 Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeLoadModel(
     JNIEnv* env,
     jobject thiz,
-    jstring modelPath
+    jstring modelPath,
+    jstring cacheDir
 ) {
     const char* path = env->GetStringUTFChars(modelPath, nullptr);
-    LOGI("Loading model from: %s", path);
+    const char* cache_dir = env->GetStringUTFChars(cacheDir, nullptr);
 
-    // Release previous model if loaded
-    if (g_context != nullptr) {
-        whisper_free(g_context);
-        g_context = nullptr;
+    // A refinement would hold the model until it finishes
+    g_refinement.cancel();
+    const bool loaded = engine_load_model(path, cache_dir);
+    {
+        // A new model may hear the session differently (and tokenizes the prompt its own way)
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        g_session_language.clear();
+        g_prompt_cache.invalidate();
     }
 
-    // Load model
-    g_context = whisper_init_from_file(path);
-
     env->ReleaseStringUTFChars(modelPath, path);
+    env->ReleaseStringUTFChars(cacheDir, cache_dir);
 
-    if (g_context == nullptr) {
-        LOGE("Failed to load model");
-        return JNI_FALSE;
-    }
-
-    LOGI("Model loaded successfully");
-    return JNI_TRUE;
+    return loaded ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
  * Transcribe audio from WAV file
+ * profile is a DecodeProfile; budgetMs > 0 bounds the call (cheaper profile or partial text).
+ * Without sessionContext (reprocessing saved audio) the dictation context is neither used as
+ * prompt nor extended, so the text and its result cache entry depend on the audio alone.
  */
 JNIEXPORT jstring JNICALL
 Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeTranscribe(
@@ -57,73 +218,548 @@ Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeTranscribe(
     jobject thiz,
     jstring audioPath,
     jstring language,
-    jboolean translate
+    jboolean translate,
+    jint profile,
+    jint budgetMs,
+    jboolean sessionContext
 ) {
-    if (g_context == nullptr) {
-        LOGE("Model not loaded");
+    const char* audio_path = env->GetStringUTFChars(audioPath, nullptr);
+    const char* lang = env->GetStringUTFChars(language, nullptr);
+
+    if (sessionContext) {
+        tokenize_prompt_context();
+    }
+    TranscribeOptions options;
+    std::unique_ptr<IncrementalMel> mel;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        options = session_options(lang, translate, sessionContext);
+        // Reprocessing the same recording is what the encoder cache is for: it accepts the
+        // greedy, timestamp-free decode of a cache hit. Dictation always runs whisper_full,
+        // with its temperature fallback and segment timestamps
+        options.encoder_cache_decode = !sessionContext;
+        options.profile = decode_profile_from_int(profile);
+        options.budget_ms = budgetMs > 0 ? budgetMs : 0;
+        if (g_pending_mel && g_pending_mel_path == audio_path) {
+            mel = std::move(g_pending_mel);
+        }
+        g_pending_mel.reset();
+        g_pending_mel_path.clear();
+    }
+
+    TranscribeResult result;
+    const bool ok = engine_transcribe_file(audio_path, options, result, mel.get());
+
+    env->ReleaseStringUTFChars(audioPath, audio_path);
+    env->ReleaseStringUTFChars(language, lang);
+
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        record_result(options, ok, result, sessionContext);
+    }
+    if (result.n_trimmed_leading > 0 || result.n_trimmed_trailing > 0) {  // 16 samples per ms
+        LOGI("Trimmed %zu ms leading / %zu ms trailing silence",
+             result.n_trimmed_leading / 16, result.n_trimmed_trailing / 16);
+    }
+
+    if (result.result_cache_hit) {
+        LOGI("Result cache hit (%.2f ms)", result.timings.lookup_ms);
+    }
+    if (result.precomputed_mel) {
+        LOGI("Used incremental mel (%.1f ms to assemble)", result.timings.mel_ms);
+    }
+    if (result.downgraded || result.budget_exceeded) {
+        LOGI("Latency budget %d ms: %s requested, finished with %s%s", options.budget_ms,
+             decode_profile_name(options.profile), decode_profile_name(result.profile),
+             result.budget_exceeded ? ", text cut at the deadline" : "");
+    }
+
+    if (!ok) {
         return env->NewStringUTF("");
     }
+    return env->NewStringUTF(result.text.c_str());
+}
+
+/**
+ * Load the draft model (tiny) next to the main model
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeLoadDraftModel(
+    JNIEnv* env,
+    jobject thiz,
+    jstring modelPath
+) {
+    const char* path = env->GetStringUTFChars(modelPath, nullptr);
+    const bool loaded = engine_load_draft_model(path);
+    env->ReleaseStringUTFChars(modelPath, path);
+    return loaded ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Free the draft model
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeUnloadDraftModel(
+    JNIEnv* env,
+    jobject thiz
+) {
+    engine_unload_draft_model();
+}
+
+/**
+ * Check if the draft model is loaded
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeIsDraftModelLoaded(
+    JNIEnv* env,
+    jobject thiz
+) {
+    return engine_is_draft_model_loaded() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Rewrite the model at srcPath with its weight matrices at type (e.g. "q8_0") to dstPath
+ * Runs for seconds to minutes on a full-size model; call off the main thread.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativePackModel(
+    JNIEnv* env,
+    jobject thiz,
+    jstring srcPath,
+    jstring dstPath,
+    jstring type
+) {
+    const char* src = env->GetStringUTFChars(srcPath, nullptr);
+    const char* dst = env->GetStringUTFChars(dstPath, nullptr);
+    const char* type_name = env->GetStringUTFChars(type, nullptr);
+
+    ggml_type pack_type;
+    PackStats stats;
+    std::string error;
+    bool packed = pack_type_from_name(type_name, pack_type);
+    if (!packed) {
+        error = std::string("unknown tensor type '") + type_name + "'";
+    }
+    packed = packed && model_pack(src, dst, pack_type, &stats, error);
+    if (packed) {
+        LOGI("Packed %s (%zu -> %zu bytes)", dst, stats.bytes_in, stats.bytes_out);
+    } else {
+        LOGE("Packing %s failed: %s", src, error.c_str());
+    }
+
+    env->ReleaseStringUTFChars(srcPath, src);
+    env->ReleaseStringUTFChars(dstPath, dst);
+    env->ReleaseStringUTFChars(type, type_name);
+    return packed ? JNI_TRUE : JNI_FALSE;
+}
 
+/**
+ * Header hyperparameters of the GGML model at modelPath, in file order: n_vocab, n_audio_ctx,
+ * n_audio_state, n_audio_head, n_audio_layer, n_text_ctx, n_text_state, n_text_head,
+ * n_text_layer, n_mels, ftype. Null when the file is unreadable or not GGML.
+ * The same parser the loader validates with, so the app and the loader cannot disagree.
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetModelHparams(
+    JNIEnv* env,
+    jclass clazz,
+    jstring modelPath
+) {
+    const char* path = env->GetStringUTFChars(modelPath, nullptr);
+    ModelHparams hparams;
+    const bool ok = model_hparams_read(path, hparams);
+    env->ReleaseStringUTFChars(modelPath, path);
+    if (!ok) {
+        return nullptr;
+    }
+
+    const jint fields[] = {
+        hparams.n_vocab, hparams.n_audio_ctx, hparams.n_audio_state, hparams.n_audio_head,
+        hparams.n_audio_layer, hparams.n_text_ctx, hparams.n_text_state, hparams.n_text_head,
+        hparams.n_text_layer, hparams.n_mels, hparams.ftype,
+    };
+    const jsize count = static_cast<jsize>(sizeof(fields) / sizeof(fields[0]));
+    jintArray array = env->NewIntArray(count);
+    if (array != nullptr) {
+        env->SetIntArrayRegion(array, 0, count, fields);
+    }
+    return array;
+}
+
+/**
+ * Transcribe a WAV file with the draft model and start refining it with the main model
+ * The file is read once; the refinement runs on its own thread over the same samples and
+ * is collected with nativeAwaitRefinement. Returns "" when the draft fails (no refinement
+ * is started then). profile (a DecodeProfile) applies to the refinement.
+ */
+JNIEXPORT jstring JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeTranscribeDraft(
+    JNIEnv* env,
+    jobject thiz,
+    jstring audioPath,
+    jstring language,
+    jboolean translate,
+    jint profile
+) {
     const char* audio_path = env->GetStringUTFChars(audioPath, nullptr);
     const char* lang = env->GetStringUTFChars(language, nullptr);
 
-    LOGI("Transcribing: %s, language: %s, translate: %d", audio_path, lang, translate);
+    // Drafts are free text without context, so the prompt is only built for the refinement
+    TranscribeOptions draft_options;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        draft_options = session_options(lang, translate, false);
+        // The recording-time mel is not used for the draft or the refinement
+        g_pending_mel.reset();
+        g_pending_mel_path.clear();
+    }
+    draft_options.detect = LanguageDetectOptions();
+    // Drafts are replaced anyway: one greedy pass, never retried at higher temperatures
+    draft_options.profile = DecodeProfile::Fast;
+
+    auto audio = std::make_shared<AudioInput>();
+    const bool read = engine_read_audio(audio_path, draft_options.trim, *audio);
+    env->ReleaseStringUTFChars(audioPath, audio_path);
 
-    // Read WAV file and extract PCM samples
-    std::vector<float> pcm_data;
-    int sample_rate = 0;
-    if (!read_wav(audio_path, pcm_data, sample_rate)) {
-        LOGE("Failed to read WAV file");
-        env->ReleaseStringUTFChars(audioPath, audio_path);
+    TranscribeResult draft;
+    if (!read || !engine_transcribe_draft(*audio, draft_options, draft)) {
         env->ReleaseStringUTFChars(language, lang);
         return env->NewStringUTF("");
     }
 
-    LOGI("Audio loaded: %zu samples, %d Hz", pcm_data.size(), sample_rate);
+    tokenize_prompt_context();
+    TranscribeOptions options;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        options = session_options(lang, translate);
+        options.profile = decode_profile_from_int(profile);
+    }
+    env->ReleaseStringUTFChars(language, lang);
 
-    // Set up whisper parameters
-    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    params.print_progress = false;
-    params.print_special = false;
-    params.print_realtime = false;
-    params.print_timestamps = false;
-    params.translate = translate;
-    params.n_threads = 4; // Use 4 threads for mobile
-    params.offset_ms = 0;
-    params.no_context = true;
-    params.single_segment = false;
+    // Replaces (and first cancels) the previous refinement
+    const uint64_t id = g_refinement.start(std::move(audio), options);
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        g_last_segments = draft.segments;
+        g_last_confidence = draft.confidence;
+        g_refinement_options = options;
+        g_refinement_id = id;
+    }
+    return env->NewStringUTF(draft.text.c_str());
+}
 
-    // Set language if provided
-    if (strlen(lang) > 0 && strcmp(lang, "auto") != 0) {
-        params.language = lang;
-    } else {
-        params.language = "auto";
+/**
+ * Wait up to timeoutMs for the refinement started by the last nativeTranscribeDraft
+ * Returns the main model's text (and makes it the last transcription), or null when the
+ * refinement failed, was cancelled or is still running (it is cancelled then)
+ */
+JNIEXPORT jstring JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeAwaitRefinement(
+    JNIEnv* env,
+    jobject thiz,
+    jlong timeoutMs
+) {
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        id = g_refinement_id;
+    }
+    TranscribeResult result;
+    const RefinementJob::Status status = g_refinement.wait(id, timeoutMs, result);
+    if (status == RefinementJob::Status::Running) {
+        LOGW("Refinement still running after %lld ms, cancelling", static_cast<long long>(timeoutMs));
+        g_refinement.cancel();
+        return nullptr;
+    }
+    if (status != RefinementJob::Status::Done) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    if (id != g_refinement_id) {
+        return nullptr;  // A newer draft owns the session state
+    }
+    record_result(g_refinement_options, true, result);
+    return env->NewStringUTF(result.text.c_str());
+}
+
+/**
+ * Abort the running refinement, e.g. when a new recording starts
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeCancelRefinement(
+    JNIEnv* env,
+    jobject thiz
+) {
+    g_refinement.cancel();
+}
+
+/**
+ * Set the text before the cursor in the focused field, used as leading prompt context
+ * Pass an empty string for password fields or when the text is unavailable
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetFieldContext(
+    JNIEnv* env,
+    jobject thiz,
+    jstring text
+) {
+    const char* chars = env->GetStringUTFChars(text, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(g_session_mutex);
+        g_prompt_cache.set_field_context(chars);
     }
+    env->ReleaseStringUTFChars(text, chars);
+}
+
+/**
+ * Constrain subsequent transcriptions to a GBNF grammar whose start rule is "root"
+ * An empty string returns to free text. Each distinct grammar is compiled once per session.
+ * Returns false (and leaves decoding unconstrained) when the grammar does not parse.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetGrammar(
+    JNIEnv* env,
+    jobject thiz,
+    jstring gbnf
+) {
+    const char* chars = env->GetStringUTFChars(gbnf, nullptr);
+    const std::string text = chars;
+    env->ReleaseStringUTFChars(gbnf, chars);
+
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_grammar = text.empty() ? nullptr : g_grammar_cache.get(text);
+    return text.empty() || g_grammar ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Set the kind of field being dictated into (InputFieldType: 0 text, 1 number, 2 phone,
+ * 3 email, 4 URL); non-text fields decode under that field's grammar and token suppression
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetInputFieldType(
+    JNIEnv* env,
+    jobject thiz,
+    jint type
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_field_type = input_field_type_from_int(type);
+    const InputFieldConstraints& field = input_field_constraints(g_field_type);
+    g_field_grammar = field.grammar != nullptr ? g_grammar_cache.get(field.grammar) : nullptr;
+}
+
+/**
+ * Forget the field context and previous transcriptions
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeResetPromptContext(
+    JNIEnv* env,
+    jobject thiz
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_prompt_cache.clear();
+}
+
+/**
+ * Configure language detection for "auto" transcriptions
+ * candidates restricts detection to these ISO-639-1 codes (empty = all languages); once a
+ * detection reaches threshold its language is reused for the rest of the session.
+ * Changing the candidates or the threshold starts a new session.
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetLanguageDetection(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enabled,
+    jobjectArray candidates,
+    jfloat threshold
+) {
+    std::vector<std::string> codes = to_strings(env, candidates);
+
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    if (g_detect_options.enabled != static_cast<bool>(enabled) || g_detect_options.candidates != codes ||
+        g_language_threshold != threshold) {
+        g_session_language.clear();
+    }
+    g_detect_options.enabled = enabled;
+    g_detect_options.candidates = std::move(codes);
+    g_language_threshold = threshold;
+}
 
-    // Run inference
-    LOGI("Starting transcription...");
-    int result = whisper_full(g_context, params, pcm_data.data(), pcm_data.size());
+/**
+ * Identify the language of a WAV file without transcribing it
+ * Returns up to probsOut.length language codes, most likely first; probsOut receives their
+ * probabilities renormalized over candidates (empty = all languages)
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeDetectLanguage(
+    JNIEnv* env,
+    jobject thiz,
+    jstring audioPath,
+    jobjectArray candidates,
+    jfloatArray probsOut
+) {
+    LanguageDetectOptions options;
+    options.enabled = true;
+    options.top_k = probsOut != nullptr ? env->GetArrayLength(probsOut) : 1;
+    options.candidates = to_strings(env, candidates);
 
+    const char* audio_path = env->GetStringUTFChars(audioPath, nullptr);
+    std::vector<LanguageProb> languages;
+    if (!engine_detect_language_file(audio_path, options, TranscribeOptions().n_threads, languages)) {
+        languages.clear();
+    }
     env->ReleaseStringUTFChars(audioPath, audio_path);
-    env->ReleaseStringUTFChars(language, lang);
 
-    if (result != 0) {
-        LOGE("Transcription failed with code: %d", result);
-        return env->NewStringUTF("");
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray codes = env->NewObjectArray(static_cast<jsize>(languages.size()), string_class, nullptr);
+    std::vector<jfloat> probs(languages.size());
+    for (size_t i = 0; i < languages.size(); i++) {
+        jstring code = env->NewStringUTF(languages[i].language.c_str());
+        env->SetObjectArrayElement(codes, static_cast<jsize>(i), code);
+        env->DeleteLocalRef(code);
+        probs[i] = languages[i].prob;
+    }
+    if (probsOut != nullptr && !probs.empty()) {
+        env->SetFloatArrayRegion(probsOut, 0, static_cast<jsize>(probs.size()), probs.data());
+    }
+    return codes;
+}
+
+/**
+ * Describe cache effectiveness, e.g. "results 3/10 hits (30%), 12 stored; encoder 1/4 hits"
+ */
+JNIEXPORT jstring JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetCacheStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    const EngineCacheStats stats = engine_cache_stats();
+    const uint64_t lookups = stats.result_hits + stats.result_misses;
+    char buf[160];
+    snprintf(buf, sizeof(buf), "results %llu/%llu hits (%.0f%%), %zu stored; encoder %llu/%llu hits",
+             static_cast<unsigned long long>(stats.result_hits), static_cast<unsigned long long>(lookups),
+             lookups > 0 ? 100.0 * stats.result_hits / lookups : 0.0, stats.result_entries,
+             static_cast<unsigned long long>(stats.encoder_hits),
+             static_cast<unsigned long long>(stats.encoder_hits + stats.encoder_misses));
+    return env->NewStringUTF(buf);
+}
+
+/**
+ * Configure voice activity detection for subsequent transcriptions
+ * Only speech intervals (plus paddingMs on each side) are sent to whisper
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetVadOptions(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enabled,
+    jint paddingMs,
+    jint minSilenceMs
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_vad_options.enabled = enabled;
+    g_vad_options.padding_ms = paddingMs;
+    g_vad_options.min_silence_ms = minSilenceMs;
+    LOGI("VAD %s (padding %d ms, min silence %d ms)", enabled ? "enabled" : "disabled", paddingMs, minSilenceMs);
+}
+
+/**
+ * Speed up speech by factor (1.0-1.5, 1.0 = off) before it reaches whisper
+ * Segment timestamps are still reported on the original recording timeline
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeSetTimeCompression(
+    JNIEnv* env,
+    jobject thiz,
+    jfloat factor
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_stretch_options.factor = factor;
+    LOGI("Time compression x%.2f", factor);
+}
+
+/**
+ * Segment timestamps of the last transcription on the original recording timeline
+ * Returns [t0_ms, t1_ms, t0_ms, t1_ms, ...]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetLastSegmentTimes(
+    JNIEnv* env,
+    jobject thiz
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    std::vector<jlong> times;
+    times.reserve(g_last_segments.size() * 2);
+    for (const TranscribeSegment& segment : g_last_segments) {
+        times.push_back(segment.t0_ms);
+        times.push_back(segment.t1_ms);
     }
+    jlongArray array = env->NewLongArray(static_cast<jsize>(times.size()));
+    env->SetLongArrayRegion(array, 0, static_cast<jsize>(times.size()), times.data());
+    return array;
+}
 
-    // Extract text from segments
-    std::string transcription;
-    const int n_segments = whisper_full_n_segments(g_context);
-    LOGI("Transcription complete: %d segments", n_segments);
+/**
+ * Confidence of the last transcription
+ * Returns [avg_logprob, no_speech_prob, compression_ratio, n_tokens]
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetLastConfidence(
+    JNIEnv* env,
+    jobject thiz
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    const jfloat values[] = {
+        g_last_confidence.avg_logprob,
+        g_last_confidence.no_speech_prob,
+        g_last_confidence.compression_ratio,
+        static_cast<jfloat>(g_last_confidence.n_tokens),
+    };
+    jfloatArray array = env->NewFloatArray(4);
+    env->SetFloatArrayRegion(array, 0, 4, values);
+    return array;
+}
 
-    for (int i = 0; i < n_segments; i++) {
-        const char* text = whisper_full_get_segment_text(g_context, i);
-        transcription += text;
+/**
+ * Per-segment confidence of the last transcription, parallel to nativeGetLastSegmentTimes
+ * Returns [avg_logprob, no_speech_prob, compression_ratio, avg_logprob, ...]
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetLastSegmentConfidence(
+    JNIEnv* env,
+    jobject thiz
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    std::vector<jfloat> values;
+    values.reserve(g_last_segments.size() * 3);
+    for (const TranscribeSegment& segment : g_last_segments) {
+        values.push_back(segment.avg_logprob);
+        values.push_back(segment.no_speech_prob);
+        values.push_back(segment.compression_ratio);
     }
+    jfloatArray array = env->NewFloatArray(static_cast<jsize>(values.size()));
+    env->SetFloatArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return array;
+}
 
-    LOGI("Final transcription: %zu chars", transcription.length());
-    return env->NewStringUTF(transcription.c_str());
+/**
+ * Segment texts of the last transcription, parallel to nativeGetLastSegmentTimes
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeGetLastSegmentTexts(
+    JNIEnv* env,
+    jobject thiz
+) {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray array = env->NewObjectArray(static_cast<jsize>(g_last_segments.size()), string_class, nullptr);
+    for (size_t i = 0; i < g_last_segments.size(); i++) {
+        jstring text = env->NewStringUTF(g_last_segments[i].text.c_str());
+        env->SetObjectArrayElement(array, static_cast<jsize>(i), text);
+        env->DeleteLocalRef(text);
+    }
+    return array;
 }
 
 /**
@@ -134,11 +770,8 @@ Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeUnloadModel(
     JNIEnv* env,
     jobject thiz
 ) {
-    if (g_context != nullptr) {
-        LOGI("Unloading model");
-        whisper_free(g_context);
-        g_context = nullptr;
-    }
+    g_refinement.cancel();
+    engine_unload_model();
 }
 
 /**
@@ -149,7 +782,134 @@ Java_com_hyperwhisper_native_1whisper_WhisperContext_nativeIsModelLoaded(
     JNIEnv* env,
     jobject thiz
 ) {
-    return g_context != nullptr ? JNI_TRUE : JNI_FALSE;
+    return engine_is_model_loaded() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Create a streaming endpoint detector for one recording session
+ * Returns an opaque handle that must be released with nativeFree
+ */
+JNIEXPORT jlong JNICALL
+Java_com_hyperwhisper_native_1whisper_EndpointDetector_nativeCreate(
+    JNIEnv* env,
+    jclass clazz,
+    jint sampleRate,
+    jint hangoverMs,
+    jint minSpeechMs
+) {
+    EndpointOptions options;
+    options.sample_rate = sampleRate;
+    options.hangover_ms = hangoverMs;
+    options.min_speech_ms = minSpeechMs;
+    return reinterpret_cast<jlong>(new EndpointDetector(options));
+}
+
+/**
+ * Feed captured PCM16 samples; returns 0 (waiting), 1 (speech) or 2 (end of utterance)
+ */
+JNIEXPORT jint JNICALL
+Java_com_hyperwhisper_native_1whisper_EndpointDetector_nativeProcess(
+    JNIEnv* env,
+    jclass clazz,
+    jlong handle,
+    jshortArray samples,
+    jint count
+) {
+    auto* detector = reinterpret_cast<EndpointDetector*>(handle);
+    if (detector == nullptr || count <= 0) {
+        return detector != nullptr ? static_cast<jint>(detector->state()) : 0;
+    }
+    jshort* pcm = static_cast<jshort*>(env->GetPrimitiveArrayCritical(samples, nullptr));
+    if (pcm == nullptr) {
+        return static_cast<jint>(detector->state());
+    }
+    const EndpointState state = detector->process(reinterpret_cast<const int16_t*>(pcm), static_cast<size_t>(count));
+    env->ReleasePrimitiveArrayCritical(samples, pcm, JNI_ABORT);
+    return static_cast<jint>(state);
+}
+
+/**
+ * Release a detector created by nativeCreate
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_EndpointDetector_nativeFree(
+    JNIEnv* env,
+    jclass clazz,
+    jlong handle
+) {
+    delete reinterpret_cast<EndpointDetector*>(handle);
+}
+
+/**
+ * Create an incremental log-mel front-end for one recording session
+ * Returns an opaque handle that must be released with nativeFree
+ */
+JNIEXPORT jlong JNICALL
+Java_com_hyperwhisper_native_1whisper_IncrementalMel_nativeCreate(
+    JNIEnv* env,
+    jclass clazz,
+    jint nMels
+) {
+    return reinterpret_cast<jlong>(new IncrementalMel(nMels));
+}
+
+/**
+ * Feed captured 16 kHz PCM16 samples
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_IncrementalMel_nativePush(
+    JNIEnv* env,
+    jclass clazz,
+    jlong handle,
+    jshortArray samples,
+    jint count
+) {
+    auto* mel = reinterpret_cast<IncrementalMel*>(handle);
+    if (mel == nullptr || count <= 0) {
+        return;
+    }
+    jshort* pcm = static_cast<jshort*>(env->GetPrimitiveArrayCritical(samples, nullptr));
+    if (pcm == nullptr) {
+        return;
+    }
+    mel->push(reinterpret_cast<const int16_t*>(pcm), static_cast<size_t>(count));
+    env->ReleasePrimitiveArrayCritical(samples, pcm, JNI_ABORT);
+}
+
+/**
+ * Finish the recording and hand the mel to the next nativeTranscribe of audioPath
+ * Takes ownership of the handle; the Kotlin side must not free it afterwards
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_IncrementalMel_nativeFinish(
+    JNIEnv* env,
+    jclass clazz,
+    jlong handle,
+    jstring audioPath
+) {
+    std::unique_ptr<IncrementalMel> mel(reinterpret_cast<IncrementalMel*>(handle));
+    if (!mel) {
+        return;
+    }
+    mel->finish();
+
+    const char* audio_path = env->GetStringUTFChars(audioPath, nullptr);
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    g_pending_mel = std::move(mel);
+    g_pending_mel_path = audio_path;
+    env->ReleaseStringUTFChars(audioPath, audio_path);
+}
+
+/**
+ * Release a front-end created by nativeCreate that was not finished
+ */
+JNIEXPORT void JNICALL
+Java_com_hyperwhisper_native_1whisper_IncrementalMel_nativeFree(
+    JNIEnv* env,
+    jclass clazz,
+    jlong handle
+) {
+    delete reinterpret_cast<IncrementalMel*>(handle);
 }
 
 } // extern "C"
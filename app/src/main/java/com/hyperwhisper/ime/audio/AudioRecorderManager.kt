@@ -1,23 +1,38 @@
 package com.hyperwhisper.audio
 
+import android.annotation.SuppressLint
 import android.content.Context
+import android.media.AudioFormat
+import android.media.AudioRecord
 import android.media.MediaRecorder
 import android.os.Build
 import android.os.PowerManager
 import android.util.Base64
 import android.util.Log
+import com.hyperwhisper.data.RecordingSettings
+import com.hyperwhisper.native_whisper.EndpointDetector
+import com.hyperwhisper.native_whisper.IncrementalMel
+import com.hyperwhisper.native_whisper.WhisperContext
 import com.hyperwhisper.utils.TraceLogger
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
 import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.SharedFlow
 import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asSharedFlow
 import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import java.io.BufferedOutputStream
 import java.io.File
+import java.io.FileOutputStream
 import java.io.IOException
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -25,29 +40,68 @@ import javax.inject.Singleton
 class AudioRecorderManager @Inject constructor(
     private val context: Context
 ) {
+    private var audioRecord: AudioRecord? = null
     private var mediaRecorder: MediaRecorder? = null
     private var currentAudioFile: File? = null
-    private var isRecording = false
+    @Volatile private var isRecording = false
     private var recordingStartTime: Long = 0
     private var timerJob: Job? = null
+    private var captureJob: Job? = null
+    private var endpointDetector: EndpointDetector? = null
+    private var incrementalMel: IncrementalMel? = null
     private var wakeLock: PowerManager.WakeLock? = null
 
     private val _recordingDuration = MutableStateFlow(0L)
     val recordingDuration: StateFlow<Long> = _recordingDuration.asStateFlow()
 
+    // Emits once per recording when speech is followed by the configured trailing silence
+    private val _endOfSpeech = MutableSharedFlow<Unit>(extraBufferCapacity = 1)
+    val endOfSpeech: SharedFlow<Unit> = _endOfSpeech.asSharedFlow()
+
+    // Emits the AudioRecord error code when capture gives up on a read error that won't clear
+    private val _captureFailed = MutableSharedFlow<Int>(extraBufferCapacity = 1)
+    val captureFailed: SharedFlow<Int> = _captureFailed.asSharedFlow()
+
     private val scope = CoroutineScope(Dispatchers.Default)
 
     companion object {
         private const val TAG = "AudioRecorderManager"
         private const val SAMPLE_RATE = 16000
-        private const val BIT_RATE = 128000
+        private const val BIT_RATE = 128000 // AAC recordings
+        private const val BYTES_PER_SECOND = SAMPLE_RATE * 2 // Mono PCM16
+        private const val WAV_HEADER_SIZE = 44
+        private const val FRAME_SAMPLES = SAMPLE_RATE / 10 // 100 ms per read
+        private const val READ_RETRY_MS = 50L
+        private const val MAX_READ_FAILURES = 20 // ~1 s of failed reads in a row
         const val MAX_RECORDING_DURATION_MS = 180000L // 3 minutes
+
+        /**
+         * Audio duration in seconds: exact for our PCM WAV recordings,
+         * approximate for compressed files (m4a at 128kbps: ~16KB per second)
+         */
+        fun audioDurationSeconds(audioFile: File): Double {
+            return if (audioFile.extension.lowercase() == "wav") {
+                (audioFile.length() - WAV_HEADER_SIZE).coerceAtLeast(0) / BYTES_PER_SECOND.toDouble()
+            } else {
+                audioFile.length() / 16000.0
+            }
+        }
     }
 
     /**
      * Start recording audio
+     * With the native library, captures 16kHz mono PCM into a WAV file so the stream can be
+     * inspected live (end-of-speech detection) and fed to whisper.cpp without conversion.
+     * Builds without it have nothing to inspect the stream with and record compact AAC (m4a)
+     * for upload instead; they record until stopped.
+     * @param melBins Mel bins of the on-device model to compute whisper's log-mel for during
+     *   capture, or null to skip it (cloud transcription)
      */
-    suspend fun startRecording(): Result<Unit> = withContext(Dispatchers.IO) {
+    @SuppressLint("MissingPermission") // RECORD_AUDIO is checked by the caller before recording starts
+    suspend fun startRecording(
+        settings: RecordingSettings = RecordingSettings(),
+        melBins: Int? = null
+    ): Result<Unit> = withContext(Dispatchers.IO) {
         try {
             if (isRecording) {
                 TraceLogger.trace("AudioRecorder", "Already recording - ignoring start request")
@@ -55,11 +109,12 @@ class AudioRecorderManager @Inject constructor(
             }
 
             TraceLogger.trace("AudioRecorder", "Starting audio recording session")
+            val capturePcm = WhisperContext.isLibraryAvailable()
 
             // Create temp file
             val audioFile = File.createTempFile(
                 "audio_${System.currentTimeMillis()}",
-                ".m4a",
+                if (capturePcm) ".wav" else ".m4a",
                 context.cacheDir
             )
             currentAudioFile = audioFile
@@ -75,32 +130,52 @@ class AudioRecorderManager @Inject constructor(
 
             var lastException: Exception? = null
 
+            val minBufferSize = AudioRecord.getMinBufferSize(
+                SAMPLE_RATE,
+                AudioFormat.CHANNEL_IN_MONO,
+                AudioFormat.ENCODING_PCM_16BIT
+            )
+            val bufferSize = maxOf(minBufferSize, FRAME_SAMPLES * 2 * 4)
+
             for ((audioSource, sourceName) in audioSources) {
                 try {
                     TraceLogger.trace("AudioRecorder", "Trying audio source: $sourceName")
 
-                    // Initialize MediaRecorder
-                    mediaRecorder = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S) {
-                        MediaRecorder(context)
+                    if (capturePcm) {
+                        val recorder = AudioRecord(
+                            audioSource,
+                            SAMPLE_RATE,
+                            AudioFormat.CHANNEL_IN_MONO,
+                            AudioFormat.ENCODING_PCM_16BIT,
+                            bufferSize
+                        )
+                        audioRecord = recorder
+                        if (recorder.state != AudioRecord.STATE_INITIALIZED) {
+                            throw IllegalStateException("AudioRecord failed to initialize")
+                        }
+                        recorder.startRecording()
+                        if (recorder.recordingState != AudioRecord.RECORDSTATE_RECORDING) {
+                            throw IllegalStateException("AudioRecord failed to start")
+                        }
                     } else {
-                        @Suppress("DEPRECATION")
-                        MediaRecorder()
-                    }.apply {
-                        setAudioSource(audioSource)
-                        setOutputFormat(MediaRecorder.OutputFormat.MPEG_4)
-                        setAudioEncoder(MediaRecorder.AudioEncoder.AAC)
-                        setAudioSamplingRate(SAMPLE_RATE)
-                        setAudioEncodingBitRate(BIT_RATE)
-                        setOutputFile(audioFile.absolutePath)
-
-                        prepare()
-                        start()
+                        mediaRecorder = startAacRecorder(audioSource, audioFile)
                     }
 
                     isRecording = true
                     recordingStartTime = System.currentTimeMillis()
                     _recordingDuration.value = 0L
 
+                    audioRecord?.let { recorder ->
+                        endpointDetector = if (settings.autoStopOnSilence) {
+                            EndpointDetector.create(SAMPLE_RATE, settings.silenceHangoverMs.toInt())
+                        } else {
+                            null
+                        }
+                        incrementalMel = melBins?.let { IncrementalMel.create(it) }
+
+                        startCapture(recorder, audioFile)
+                    }
+
                     // Acquire wake lock to keep recording during screen lock
                     acquireWakeLock()
 
@@ -115,6 +190,8 @@ class AudioRecorderManager @Inject constructor(
                     Log.w(TAG, "Failed to start recording with $sourceName: ${e.message}")
                     TraceLogger.trace("AudioRecorder", "Failed with $sourceName: ${e.message}")
                     lastException = e
+                    audioRecord?.release()
+                    audioRecord = null
                     mediaRecorder?.release()
                     mediaRecorder = null
                     // Continue to next audio source
@@ -149,22 +226,14 @@ class AudioRecorderManager @Inject constructor(
                 return@withContext Result.failure(IllegalStateException("Not recording"))
             }
 
-            mediaRecorder?.apply {
-                try {
-                    stop()
-                    release()
-                } catch (e: RuntimeException) {
-                    Log.e(TAG, "Error stopping recording", e)
-                }
-            }
-            mediaRecorder = null
-            isRecording = false
+            val minBytes = if (mediaRecorder != null) 0 else WAV_HEADER_SIZE
+            stopCapture()
 
             stopTimer()
             releaseWakeLock()
 
             val file = currentAudioFile
-            if (file != null && file.exists() && file.length() > 0) {
+            if (file != null && file.exists() && file.length() > minBytes) {
                 Log.d(TAG, "Recording stopped: ${file.absolutePath}, size: ${file.length()} bytes")
                 Result.success(file)
             } else {
@@ -183,16 +252,7 @@ class AudioRecorderManager @Inject constructor(
     suspend fun cancelRecording() = withContext(Dispatchers.IO) {
         try {
             if (isRecording) {
-                mediaRecorder?.apply {
-                    try {
-                        stop()
-                    } catch (e: RuntimeException) {
-                        Log.e(TAG, "Error canceling recording", e)
-                    }
-                    release()
-                }
-                mediaRecorder = null
-                isRecording = false
+                stopCapture()
             }
             stopTimer()
             releaseWakeLock()
@@ -202,6 +262,152 @@ class AudioRecorderManager @Inject constructor(
         }
     }
 
+    /**
+     * Start MediaRecorder encoding AAC from audioSource into audioFile
+     */
+    private fun startAacRecorder(audioSource: Int, audioFile: File): MediaRecorder {
+        val recorder = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S) {
+            MediaRecorder(context)
+        } else {
+            @Suppress("DEPRECATION")
+            MediaRecorder()
+        }
+        try {
+            recorder.apply {
+                setAudioSource(audioSource)
+                setOutputFormat(MediaRecorder.OutputFormat.MPEG_4)
+                setAudioEncoder(MediaRecorder.AudioEncoder.AAC)
+                setAudioSamplingRate(SAMPLE_RATE)
+                setAudioEncodingBitRate(BIT_RATE)
+                setOutputFile(audioFile.absolutePath)
+                prepare()
+                start()
+            }
+        } catch (e: Exception) {
+            recorder.release()
+            throw e
+        }
+        return recorder
+    }
+
+    /**
+     * Read PCM frames until stopped: append them to the WAV file and feed the endpoint
+     * detector and the incremental mel
+     */
+    private fun startCapture(recorder: AudioRecord, audioFile: File) {
+        captureJob = scope.launch(Dispatchers.IO) {
+            val buffer = ShortArray(FRAME_SAMPLES)
+            val bytes = ByteBuffer.allocate(FRAME_SAMPLES * 2).order(ByteOrder.LITTLE_ENDIAN)
+            var dataBytes = 0L
+            var endOfSpeechSent = false
+            var readFailures = 0
+
+            try {
+                BufferedOutputStream(FileOutputStream(audioFile)).use { out ->
+                    out.write(wavHeader(0)) // Sizes are patched once recording stops
+                    while (isRecording) {
+                        val read = recorder.read(buffer, 0, buffer.size)
+                        if (read <= 0) {
+                            if (!isRecording) break
+                            readFailures++
+                            if (isFatalReadError(read) || readFailures >= MAX_READ_FAILURES) {
+                                // Keep what was captured so far: the header is still patched below
+                                Log.e(TAG, "AudioRecord read failed ($read), stopping capture")
+                                TraceLogger.error("AudioRecorder", "Read failed ($read) after $readFailures attempts, stopping capture")
+                                _captureFailed.tryEmit(read)
+                                break
+                            }
+                            Log.w(TAG, "AudioRecord read returned $read, retrying")
+                            delay(READ_RETRY_MS)
+                            continue
+                        }
+                        readFailures = 0
+
+                        bytes.clear()
+                        bytes.asShortBuffer().put(buffer, 0, read)
+                        out.write(bytes.array(), 0, read * 2)
+                        dataBytes += read * 2
+
+                        incrementalMel?.push(buffer, read)
+
+                        val state = endpointDetector?.process(buffer, read)
+                        if (state == EndpointDetector.State.END_OF_UTTERANCE && !endOfSpeechSent) {
+                            endOfSpeechSent = true
+                            Log.d(TAG, "End of speech detected at ${dataBytes * 1000 / BYTES_PER_SECOND}ms")
+                            TraceLogger.trace("AudioRecorder", "End of speech detected, requesting auto-stop")
+                            _endOfSpeech.tryEmit(Unit)
+                        }
+                    }
+                }
+                RandomAccessFile(audioFile, "rw").use { it.write(wavHeader(dataBytes)) }
+                incrementalMel?.finish(audioFile)
+            } catch (e: IOException) {
+                Log.e(TAG, "Error writing audio data", e)
+                TraceLogger.error("AudioRecorder", "Error writing audio data", e)
+            }
+        }
+    }
+
+    /**
+     * Read errors that mean the recorder is gone or misconfigured; retrying won't help
+     */
+    private fun isFatalReadError(code: Int): Boolean =
+        code == AudioRecord.ERROR_DEAD_OBJECT ||
+            code == AudioRecord.ERROR_INVALID_OPERATION ||
+            code == AudioRecord.ERROR_BAD_VALUE
+
+    /**
+     * Stop capture, wait for the WAV (or m4a) file to be finalized, and release the recorder
+     */
+    private suspend fun stopCapture() {
+        isRecording = false
+        mediaRecorder?.apply {
+            try {
+                stop()
+            } catch (e: RuntimeException) {
+                Log.e(TAG, "Error stopping recording", e)
+            }
+            release()
+        }
+        mediaRecorder = null
+        audioRecord?.apply {
+            try {
+                stop()
+            } catch (e: IllegalStateException) {
+                Log.e(TAG, "Error stopping recording", e)
+            }
+        }
+        captureJob?.join()
+        captureJob = null
+        audioRecord?.release()
+        audioRecord = null
+        endpointDetector?.close()
+        endpointDetector = null
+        incrementalMel?.close()
+        incrementalMel = null
+    }
+
+    /**
+     * 44-byte RIFF header for 16kHz mono PCM16
+     */
+    private fun wavHeader(dataBytes: Long): ByteArray {
+        return ByteBuffer.allocate(WAV_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN).apply {
+            put("RIFF".toByteArray(Charsets.US_ASCII))
+            putInt((36 + dataBytes).toInt())
+            put("WAVE".toByteArray(Charsets.US_ASCII))
+            put("fmt ".toByteArray(Charsets.US_ASCII))
+            putInt(16)                  // fmt chunk size
+            putShort(1)                 // PCM
+            putShort(1)                 // Mono
+            putInt(SAMPLE_RATE)
+            putInt(BYTES_PER_SECOND)
+            putShort(2)                 // Block align
+            putShort(16)                // Bits per sample
+            put("data".toByteArray(Charsets.US_ASCII))
+            putInt(dataBytes.toInt())
+        }.array()
+    }
+
     /**
      * Start recording duration timer
      */
@@ -313,9 +519,17 @@ class AudioRecorderManager @Inject constructor(
      * Release resources
      */
     fun release() {
+        isRecording = false
+        captureJob?.cancel()
+        captureJob = null
+        audioRecord?.release()
+        audioRecord = null
         mediaRecorder?.release()
         mediaRecorder = null
-        isRecording = false
+        endpointDetector?.close()
+        endpointDetector = null
+        incrementalMel?.close()
+        incrementalMel = null
         cleanup()
     }
 
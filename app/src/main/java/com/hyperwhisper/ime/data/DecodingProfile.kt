@@ -0,0 +1,11 @@
+package com.hyperwhisper.data
+
+/**
+ * On-device decoding strategy, from fastest to most accurate
+ * (order matches the native DecodeProfile)
+ */
+enum class DecodingProfile {
+    FAST,     // One greedy pass per window
+    BALANCED, // Greedy, retried with best-of-5 sampling when a window looks unreliable
+    ACCURATE  // Beam search (5 beams)
+}
@@ -0,0 +1,36 @@
+package com.hyperwhisper.data
+
+import android.text.InputType
+
+/**
+ * Kind of text field being dictated into, as far as transcription cares
+ * On-device decoding constrains non-text fields to their character set
+ * (order matches the native InputFieldType)
+ */
+enum class InputFieldType {
+    TEXT,
+    NUMBER,
+    PHONE,
+    EMAIL,
+    URL;
+
+    companion object {
+        /**
+         * Field type for an EditorInfo.inputType
+         */
+        fun fromInputType(inputType: Int): InputFieldType {
+            val variation = inputType and InputType.TYPE_MASK_VARIATION
+            return when (inputType and InputType.TYPE_MASK_CLASS) {
+                InputType.TYPE_CLASS_NUMBER -> NUMBER
+                InputType.TYPE_CLASS_PHONE -> PHONE
+                InputType.TYPE_CLASS_TEXT -> when (variation) {
+                    InputType.TYPE_TEXT_VARIATION_EMAIL_ADDRESS,
+                    InputType.TYPE_TEXT_VARIATION_WEB_EMAIL_ADDRESS -> EMAIL
+                    InputType.TYPE_TEXT_VARIATION_URI -> URL
+                    else -> TEXT
+                }
+                else -> TEXT
+            }
+        }
+    }
+}
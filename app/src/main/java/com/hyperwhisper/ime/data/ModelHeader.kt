@@ -0,0 +1,52 @@
+package com.hyperwhisper.data
+
+/**
+ * Hyperparameters from the header of a whisper.cpp GGML model file
+ *
+ * Checked before a downloaded or imported file is accepted for a WhisperModel, so a
+ * checkpoint of another architecture (e.g. a full-depth model in the turbo slot) is
+ * rejected up front rather than when the native loader reads it. The header is parsed
+ * natively (WhisperContext.getModelHparams), by the code the loader itself validates with.
+ */
+data class ModelHeader(
+    val nVocab: Int,
+    val nAudioLayer: Int,
+    val nTextLayer: Int,
+    val nMels: Int,
+    val ftype: Int
+) {
+    companion object {
+        private const val HPARAMS_COUNT = 11
+        private const val ENGLISH_ONLY_VOCAB = 51864
+
+        /**
+         * Header from the native hparams array (file order, ftype without the quantization
+         * version), or null if it has an unexpected size
+         */
+        fun fromHparams(fields: IntArray): ModelHeader? {
+            if (fields.size != HPARAMS_COUNT) return null
+            return ModelHeader(
+                nVocab = fields[0],
+                nAudioLayer = fields[4],
+                nTextLayer = fields[8],
+                nMels = fields[9],
+                ftype = fields[10]
+            )
+        }
+    }
+
+    val englishOnly: Boolean get() = nVocab == ENGLISH_ONLY_VOCAB
+
+    /**
+     * Whether this header describes the architecture model expects
+     */
+    fun matches(model: WhisperModel): Boolean =
+        nAudioLayer == model.encoderLayers &&
+            nTextLayer == model.decoderLayers &&
+            nMels == model.melBins &&
+            englishOnly == model.englishOnly
+
+    override fun toString(): String =
+        "$nAudioLayer encoder / $nTextLayer decoder layers, $nMels mels, " +
+            "${if (englishOnly) "English-only" else "multilingual"}, ftype $ftype"
+}
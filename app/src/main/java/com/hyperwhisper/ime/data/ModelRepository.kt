@@ -3,6 +3,7 @@ package com.hyperwhisper.data
 import android.content.Context
 import android.util.Log
 import com.hyperwhisper.di.ModelDownloadClient
+import com.hyperwhisper.native_whisper.WhisperContext
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.MutableStateFlow
@@ -23,11 +24,13 @@ import javax.inject.Singleton
 @Singleton
 class ModelRepository @Inject constructor(
     @ApplicationContext private val context: Context,
-    @ModelDownloadClient private val okHttpClient: OkHttpClient
+    @ModelDownloadClient private val okHttpClient: OkHttpClient,
+    private val whisperContext: WhisperContext
 ) {
     companion object {
         private const val TAG = "ModelRepository"
         private const val MODELS_DIR = "whisper_models"
+        private const val NATIVE_CACHE_DIR = "whisper_cache"
     }
 
     // Use external files dir which persists across app updates
@@ -120,6 +123,14 @@ class ModelRepository @Inject constructor(
         return File(modelsDir, model.fileName)
     }
 
+    /**
+     * Get directory the native result cache persists to
+     * Lives in internal cache storage so the system can reclaim it under pressure
+     */
+    fun getNativeCacheDir(): File {
+        return File(context.cacheDir, NATIVE_CACHE_DIR).apply { mkdirs() }
+    }
+
     /**
      * Check if model is downloaded and valid
      */
@@ -138,6 +149,11 @@ class ModelRepository @Inject constructor(
      * Download model from URL with progress tracking
      */
     suspend fun downloadModel(model: WhisperModel): Result<File> = withContext(Dispatchers.IO) {
+        // Quantized variants of a model already on the device are built locally
+        model.packSource?.takeIf { isModelDownloaded(it) }?.let { source ->
+            packFromSource(model, source)?.let { return@withContext it }
+        }
+
         return@withContext try {
             Log.d(TAG, "=== DOWNLOAD START ===")
             Log.d(TAG, "Model: ${model.displayName}")
@@ -343,6 +359,13 @@ class ModelRepository @Inject constructor(
                 Log.w(TAG, "File size differs by ${if (variance > 0) "+" else ""}${variance}% but within acceptable range (±50%)")
             }
 
+            checkModelHeader(model, tempFile)?.let { error ->
+                Log.e(TAG, error)
+                tempFile.delete()
+                updateModelState(model, ModelDownloadState.Error(error))
+                return@withContext Result.failure(Exception(error))
+            }
+
             // Move temp file to final location
             Log.d(TAG, "=== FINALIZING ===")
             if (modelFile.exists()) {
@@ -390,6 +413,51 @@ class ModelRepository @Inject constructor(
         }
     }
 
+    /**
+     * Build model by packing its downloaded source model on device
+     * @return Result, or null when packing isn't possible here and the model should be downloaded
+     */
+    private fun packFromSource(model: WhisperModel, source: WhisperModel): Result<File>? {
+        val type = model.packType ?: return null
+        val modelFile = getModelFile(model)
+        val tempFile = File(modelsDir, "${model.fileName}.tmp")
+        if (tempFile.exists()) {
+            tempFile.delete()
+        }
+
+        Log.d(TAG, "=== PACK START ===")
+        Log.d(TAG, "Model: ${model.displayName} from ${source.displayName} ($type)")
+        updateModelState(model, ModelDownloadState.Downloading(0f))
+
+        val packed = whisperContext.packModel(getModelFile(source), tempFile, type)
+        if (packed.isFailure) {
+            Log.w(TAG, "On-device packing unavailable, downloading instead: ${packed.exceptionOrNull()?.message}")
+            tempFile.delete()
+            return null
+        }
+
+        checkModelHeader(model, tempFile)?.let { error ->
+            Log.e(TAG, error)
+            tempFile.delete()
+            updateModelState(model, ModelDownloadState.Error(error))
+            return Result.failure(Exception(error))
+        }
+
+        if (modelFile.exists()) {
+            modelFile.delete()
+        }
+        if (!tempFile.renameTo(modelFile)) {
+            val error = "Failed to rename temp file to final location"
+            Log.e(TAG, error)
+            updateModelState(model, ModelDownloadState.Error(error))
+            return Result.failure(Exception(error))
+        }
+
+        updateModelState(model, ModelDownloadState.Downloaded)
+        Log.d(TAG, "=== PACK COMPLETE === ${modelFile.length() / (1024 * 1024)}MB")
+        return Result.success(modelFile)
+    }
+
     /**
      * Delete downloaded model
      */
@@ -533,6 +601,13 @@ class ModelRepository @Inject constructor(
                 Log.w(TAG, "File size differs by ${if (variance > 0) "+" else ""}${variance}% but within acceptable range (±50%)")
             }
 
+            checkModelHeader(model, tempFile)?.let { error ->
+                Log.e(TAG, error)
+                tempFile.delete()
+                updateModelState(model, ModelDownloadState.Error(error))
+                return@withContext Result.failure(Exception(error))
+            }
+
             // Move to final location
             if (modelFile.exists()) {
                 modelFile.delete()
@@ -550,6 +625,23 @@ class ModelRepository @Inject constructor(
         }
     }
 
+    /**
+     * Check the GGML header of file describes model's architecture
+     * (layer counts, mel bins, vocabulary), so distilled and turbo slots only accept their own checkpoints
+     * @return Error message, or null if the header matches
+     */
+    private fun checkModelHeader(model: WhisperModel, file: File): String? {
+        // Without the native library the file can't be loaded either; nothing to check against
+        if (!WhisperContext.isLibraryAvailable()) return null
+        val header = WhisperContext.getModelHparams(file) ?: return "Not a whisper.cpp GGML model file"
+        if (!header.matches(model)) {
+            return "File is not ${model.displayName}: $header " +
+                "(expected ${model.encoderLayers} encoder / ${model.decoderLayers} decoder layers, ${model.melBins} mels)"
+        }
+        Log.d(TAG, "Model header: $header")
+        return null
+    }
+
     /**
      * Update individual model state
      */
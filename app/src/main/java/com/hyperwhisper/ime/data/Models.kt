@@ -120,7 +120,13 @@ data class LocalSettings(
     val selectedModel: WhisperModel = WhisperModel.BASE,
     val enableSecondStageProcessing: Boolean = false,
     val secondStageProvider: ApiProvider = ApiProvider.OPENAI,
-    val secondStageModel: String = "gpt-4o-mini"
+    val secondStageModel: String = "gpt-4o-mini",
+    val speechSpeedup: Float = 1.0f, // WSOLA time compression before whisper (1.0-1.5, 1.0 = off)
+    val languageCandidates: List<String> = emptyList(), // ISO-639-1 codes auto-detect chooses from (empty = all)
+    val cloudEscalation: Boolean = false, // Re-transcribe low-confidence local results with the second-stage provider (OpenAI/Groq)
+    val draftCascade: Boolean = true, // Long dictations: instant Tiny draft, replaced by the selected model's text
+    val decodingProfile: DecodingProfile = DecodingProfile.BALANCED,
+    val latencyBudgetMs: Int = 0 // Per-utterance decoding budget; cheaper profile or partial text past it (0 = none)
 )
 
 data class ApiSettings(
@@ -303,9 +309,44 @@ data class ProcessingInfo(
     val systemPrompt: String, // System prompt that was used
     val audioDurationSeconds: Double = 0.0, // Audio duration in seconds
     val transcriptionTokens: TokenUsage? = null, // Tokens used for transcription
-    val postProcessingTokens: TokenUsage? = null // Tokens used for post-processing (if applicable)
+    val postProcessingTokens: TokenUsage? = null, // Tokens used for post-processing (if applicable)
+    val confidence: TranscriptionConfidence? = null, // On-device transcription quality (null for cloud results)
+    val refinementPending: Boolean = false // Text is an on-device draft; a TextRefinement may replace it
 )
 
+/**
+ * Selected model's transcript for text already committed from a draft model
+ * Only applied while the field still ends with the draft, i.e. the user hasn't edited it
+ */
+data class TextRefinement(
+    val draft: String,
+    val refined: String,
+    val confidence: TranscriptionConfidence? = null // Of the refined text
+)
+
+/**
+ * Quality signals of an on-device transcription, as whisper's own fallback uses them
+ */
+data class TranscriptionConfidence(
+    val avgLogprob: Float, // Mean token log-probability; whisper retries below -1.0
+    val noSpeechProb: Float, // Probability the audio holds no speech
+    val compressionRatio: Float // Text size / zlib size; above 2.4 the text is likely a repetition loop
+) {
+    companion object {
+        const val LOGPROB_THRESHOLD = -1.0f
+        const val COMPRESSION_RATIO_THRESHOLD = 2.4f
+        const val NO_SPEECH_THRESHOLD = 0.6f
+    }
+
+    /**
+     * Likely misrecognized or hallucinated; silence (high no-speech) is not counted as low confidence
+     */
+    fun isLow(): Boolean {
+        if (noSpeechProb > NO_SPEECH_THRESHOLD && avgLogprob < LOGPROB_THRESHOLD) return false
+        return avgLogprob < LOGPROB_THRESHOLD || compressionRatio > COMPRESSION_RATIO_THRESHOLD
+    }
+}
+
 /**
  * Result wrapper for API calls
  */
@@ -397,7 +438,9 @@ data class TranscriptionHistoryItem(
  */
 data class RecordingSettings(
     val maxRecordingDuration: Long = 180000L, // 3 minutes in milliseconds
-    val warnAtSecondsRemaining: Int = 30
+    val warnAtSecondsRemaining: Int = 30,
+    val autoStopOnSilence: Boolean = true, // Stop once speech is followed by trailing silence (local build)
+    val silenceHangoverMs: Long = 1500L // Trailing silence that ends the utterance
 )
 
 /**
@@ -525,7 +568,13 @@ enum class WhisperModel(
     val fileSize: Long, // Bytes
     val fileName: String,
     val downloadUrl: String,
-    val isRecommended: Boolean = false
+    val encoderLayers: Int,
+    val decoderLayers: Int, // Fewer than encoderLayers for distilled / turbo checkpoints
+    val melBins: Int = 80,
+    val isRecommended: Boolean = false,
+    val englishOnly: Boolean = false, // *.en checkpoints: English only, no language detection
+    val packSource: WhisperModel? = null, // Built on device from this model when it is downloaded
+    val packType: String? = null // Weight tensor type of the on-device pack
 ) {
     TINY(
         modelName = "tiny",
@@ -534,6 +583,8 @@ enum class WhisperModel(
         fileName = "ggml-tiny.bin",
         // Using direct CDN link with proper redirect handling
         downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-tiny.bin",
+        encoderLayers = 4,
+        decoderLayers = 4,
         isRecommended = true
     ),
     BASE(
@@ -542,6 +593,8 @@ enum class WhisperModel(
         fileSize = 142L * 1024 * 1024, // ~142 MB
         fileName = "ggml-base.bin",
         downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-base.bin",
+        encoderLayers = 6,
+        decoderLayers = 6,
         isRecommended = true
     ),
     SMALL(
@@ -549,13 +602,84 @@ enum class WhisperModel(
         displayName = "Small (Accurate)",
         fileSize = 466L * 1024 * 1024, // ~466 MB
         fileName = "ggml-small.bin",
-        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-small.bin"
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-small.bin",
+        encoderLayers = 12,
+        decoderLayers = 12
+    ),
+    TINY_EN(
+        modelName = "tiny.en",
+        displayName = "Tiny English (Fast)",
+        fileSize = 75L * 1024 * 1024, // ~75 MB
+        fileName = "ggml-tiny.en.bin",
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-tiny.en.bin",
+        encoderLayers = 4,
+        decoderLayers = 4,
+        englishOnly = true
+    ),
+    BASE_EN(
+        modelName = "base.en",
+        displayName = "Base English (Balanced)",
+        fileSize = 142L * 1024 * 1024, // ~142 MB
+        fileName = "ggml-base.en.bin",
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-base.en.bin",
+        encoderLayers = 6,
+        decoderLayers = 6,
+        englishOnly = true
+    ),
+    SMALL_EN(
+        modelName = "small.en",
+        displayName = "Small English (Accurate)",
+        fileSize = 466L * 1024 * 1024, // ~466 MB
+        fileName = "ggml-small.en.bin",
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-small.en.bin",
+        encoderLayers = 12,
+        decoderLayers = 12,
+        englishOnly = true
+    ),
+    DISTIL_SMALL_EN(
+        modelName = "distil-small.en",
+        displayName = "Distil Small English (Fast decoder)",
+        fileSize = 321L * 1024 * 1024, // ~321 MB
+        fileName = "ggml-distil-small.en.bin",
+        downloadUrl = "https://hf.co/distil-whisper/distil-small.en/resolve/main/ggml-distil-small.en.bin",
+        encoderLayers = 12,
+        decoderLayers = 4,
+        englishOnly = true
+    ),
+    LARGE_V3_TURBO(
+        modelName = "large-v3-turbo-q5_0",
+        displayName = "Large v3 Turbo (Best accuracy)",
+        fileSize = 547L * 1024 * 1024, // ~547 MB, 5-bit quantized
+        fileName = "ggml-large-v3-turbo-q5_0.bin",
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-large-v3-turbo-q5_0.bin",
+        encoderLayers = 32,
+        decoderLayers = 4,
+        melBins = 128
+    ),
+    SMALL_Q8(
+        modelName = "small-q8_0",
+        displayName = "Small 8-bit (Accurate, half the memory)",
+        fileSize = 252L * 1024 * 1024, // ~252 MB
+        fileName = "ggml-small-q8_0.bin",
+        downloadUrl = "https://hf.co/ggerganov/whisper.cpp/resolve/main/ggml-small-q8_0.bin",
+        encoderLayers = 12,
+        decoderLayers = 12,
+        packSource = SMALL,
+        packType = "q8_0"
     );
 
     fun getFormattedSize(): String {
         val mb = fileSize / (1024.0 * 1024.0)
         return "%.0f MB".format(mb)
     }
+
+    /**
+     * English-only checkpoint of the same size (tiny -> tiny.en), or null if this is one already
+     */
+    fun englishOnlyVariant(): WhisperModel? {
+        if (englishOnly) return null
+        return values().find { it.englishOnly && it.modelName == "$modelName.en" }
+    }
 }
 
 /**
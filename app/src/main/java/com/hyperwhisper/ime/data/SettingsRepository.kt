@@ -5,6 +5,9 @@ import androidx.datastore.core.DataStore
 import androidx.datastore.preferences.core.Preferences
 import androidx.datastore.preferences.core.booleanPreferencesKey
 import androidx.datastore.preferences.core.edit
+import androidx.datastore.preferences.core.floatPreferencesKey
+import androidx.datastore.preferences.core.intPreferencesKey
+import androidx.datastore.preferences.core.longPreferencesKey
 import androidx.datastore.preferences.core.stringPreferencesKey
 import androidx.datastore.preferences.preferencesDataStore
 import com.google.gson.Gson
@@ -39,6 +42,16 @@ class SettingsRepository @Inject constructor(
         private val LOCAL_ENABLE_SECOND_STAGE_KEY = booleanPreferencesKey("local_enable_second_stage")
         private val LOCAL_SECOND_STAGE_PROVIDER_KEY = stringPreferencesKey("local_second_stage_provider")
         private val LOCAL_SECOND_STAGE_MODEL_KEY = stringPreferencesKey("local_second_stage_model")
+        private val LOCAL_SPEECH_SPEEDUP_KEY = floatPreferencesKey("local_speech_speedup")
+        private val LOCAL_LANGUAGE_CANDIDATES_KEY = stringPreferencesKey("local_language_candidates") // Comma-separated
+        private val LOCAL_CLOUD_ESCALATION_KEY = booleanPreferencesKey("local_cloud_escalation")
+        private val LOCAL_DRAFT_CASCADE_KEY = booleanPreferencesKey("local_draft_cascade")
+        private val LOCAL_DECODING_PROFILE_KEY = stringPreferencesKey("local_decoding_profile")
+        private val LOCAL_LATENCY_BUDGET_KEY = intPreferencesKey("local_latency_budget_ms")
+
+        // Recording Settings Keys
+        private val RECORDING_AUTO_STOP_KEY = booleanPreferencesKey("recording_auto_stop_on_silence")
+        private val RECORDING_SILENCE_HANGOVER_KEY = longPreferencesKey("recording_silence_hangover_ms")
 
         // Appearance settings keys
         private val APPEARANCE_COLOR_SCHEME_KEY = stringPreferencesKey("appearance_color_scheme")
@@ -108,12 +121,28 @@ class SettingsRepository @Inject constructor(
                 ApiProvider.valueOf(it)
             } ?: ApiProvider.OPENAI
             val secondStageModel = preferences[LOCAL_SECOND_STAGE_MODEL_KEY] ?: "gpt-4o-mini"
+            val speechSpeedup = preferences[LOCAL_SPEECH_SPEEDUP_KEY] ?: 1.0f
+            val languageCandidates = preferences[LOCAL_LANGUAGE_CANDIDATES_KEY]
+                ?.split(",")?.map { it.trim() }?.filter { it.isNotEmpty() }
+                ?: emptyList()
+            val cloudEscalation = preferences[LOCAL_CLOUD_ESCALATION_KEY] ?: false
+            val draftCascade = preferences[LOCAL_DRAFT_CASCADE_KEY] ?: true
+            val decodingProfile = preferences[LOCAL_DECODING_PROFILE_KEY]?.let {
+                DecodingProfile.valueOf(it)
+            } ?: DecodingProfile.BALANCED
+            val latencyBudgetMs = preferences[LOCAL_LATENCY_BUDGET_KEY] ?: 0
 
             LocalSettings(
                 selectedModel = selectedModel,
                 enableSecondStageProcessing = enableSecondStage,
                 secondStageProvider = secondStageProvider,
-                secondStageModel = secondStageModel
+                secondStageModel = secondStageModel,
+                speechSpeedup = speechSpeedup,
+                languageCandidates = languageCandidates,
+                cloudEscalation = cloudEscalation,
+                draftCascade = draftCascade,
+                decodingProfile = decodingProfile,
+                latencyBudgetMs = latencyBudgetMs
             )
         } catch (e: Exception) {
             LocalSettings()
@@ -154,6 +183,12 @@ class SettingsRepository @Inject constructor(
             preferences[LOCAL_ENABLE_SECOND_STAGE_KEY] = settings.localSettings.enableSecondStageProcessing
             preferences[LOCAL_SECOND_STAGE_PROVIDER_KEY] = settings.localSettings.secondStageProvider.name
             preferences[LOCAL_SECOND_STAGE_MODEL_KEY] = settings.localSettings.secondStageModel
+            preferences[LOCAL_SPEECH_SPEEDUP_KEY] = settings.localSettings.speechSpeedup
+            preferences[LOCAL_LANGUAGE_CANDIDATES_KEY] = settings.localSettings.languageCandidates.joinToString(",")
+            preferences[LOCAL_CLOUD_ESCALATION_KEY] = settings.localSettings.cloudEscalation
+            preferences[LOCAL_DRAFT_CASCADE_KEY] = settings.localSettings.draftCascade
+            preferences[LOCAL_DECODING_PROFILE_KEY] = settings.localSettings.decodingProfile.name
+            preferences[LOCAL_LATENCY_BUDGET_KEY] = settings.localSettings.latencyBudgetMs
         }
     }
 
@@ -166,6 +201,12 @@ class SettingsRepository @Inject constructor(
             preferences[LOCAL_ENABLE_SECOND_STAGE_KEY] = localSettings.enableSecondStageProcessing
             preferences[LOCAL_SECOND_STAGE_PROVIDER_KEY] = localSettings.secondStageProvider.name
             preferences[LOCAL_SECOND_STAGE_MODEL_KEY] = localSettings.secondStageModel
+            preferences[LOCAL_SPEECH_SPEEDUP_KEY] = localSettings.speechSpeedup
+            preferences[LOCAL_LANGUAGE_CANDIDATES_KEY] = localSettings.languageCandidates.joinToString(",")
+            preferences[LOCAL_CLOUD_ESCALATION_KEY] = localSettings.cloudEscalation
+            preferences[LOCAL_DRAFT_CASCADE_KEY] = localSettings.draftCascade
+            preferences[LOCAL_DECODING_PROFILE_KEY] = localSettings.decodingProfile.name
+            preferences[LOCAL_LATENCY_BUDGET_KEY] = localSettings.latencyBudgetMs
         }
     }
 
@@ -330,6 +371,24 @@ class SettingsRepository @Inject constructor(
         }
     }
 
+    /**
+     * Recording Settings Flow
+     */
+    val recordingSettings: Flow<RecordingSettings> = dataStore.data.map { preferences ->
+        val defaults = RecordingSettings()
+        defaults.copy(
+            autoStopOnSilence = preferences[RECORDING_AUTO_STOP_KEY] ?: defaults.autoStopOnSilence,
+            silenceHangoverMs = preferences[RECORDING_SILENCE_HANGOVER_KEY] ?: defaults.silenceHangoverMs
+        )
+    }
+
+    suspend fun saveRecordingSettings(settings: RecordingSettings) {
+        dataStore.edit { preferences ->
+            preferences[RECORDING_AUTO_STOP_KEY] = settings.autoStopOnSilence
+            preferences[RECORDING_SILENCE_HANGOVER_KEY] = settings.silenceHangoverMs
+        }
+    }
+
     /**
      * Recently Used Languages Flow
      */
@@ -391,9 +450,15 @@ class SettingsRepository @Inject constructor(
         }
     }
 
-    suspend fun addToHistory(text: String, audioFilePath: String? = null) {
-        if (text.isBlank()) return
+    /**
+     * Add a transcription at the top of the history
+     * @return ID of the new item, or null when text is blank and nothing was added
+     */
+    suspend fun addToHistory(text: String, audioFilePath: String? = null): String? {
+        if (text.isBlank()) return null
 
+        // Add new item at the beginning with audio file path
+        val newItem = TranscriptionHistoryItem(text = text, audioFilePath = audioFilePath)
         dataStore.edit { preferences ->
             val currentHistoryJson = preferences[TRANSCRIPTION_HISTORY_KEY]
             val currentHistory = if (currentHistoryJson.isNullOrEmpty()) {
@@ -407,8 +472,6 @@ class SettingsRepository @Inject constructor(
                 }
             }
 
-            // Add new item at the beginning with audio file path
-            val newItem = TranscriptionHistoryItem(text = text, audioFilePath = audioFilePath)
             val updatedHistory = listOf(newItem) + currentHistory
 
             // Keep only last MAX_HISTORY_ITEMS items
@@ -428,6 +491,30 @@ class SettingsRepository @Inject constructor(
 
             preferences[TRANSCRIPTION_HISTORY_KEY] = gson.toJson(trimmedHistory)
         }
+        return newItem.id
+    }
+
+    /**
+     * Replace the text of the history item with this ID, e.g. a draft transcript once its
+     * refinement is ready; does nothing when the item has since dropped out of the history
+     */
+    suspend fun replaceInHistory(id: String, newText: String) {
+        dataStore.edit { preferences ->
+            val currentHistoryJson = preferences[TRANSCRIPTION_HISTORY_KEY]
+            if (currentHistoryJson.isNullOrEmpty()) return@edit
+            val currentHistory = try {
+                val type = object : TypeToken<List<TranscriptionHistoryItem>>() {}.type
+                gson.fromJson<List<TranscriptionHistoryItem>>(currentHistoryJson, type) ?: return@edit
+            } catch (e: Exception) {
+                return@edit
+            }
+
+            val index = currentHistory.indexOfFirst { it.id == id }
+            if (index < 0) return@edit
+            val updatedHistory = currentHistory.toMutableList()
+            updatedHistory[index] = updatedHistory[index].copy(text = newText)
+            preferences[TRANSCRIPTION_HISTORY_KEY] = gson.toJson(updatedHistory)
+        }
     }
 
     suspend fun clearHistory() {
@@ -0,0 +1,110 @@
+package com.hyperwhisper.data
+
+import com.google.gson.Gson
+import com.hyperwhisper.localization.AppLanguage
+
+/**
+ * Spoken configuration commands as a GBNF grammar for constrained on-device decoding
+ *
+ * With the grammar active whisper can only produce phrases such as
+ * "Change input language to Spanish" or "Enable history", so commands need a
+ * handful of tokens and cannot be misheard as arbitrary text. parse() turns
+ * the constrained transcript into the same JSON the configuration prompt asks
+ * a chat model for, so VoiceCommandProcessor handles both paths.
+ */
+object VoiceCommandGrammar {
+
+    private val LANGUAGE_COMMAND = Regex("^(?:set|change|switch) (input|output|interface|keyboard) language to (.+)$")
+    private val MODE_COMMAND = Regex("^(?:(?:set|change|switch) (?:voice )?mode to (.+)|switch to (.+) mode)$")
+    private val THEME_COMMAND = Regex("^(?:(?:set|change|switch) theme to (.+)|switch to (.+) theme)$")
+    private val TOGGLE_COMMAND = Regex("^(enable|disable|turn on|turn off|exit) (history|techie mode|developer mode|configuration mode)$")
+
+    private val THEMES = listOf("dark", "light", "system")
+
+    /**
+     * Build the grammar (start rule "root") for the current voice modes
+     */
+    fun build(voiceModes: List<VoiceMode>): String {
+        val languages = SUPPORTED_LANGUAGES.filter { it.code.isNotEmpty() }.map { spokenName(it.name) }
+        val uiLanguages = AppLanguage.values().map { it.displayName }
+        val modes = voiceModes.map { it.name }.distinct()
+
+        return buildString {
+            appendLine("""root ::= " "? command "."?""")
+            appendLine("command ::= language-command | mode-command | theme-command | toggle-command")
+            appendLine("""verb ::= ${phrase("set")} | ${phrase("change")} | ${phrase("switch")}""")
+            appendLine("""language-command ::= verb " " (("input" | "output") " language to " language | ("interface" | "keyboard") " language to " ui-language)""")
+            appendLine("""mode-command ::= verb " " "voice "? "mode to " mode | ${phrase("switch")} " to " mode " mode"""")
+            appendLine("""theme-command ::= verb " theme to " theme | ${phrase("switch")} " to " theme " theme"""")
+            appendLine("""toggle-command ::= (${phrase("enable")} | ${phrase("disable")} | ${phrase("turn")} " " ("on" | "off")) " " ("history" | "techie mode" | "developer mode" | "configuration mode") | ${phrase("exit")} " configuration mode"""")
+            appendLine("language ::= ${alternatives(languages)}")
+            appendLine("ui-language ::= ${alternatives(uiLanguages)}")
+            appendLine("mode ::= ${alternatives(modes)}")
+            appendLine("theme ::= ${alternatives(THEMES)}")
+        }
+    }
+
+    /**
+     * Translate a transcript produced under the grammar into command JSON
+     * @return JSON for VoiceCommand.fromJson, or null if the text is not a command
+     */
+    fun parse(transcript: String): String? {
+        val text = transcript.trim().trimEnd('.', '!', '?').lowercase()
+
+        val command = LANGUAGE_COMMAND.find(text)?.let { match ->
+            val (target, name) = match.destructured
+            when (target) {
+                "input", "output" -> {
+                    val language = SUPPORTED_LANGUAGES.firstOrNull {
+                        it.code.isNotEmpty() && spokenName(it.name).equals(name, ignoreCase = true)
+                    }
+                    VoiceCommand(setting = "${target}_language", value = language?.code ?: name)
+                }
+                else -> {
+                    val language = AppLanguage.values().firstOrNull { it.displayName.equals(name, ignoreCase = true) }
+                    VoiceCommand(setting = "ui_language", value = language?.code ?: name)
+                }
+            }
+        } ?: MODE_COMMAND.find(text)?.let { match ->
+            VoiceCommand(setting = "voice_mode", value = match.groupValues[1].ifEmpty { match.groupValues[2] })
+        } ?: THEME_COMMAND.find(text)?.let { match ->
+            VoiceCommand(setting = "theme", value = match.groupValues[1].ifEmpty { match.groupValues[2] })
+        } ?: TOGGLE_COMMAND.find(text)?.let { match ->
+            val (action, target) = match.destructured
+            val setting = when (target) {
+                "history" -> "enable_history"
+                "configuration mode" -> "enable_configuration_mode"
+                else -> "enable_techie_mode"
+            }
+            val enabled = action == "enable" || action == "turn on"
+            VoiceCommand(setting = setting, value = enabled.toString())
+        } ?: return null
+
+        return Gson().toJson(command.copy(command = "change_setting"))
+    }
+
+    /**
+     * Name as it would be spoken: "Chinese (Mandarin)" -> "Chinese"
+     */
+    private fun spokenName(name: String): String = name.substringBefore(" (").trim()
+
+    private fun alternatives(names: List<String>): String =
+        names.filter { it.isNotBlank() }.joinToString(" | ") { phrase(it) }
+
+    /**
+     * GBNF for a phrase whose words may start upper- or lowercase, e.g. [Ff] "ix " [Gg] "rammar"
+     */
+    private fun phrase(text: String): String =
+        text.trim().split(Regex("\\s+")).joinToString(" \" \" ") { word ->
+            val first = word.first()
+            if (first.isLetter() && first.lowercaseChar() != first.uppercaseChar()) {
+                val rest = word.substring(1)
+                "[${first.uppercaseChar()}${first.lowercaseChar()}]" + if (rest.isEmpty()) "" else " ${literal(rest)}"
+            } else {
+                literal(word)
+            }
+        }
+
+    private fun literal(text: String): String =
+        "\"" + text.replace("\\", "\\\\").replace("\"", "\\\"") + "\""
+}
@@ -64,6 +64,10 @@ object NetworkModule {
         settingsRepository: SettingsRepository
     ): Interceptor {
         return Interceptor { chain ->
+            // Requests to another provider than the selected one carry that provider's key
+            if (chain.request().header("Authorization") != null) {
+                return@Interceptor chain.proceed(chain.request())
+            }
             val apiSettings = runBlocking { settingsRepository.apiSettings.first() }
             val request = chain.request().newBuilder()
                 .addHeader("Authorization", "Bearer ${apiSettings.getCurrentApiKey()}")
@@ -20,6 +20,20 @@ interface TranscriptionApiService {
         @Part("response_format") responseFormat: RequestBody? = null,
         @Part("language") language: RequestBody? = null
     ): Response<TranscriptionResponse>
+
+    /**
+     * Same request against another provider's endpoint and key than the selected one
+     */
+    @Multipart
+    @POST
+    suspend fun transcribeAt(
+        @Url url: String,
+        @Header("Authorization") authorization: String,
+        @Part file: MultipartBody.Part,
+        @Part("model") model: RequestBody,
+        @Part("response_format") responseFormat: RequestBody? = null,
+        @Part("language") language: RequestBody? = null
+    ): Response<TranscriptionResponse>
 }
 
 /**
@@ -2,6 +2,8 @@ package com.hyperwhisper.network
 
 import android.util.Log
 import com.hyperwhisper.data.*
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.emptyFlow
 import kotlinx.coroutines.flow.first
 import okhttp3.MediaType.Companion.toMediaTypeOrNull
 import okhttp3.MultipartBody
@@ -13,12 +15,39 @@ import java.io.File
  * Strategy Pattern for Audio Processing
  */
 interface AudioProcessingStrategy {
+    /**
+     * Transcribe or transform audioFile. reprocessing marks saved audio processed again:
+     * strategies that keep session state (prompt context, drafts) leave it out of the call
+     */
     suspend fun processAudio(
         audioFile: File,
         audioBase64: String,
         voiceMode: VoiceMode,
-        modelId: String
+        modelId: String,
+        reprocessing: Boolean = false
     ): ApiResult<String>
+
+    /**
+     * The field being dictated into: the text before its cursor (empty when unknown or private)
+     * and what kind of value it takes. Strategies that can condition on them do; others ignore them
+     */
+    fun setInputContext(textBeforeCursor: String, fieldType: InputFieldType) {}
+
+    /**
+     * Forget the dictation context gathered so far, e.g. because another field took focus
+     */
+    fun resetInputContext() {}
+
+    /**
+     * Final transcripts (possibly unchanged) for drafts processAudio returned earlier, from
+     * strategies that answer with a fast draft first and keep working in the background
+     */
+    val refinements: Flow<TextRefinement> get() = emptyFlow()
+
+    /**
+     * Drop a pending refinement, e.g. because a new recording started
+     */
+    fun cancelRefinement() {}
 }
 
 /**
@@ -38,7 +67,8 @@ class TranscriptionStrategy(
         audioFile: File,
         audioBase64: String,
         voiceMode: VoiceMode,
-        modelId: String
+        modelId: String,
+        reprocessing: Boolean
     ): ApiResult<String> {
         return try {
             Log.d(TAG, "========== TRANSCRIPTION REQUEST ==========")
@@ -168,6 +198,47 @@ class TranscriptionStrategy(
             ApiResult.Error(errorMessage, e)
         }
     }
+
+    /**
+     * Transcribe with provider's OpenAI-compatible endpoint and apiKey instead of the selected
+     * provider's, e.g. the second-stage provider of on-device processing
+     */
+    suspend fun transcribeWith(
+        audioFile: File,
+        provider: ApiProvider,
+        apiKey: String,
+        modelId: String
+    ): ApiResult<String> {
+        return try {
+            val apiSettings = settingsRepository.apiSettings.first()
+            val requestFile = audioFile.asRequestBody("audio/*".toMediaTypeOrNull())
+            val filePart = MultipartBody.Part.createFormData("file", audioFile.name, requestFile)
+            val languagePart = if (apiSettings.inputLanguage.isNotEmpty()) {
+                apiSettings.inputLanguage.toRequestBody("text/plain".toMediaTypeOrNull())
+            } else null
+
+            Log.d(TAG, "Transcribing with ${provider.displayName} ($modelId)")
+            val response = apiService.transcribeAt(
+                url = "${provider.defaultEndpoint}audio/transcriptions",
+                authorization = "Bearer $apiKey",
+                file = filePart,
+                model = modelId.toRequestBody("text/plain".toMediaTypeOrNull()),
+                responseFormat = "json".toRequestBody("text/plain".toMediaTypeOrNull()),
+                language = languagePart
+            )
+
+            if (response.isSuccessful) {
+                ApiResult.Success(response.body()?.text ?: "")
+            } else {
+                val errorBody = response.errorBody()?.string() ?: "No error details"
+                Log.e(TAG, "${provider.displayName} transcription failed: ${response.code()} - $errorBody")
+                ApiResult.Error("${provider.displayName}: ${response.code()} ${response.message()}")
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception during ${provider.displayName} transcription", e)
+            ApiResult.Error("${provider.displayName}: ${e.message ?: "Unknown error"}", e)
+        }
+    }
 }
 
 /**
@@ -200,7 +271,8 @@ class ChatCompletionStrategy(
         audioFile: File,
         audioBase64: String,
         voiceMode: VoiceMode,
-        modelId: String
+        modelId: String,
+        reprocessing: Boolean
     ): ApiResult<String> {
         return try {
             Log.d(TAG, "========== CHAT COMPLETION REQUEST ==========")
@@ -3,6 +3,18 @@ package com.hyperwhisper.network
 import android.util.Log
 import com.hyperwhisper.audio.AudioRecorderManager
 import com.hyperwhisper.data.*
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.filter
+import kotlinx.coroutines.flow.filterNotNull
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withTimeoutOrNull
 import java.io.File
 import javax.inject.Inject
 import javax.inject.Named
@@ -19,27 +31,112 @@ class VoiceRepository @Inject constructor(
 ) {
     companion object {
         private const val TAG = "VoiceRepository"
+
+        // Second-stage providers with an OpenAI-compatible transcription API, and the model
+        // that re-transcribes low-confidence on-device results there
+        private val ESCALATION_MODELS = mapOf(
+            ApiProvider.OPENAI to "whisper-1",
+            ApiProvider.GROQ to "whisper-large-v3"
+        )
+
+        // How long a refinement waits for its draft to be saved to history
+        private const val HISTORY_WAIT_MS = 5_000L
     }
 
+    // Cloud provider that low-confidence on-device results are re-transcribed with
+    private data class EscalationTarget(val provider: ApiProvider, val apiKey: String, val modelId: String)
+
+    // Copy of a draft's audio, kept until the refinement's confidence decides on escalation
+    private class PendingEscalation(val audioFile: File, val target: EscalationTarget)
+
+    // Kind of field being dictated into, from the IME
+    @Volatile
+    private var inputFieldType = InputFieldType.TEXT
+
     /**
      * Get recording duration flow
      */
     fun getRecordingDuration() = audioRecorderManager.recordingDuration
 
+    /**
+     * Emits when the recorder detects the end of the utterance (trailing silence)
+     */
+    fun getEndOfSpeech() = audioRecorderManager.endOfSpeech
+
+    /**
+     * Emits the AudioRecord error code when the microphone stops delivering audio mid-recording
+     */
+    fun getCaptureFailures() = audioRecorderManager.captureFailed
+
+    // Refinements are escalated and saved to history here, whether or not a UI is showing
+    private val repositoryScope = CoroutineScope(SupervisorJob() + Dispatchers.IO)
+
+    private val _pendingRefinement = MutableStateFlow<TextRefinement?>(null)
+
+    /**
+     * On-device transcript that replaces the draft processAudio returned earlier, already
+     * saved to history, until the UI has applied it to the field (see refinementApplied)
+     */
+    val pendingRefinement: StateFlow<TextRefinement?> = _pendingRefinement.asStateFlow()
+
+    // Text processAudio last returned while an on-device refinement of it was pending
+    @Volatile
+    private var committedDraft: String? = null
+
+    // History item the committed draft was saved as
+    private val draftHistoryId = MutableStateFlow<String?>(null)
+
+    @Volatile
+    private var pendingEscalation: PendingEscalation? = null
+
+    init {
+        if (isLocalFlavorEnabled) {
+            repositoryScope.launch {
+                // Only the text processAudio returned was committed; anything else can't be matched
+                localWhisperStrategy.refinements
+                    .filter { it.draft == committedDraft }
+                    .map { escalateRefinement(it) }
+                    .filter { it.refined != it.draft }
+                    .collect { refinement ->
+                        val historyId = withTimeoutOrNull(HISTORY_WAIT_MS) { draftHistoryId.filterNotNull().first() }
+                        historyId?.let { settingsRepository.replaceInHistory(it, refinement.refined) }
+                        _pendingRefinement.value = refinement
+                    }
+            }
+        }
+    }
+
+    /**
+     * The caller saved draft, a text processAudio returned with a refinement pending, as this
+     * history item; the refinement replaces its text there
+     */
+    fun draftSavedToHistory(draft: String, historyId: String) {
+        if (draft == committedDraft) draftHistoryId.value = historyId
+    }
+
+    /**
+     * The UI has applied (or given up on) refinement
+     */
+    fun refinementApplied(refinement: TextRefinement) {
+        _pendingRefinement.compareAndSet(refinement, null)
+    }
+
     /**
      * Process recorded audio based on voice mode and API provider
      * Automatically selects the appropriate strategy
+     * @param reprocessing Saved audio processed again: on-device transcription leaves the
+     *                     dictation context out, so the same audio gives the same text
      */
     suspend fun processAudio(
         audioFile: File,
         voiceMode: VoiceMode,
-        apiSettings: ApiSettings
+        apiSettings: ApiSettings,
+        reprocessing: Boolean = false
     ): ApiResult<String> {
         return try {
             Log.d(TAG, "Processing audio with mode: ${voiceMode.name}, provider: ${apiSettings.provider}")
 
-            // Calculate audio duration in seconds (approximate based on file size and format)
-            // For m4a at 128kbps: ~16KB per second
+            // Calculate audio duration in seconds from file size and format
             val audioDurationSeconds = calculateAudioDuration(audioFile)
             Log.d(TAG, "Audio duration: $audioDurationSeconds seconds")
 
@@ -53,7 +150,14 @@ class VoiceRepository @Inject constructor(
             // Check if we need two-step processing (transcription + post-processing)
             val needsTwoStepProcessing = needsTwoStepProcessing(voiceMode, apiSettings)
 
+            committedDraft = null
+            draftHistoryId.value = null
+            dropPendingEscalation()
             if (needsTwoStepProcessing) {
+                // The committed text is post-processed: a refinement of the raw transcript has
+                // nothing to replace
+                if (isLocalFlavorEnabled) localWhisperStrategy.cancelRefinement()
+
                 // Step 1: Transcribe audio
                 Log.d(TAG, "Using two-step processing: transcribe + post-process")
                 val transcriptionResult = transcriptionStrategy.processAudio(
@@ -90,12 +194,18 @@ class VoiceRepository @Inject constructor(
                 val strategyName = if (strategy is TranscriptionStrategy) "transcription" else "chat-completion"
                 val systemPrompt = buildSystemPrompt(voiceMode.systemPrompt, apiSettings.outputLanguage)
 
-                val result = strategy.processAudio(
+                val strategyResult = strategy.processAudio(
                     audioFile = audioFile,
                     audioBase64 = audioBase64,
                     voiceMode = voiceMode,
-                    modelId = apiSettings.modelId
+                    modelId = apiSettings.modelId,
+                    reprocessing = reprocessing
                 )
+                val result = if (apiSettings.provider == ApiProvider.LOCAL) {
+                    escalateIfLowConfidence(strategyResult, audioFile, voiceMode, apiSettings)
+                } else {
+                    strategyResult
+                }
 
                 // Add processing info for single-step
                 when (result) {
@@ -107,13 +217,16 @@ class VoiceRepository @Inject constructor(
                             postProcessingModel = null,
                             translationEnabled = apiSettings.outputLanguage.isNotEmpty(),
                             translationTarget = if (apiSettings.outputLanguage.isNotEmpty()) getLanguageName(apiSettings.outputLanguage) else null,
-                            originalTranscription = null,
+                            originalTranscription = result.processingInfo?.originalTranscription,
                             voiceModeName = voiceMode.name,
                             systemPrompt = systemPrompt,
                             audioDurationSeconds = audioDurationSeconds,
                             transcriptionTokens = result.processingInfo?.transcriptionTokens,
-                            postProcessingTokens = null
+                            postProcessingTokens = null,
+                            confidence = result.processingInfo?.confidence,
+                            refinementPending = result.processingInfo?.refinementPending ?: false
                         )
+                        if (processingInfo.refinementPending) committedDraft = result.data
 
                         // Record usage statistics
                         result.processingInfo?.transcriptionTokens?.let { tokens ->
@@ -155,6 +268,8 @@ class VoiceRepository @Inject constructor(
             if (!apiSettings.localSettings.enableSecondStageProcessing) {
                 return false // No cloud processing
             }
+            // Commands are decoded on-device under a grammar and need no interpreting model
+            if (voiceMode.id == "configuration") return false
             // Second-stage enabled: need two-step unless verbatim without translation
             return voiceMode.id != "verbatim" || needsTranslation
         }
@@ -353,11 +468,145 @@ class VoiceRepository @Inject constructor(
         }
     }
 
+    /**
+     * Tell on-device transcription what the focused field already contains, so the next
+     * utterances continue its vocabulary and style, and what kind of value it takes
+     */
+    fun setInputContext(textBeforeCursor: String, fieldType: InputFieldType) {
+        inputFieldType = fieldType
+        if (isLocalFlavorEnabled) {
+            localWhisperStrategy.setInputContext(textBeforeCursor, fieldType)
+        }
+    }
+
+    /**
+     * Drop the dictation context of the previous field, so its text doesn't prompt the next one
+     */
+    fun resetInputContext() {
+        if (isLocalFlavorEnabled) {
+            localWhisperStrategy.resetInputContext()
+        }
+    }
+
+    /**
+     * Hybrid policy for on-device results: confident local text is returned as is, without a
+     * network round-trip; low-confidence text is re-transcribed with the second-stage cloud
+     * provider, keeping the local text if that fails or no such provider is configured.
+     * Drafts are judged by their refinement instead (see escalateRefinement)
+     */
+    private suspend fun escalateIfLowConfidence(
+        localResult: ApiResult<String>,
+        audioFile: File,
+        voiceMode: VoiceMode,
+        apiSettings: ApiSettings
+    ): ApiResult<String> {
+        if (localResult !is ApiResult.Success) return localResult
+        // Commands and typed fields were decoded under a grammar the cloud model can't apply
+        if (voiceMode.id == "configuration" || inputFieldType != InputFieldType.TEXT) return localResult
+        val target = escalationTarget(apiSettings) ?: return localResult
+
+        if (localResult.processingInfo?.refinementPending == true) {
+            // The Tiny draft's confidence says little about the selected model's transcript
+            val copy = File(audioFile.parentFile, "escalation_${audioFile.name}")
+            try {
+                audioFile.copyTo(copy, overwrite = true)
+                pendingEscalation = PendingEscalation(copy, target)
+            } catch (e: Exception) {
+                Log.w(TAG, "Could not keep the draft's audio for cloud escalation", e)
+            }
+            return localResult
+        }
+
+        val confidence = localResult.processingInfo?.confidence ?: return localResult
+        if (!confidence.isLow()) return localResult
+
+        Log.d(TAG, "Low on-device confidence ($confidence), escalating to ${target.provider.displayName}")
+        val cloudText = transcribeForEscalation(audioFile, target) ?: return localResult
+        return ApiResult.Success(
+            cloudText,
+            localResult.processingInfo?.copy(
+                transcriptionModel = target.modelId,
+                originalTranscription = localResult.data
+            )
+        )
+    }
+
+    /**
+     * The refinement, or the cloud transcript of its audio when the refined text is still
+     * low-confidence and its draft was kept for escalation
+     */
+    private suspend fun escalateRefinement(refinement: TextRefinement): TextRefinement {
+        val pending = pendingEscalation ?: return refinement
+        pendingEscalation = null
+        try {
+            val confidence = refinement.confidence
+            if (confidence == null || !confidence.isLow()) return refinement
+
+            Log.d(TAG, "Low confidence in the refined text ($confidence), escalating to ${pending.target.provider.displayName}")
+            val cloudResult = transcribeForEscalation(pending.audioFile, pending.target) ?: return refinement
+            return refinement.copy(refined = cloudResult, confidence = null)
+        } finally {
+            pending.audioFile.delete()
+        }
+    }
+
+    /**
+     * Second-stage provider to escalate to, or null when escalation is off or that provider
+     * has no key or no OpenAI-compatible transcription API
+     */
+    private fun escalationTarget(apiSettings: ApiSettings): EscalationTarget? {
+        if (!apiSettings.localSettings.cloudEscalation) return null
+        val provider = apiSettings.localSettings.secondStageProvider
+        val modelId = ESCALATION_MODELS[provider] ?: return null
+        val apiKey = apiSettings.getSecondStageApiKey()
+        if (apiKey.isBlank()) return null
+        return EscalationTarget(provider, apiKey, modelId)
+    }
+
+    /**
+     * Cloud transcript of audioFile, or null when the request failed or came back empty
+     */
+    private suspend fun transcribeForEscalation(audioFile: File, target: EscalationTarget): String? {
+        return when (val result = transcriptionStrategy.transcribeWith(audioFile, target.provider, target.apiKey, target.modelId)) {
+            is ApiResult.Success -> result.data.takeIf { it.isNotBlank() }
+            is ApiResult.Error -> {
+                Log.w(TAG, "Cloud escalation failed, keeping on-device result: ${result.message}")
+                null
+            }
+            else -> null
+        }
+    }
+
+    /**
+     * Forget a draft's audio kept for escalation (its refinement no longer applies)
+     */
+    private fun dropPendingEscalation() {
+        pendingEscalation?.audioFile?.delete()
+        pendingEscalation = null
+    }
+
     /**
      * Start audio recording
+     * On-device transcription gets its log-mel computed while the user is still speaking
      */
     suspend fun startRecording(): Result<Unit> {
-        return audioRecorderManager.startRecording()
+        // The previous utterance's refinement would compete with this one for the model
+        if (isLocalFlavorEnabled) {
+            localWhisperStrategy.cancelRefinement()
+            dropPendingEscalation()
+            _pendingRefinement.value = null
+        }
+        val apiSettings = settingsRepository.apiSettings.first()
+        // Computed for the selected model's mel bins (128 for large-v3)
+        val melBins = if (isLocalFlavorEnabled && apiSettings.provider == ApiProvider.LOCAL) {
+            apiSettings.localSettings.selectedModel.melBins
+        } else {
+            null
+        }
+        return audioRecorderManager.startRecording(
+            settings = settingsRepository.recordingSettings.first(),
+            melBins = melBins
+        )
     }
 
     /**
@@ -383,14 +632,11 @@ class VoiceRepository @Inject constructor(
 
     /**
      * Calculate audio duration in seconds from file
-     * Approximation based on file size and bitrate
+     * Exact for PCM WAV recordings, approximated from bitrate otherwise
      */
     private fun calculateAudioDuration(audioFile: File): Double {
         return try {
-            // For m4a at 128kbps (16KB/s), approximate duration
-            val fileSizeBytes = audioFile.length()
-            val durationSeconds = fileSizeBytes / 16000.0 // ~16KB per second at 128kbps
-            durationSeconds
+            AudioRecorderManager.audioDurationSeconds(audioFile)
         } catch (e: Exception) {
             Log.e(TAG, "Error calculating audio duration", e)
             0.0
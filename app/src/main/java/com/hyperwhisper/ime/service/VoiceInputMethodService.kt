@@ -31,7 +31,9 @@ import androidx.savedstate.SavedStateRegistryOwner
 import androidx.savedstate.setViewTreeSavedStateRegistryOwner
 import com.hyperwhisper.audio.AudioRecorderManager
 import com.hyperwhisper.data.AppearanceSettings
+import com.hyperwhisper.data.InputFieldType
 import com.hyperwhisper.data.SettingsRepository
+import com.hyperwhisper.data.TextRefinement
 import com.hyperwhisper.network.ChatCompletionStrategy
 import com.hyperwhisper.network.TranscriptionStrategy
 import com.hyperwhisper.network.VoiceRepository
@@ -74,6 +76,8 @@ class VoiceInputMethodService : InputMethodService(),
     private var composeView: ComposeView? = null
     private var recomposer: Recomposer? = null
     private var currentEditorInfo: EditorInfo? = null
+    // Package and field ID the dictation context was gathered in
+    private var contextFieldKey: String? = null
 
     // Lifecycle for Compose integration
     private val lifecycleRegistry = LifecycleRegistry(this)
@@ -96,6 +100,9 @@ class VoiceInputMethodService : InputMethodService(),
     companion object {
         private const val TAG = "VoiceIME"
         private const val REQUEST_RECORD_AUDIO = 1001
+
+        // Characters before the cursor offered to on-device transcription as context
+        private const val FIELD_CONTEXT_CHARS = 1024
     }
 
     override fun onCreate() {
@@ -188,6 +195,9 @@ class VoiceInputMethodService : InputMethodService(),
                 onTextCommit = { text ->
                     commitText(text)
                 },
+                onTextRefine = { refinement ->
+                    replaceDraft(refinement)
+                },
                 onDelete = {
                     deleteSelectedText() // Prioritize deleting selected text
                 },
@@ -225,6 +235,29 @@ class VoiceInputMethodService : InputMethodService(),
         }
     }
 
+    /**
+     * Replace a committed draft transcript with its refinement
+     * Only when the text right before the cursor is still exactly the draft: anything the
+     * user typed, deleted or moved since keeps the draft where it is
+     */
+    private fun replaceDraft(refinement: TextRefinement) {
+        val ic = currentInputConnection ?: return
+        try {
+            ic.beginBatchEdit()
+            val before = ic.getTextBeforeCursor(refinement.draft.length, 0)?.toString()
+            if (before == refinement.draft) {
+                ic.deleteSurroundingText(refinement.draft.length, 0)
+                ic.commitText(refinement.refined, 1)
+                Log.d(TAG, "Replaced draft with refined text: ${refinement.refined}")
+            } else {
+                Log.d(TAG, "Field edited since the draft, keeping it")
+            }
+            ic.endBatchEdit()
+        } catch (e: Exception) {
+            Log.e(TAG, "Error replacing draft", e)
+        }
+    }
+
     /**
      * Delete one character before the cursor
      */
@@ -355,6 +388,22 @@ class VoiceInputMethodService : InputMethodService(),
         Log.d(TAG, "onStartInputView - restarting: $restarting")
         TraceLogger.lifecycle("IME", "onStartInputView", "restarting=$restarting")
         lifecycleRegistry.currentState = Lifecycle.State.STARTED
+
+        // Transcriptions from another app or field must not prompt this one
+        val fieldKey = "${info?.packageName}/${info?.fieldId}"
+        if (fieldKey != contextFieldKey) {
+            contextFieldKey = fieldKey
+            voiceRepository.resetInputContext()
+        }
+
+        // Existing field text primes on-device transcription; passwords never leave the field
+        val textBeforeCursor = if (isPasswordInput(info)) {
+            ""
+        } else {
+            currentInputConnection?.getTextBeforeCursor(FIELD_CONTEXT_CHARS, 0)?.toString() ?: ""
+        }
+        val fieldType = InputFieldType.fromInputType(info?.inputType ?: 0)
+        voiceRepository.setInputContext(textBeforeCursor, fieldType)
     }
 
     override fun onFinishInputView(finishingInput: Boolean) {
@@ -396,6 +445,23 @@ class VoiceInputMethodService : InputMethodService(),
         TraceLogger.trace("IME", "ViewModelStore cleared")
     }
 
+    /**
+     * Whether the field takes a password, whose text must not be read
+     */
+    private fun isPasswordInput(info: EditorInfo?): Boolean {
+        val inputType = info?.inputType ?: return false
+        val variation = inputType and android.text.InputType.TYPE_MASK_VARIATION
+        return when (inputType and android.text.InputType.TYPE_MASK_CLASS) {
+            android.text.InputType.TYPE_CLASS_TEXT ->
+                variation == android.text.InputType.TYPE_TEXT_VARIATION_PASSWORD ||
+                    variation == android.text.InputType.TYPE_TEXT_VARIATION_VISIBLE_PASSWORD ||
+                    variation == android.text.InputType.TYPE_TEXT_VARIATION_WEB_PASSWORD
+            android.text.InputType.TYPE_CLASS_NUMBER ->
+                variation == android.text.InputType.TYPE_NUMBER_VARIATION_PASSWORD
+            else -> false
+        }
+    }
+
     /**
      * Check if microphone permission is granted
      */
@@ -40,6 +40,7 @@ import com.hyperwhisper.data.VoiceMode
 import com.hyperwhisper.data.ApiSettings
 import com.hyperwhisper.data.ApiProvider
 import com.hyperwhisper.data.SUPPORTED_LANGUAGES
+import com.hyperwhisper.data.TextRefinement
 import com.hyperwhisper.localization.LocalStrings
 import com.hyperwhisper.ui.components.InputFieldInfo
 
@@ -48,6 +49,7 @@ fun KeyboardScreen(
     viewModel: KeyboardViewModel,
     editorInfo: EditorInfo? = null,
     onTextCommit: (String) -> Unit,
+    onTextRefine: (TextRefinement) -> Unit = {},
     onDelete: () -> Unit = {},
     onDeleteAll: () -> Unit = {},
     onSpace: () -> Unit = {},
@@ -110,6 +112,24 @@ fun KeyboardScreen(
         }
     }
 
+    // Swap committed drafts for the refined transcript (the IME checks the field is unedited)
+    val currentAppearanceSettings by rememberUpdatedState(appearanceSettings)
+    val currentOnTextRefine by rememberUpdatedState(onTextRefine)
+    val pendingRefinement by viewModel.pendingRefinement.collectAsState()
+    LaunchedEffect(pendingRefinement) {
+        pendingRefinement?.let { refinement ->
+            if (lastTranscribedText == refinement.draft) {
+                lastTranscribedText = refinement.refined
+            }
+            if (currentAppearanceSettings.autoCopyToClipboard) {
+                val clip = ClipData.newPlainText("Transcribed Text", refinement.refined)
+                clipboardManager.setPrimaryClip(clip)
+            }
+            currentOnTextRefine(refinement)
+            viewModel.refinementApplied(refinement)
+        }
+    }
+
     // Show processing info as Toast
     LaunchedEffect(processingInfo) {
         processingInfo?.let { info ->
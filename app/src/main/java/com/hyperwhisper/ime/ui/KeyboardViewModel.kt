@@ -43,6 +43,9 @@ class KeyboardViewModel @Inject constructor(
     private val _transcriptionProgress = MutableStateFlow<Float?>(null)
     val transcriptionProgress: StateFlow<Float?> = _transcriptionProgress.asStateFlow()
 
+    // On-device transcript replacing a draft that was already committed (history is updated)
+    val pendingRefinement: StateFlow<TextRefinement?> = voiceRepository.pendingRefinement
+
     // Pending configuration command for confirmation dialog
     private val _pendingCommandResult = MutableStateFlow<VoiceCommandResult?>(null)
     val pendingCommandResult: StateFlow<VoiceCommandResult?> = _pendingCommandResult.asStateFlow()
@@ -264,7 +267,10 @@ class KeyboardViewModel @Inject constructor(
                             _transcribedText.value = result.data
 
                             // Save to history with audio file path
-                            settingsRepository.addToHistory(result.data, savedAudioPath)
+                            val historyId = settingsRepository.addToHistory(result.data, savedAudioPath)
+                            if (historyId != null && result.processingInfo?.refinementPending == true) {
+                                voiceRepository.draftSavedToHistory(result.data, historyId)
+                            }
                         }
 
                         _processingInfo.value = result.processingInfo
@@ -376,6 +382,13 @@ class KeyboardViewModel @Inject constructor(
         }
     }
 
+    /**
+     * The keyboard has swapped the draft for refinement in the field, or found it edited
+     */
+    fun refinementApplied(refinement: TextRefinement) {
+        voiceRepository.refinementApplied(refinement)
+    }
+
     /**
      * Clear transcribed text
      */
@@ -487,7 +500,7 @@ class KeyboardViewModel @Inject constructor(
                 }
 
                 // Process audio through API
-                when (val result = voiceRepository.processAudio(audioFile, mode, settings)) {
+                when (val result = voiceRepository.processAudio(audioFile, mode, settings, reprocessing = true)) {
                     is ApiResult.Success -> {
                         Log.d(TAG, "Reprocessing successful: ${result.data}")
                         TraceLogger.trace("KeyboardViewModel", "Reprocessing successful, length: ${result.data.length} chars")
@@ -568,7 +581,7 @@ class KeyboardViewModel @Inject constructor(
                 }
 
                 // Process audio through API
-                when (val result = voiceRepository.processAudio(audioFile, newMode, newSettings)) {
+                when (val result = voiceRepository.processAudio(audioFile, newMode, newSettings, reprocessing = true)) {
                     is ApiResult.Success -> {
                         Log.d(TAG, "Reprocessing with new settings successful: ${result.data}")
                         TraceLogger.trace("KeyboardViewModel", "Reprocessing successful, length: ${result.data.length} chars")
@@ -640,6 +653,26 @@ class KeyboardViewModel @Inject constructor(
                 }
             }
         }
+
+        // Stop automatically once the speaker has finished (trailing silence)
+        viewModelScope.launch {
+            voiceRepository.getEndOfSpeech().collect {
+                if (recordingState.value == RecordingState.RECORDING) {
+                    Log.d(TAG, "End of speech detected, auto-stopping")
+                    stopRecording()
+                }
+            }
+        }
+
+        // The microphone went away mid-recording: transcribe what was captured so far
+        viewModelScope.launch {
+            voiceRepository.getCaptureFailures().collect { code ->
+                if (recordingState.value == RecordingState.RECORDING) {
+                    Log.w(TAG, "Audio capture failed ($code), stopping recording")
+                    stopRecording()
+                }
+            }
+        }
     }
 
     /**
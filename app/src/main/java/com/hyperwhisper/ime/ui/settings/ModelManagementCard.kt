@@ -375,6 +375,12 @@ private fun ModelItem(
                 WhisperModel.TINY -> "Fastest, lowest accuracy. ~32x realtime on modern devices."
                 WhisperModel.BASE -> "Balanced speed and accuracy. ~16x realtime."
                 WhisperModel.SMALL -> "Best accuracy, slower. ~6x realtime. For high-end devices."
+                WhisperModel.TINY_EN -> "English only. Faster and more accurate than Tiny for English dictation."
+                WhisperModel.BASE_EN -> "English only. Used instead of Base when the input language is English."
+                WhisperModel.SMALL_EN -> "English only. Used instead of Small when the input language is English."
+                WhisperModel.DISTIL_SMALL_EN -> "English only. Small's encoder with a 4-layer decoder: close to Small accuracy in a fraction of the decoding time."
+                WhisperModel.LARGE_V3_TURBO -> "Large v3 encoder with a 4-layer decoder, 5-bit. Best accuracy; high-end devices only."
+                WhisperModel.SMALL_Q8 -> "Small with 8-bit weights: near-identical accuracy in half the memory. Built on the device when Small is downloaded."
             }
             Text(
                 text = description,
@@ -55,11 +55,14 @@ import com.hyperwhisper.data.DarkModePreference
 import com.hyperwhisper.data.FontFamilyOption
 import com.hyperwhisper.data.LocalSettings
 import com.hyperwhisper.data.ModelDownloadState
+import com.hyperwhisper.data.RecordingSettings
 import com.hyperwhisper.data.UIScaleOption
 import com.hyperwhisper.data.VoiceMode
 import com.hyperwhisper.data.WhisperModel
 import com.hyperwhisper.data.SUPPORTED_LANGUAGES
 import com.hyperwhisper.localization.LocalStrings
+import kotlin.math.roundToInt
+import kotlin.math.roundToLong
 
 @OptIn(ExperimentalMaterial3Api::class)
 @Composable
@@ -71,6 +74,7 @@ fun SettingsScreen(
     val apiSettings by viewModel.apiSettings.collectAsState()
     val voiceModes by viewModel.voiceModes.collectAsState()
     val appearanceSettings by viewModel.appearanceSettings.collectAsState()
+    val recordingSettings by viewModel.recordingSettings.collectAsState()
     val modelStates by viewModel.modelStates.collectAsState()
 
     var provider by remember { mutableStateOf(apiSettings.provider) }
@@ -284,6 +288,16 @@ fun SettingsScreen(
                         modifier = Modifier.padding(bottom = 16.dp)
                     )
                 }
+
+                item {
+                    LocalTranscriptionCard(
+                        localSettings = localSettings,
+                        onLocalSettingsChanged = { newSettings ->
+                            localSettings = newSettings
+                        },
+                        modifier = Modifier.padding(bottom = 16.dp)
+                    )
+                }
             }
 
             // Cloud provider configuration
@@ -505,6 +519,27 @@ fun SettingsScreen(
                 }
             }
 
+            // Recording Section (end-of-speech detection runs in the native library)
+            if (isLocalFlavorEnabled) {
+                item {
+                    Divider(modifier = Modifier.padding(vertical = 8.dp))
+                }
+
+                item {
+                    SectionCard(
+                        title = "Recording",
+                        icon = Icons.Default.RecordVoiceOver
+                    ) {
+                        RecordingSection(
+                            recordingSettings = recordingSettings,
+                            onSettingsChange = { newSettings ->
+                                viewModel.saveRecordingSettings(newSettings)
+                            }
+                        )
+                    }
+                }
+            }
+
             item {
                 Divider(modifier = Modifier.padding(vertical = 8.dp))
             }
@@ -1817,6 +1852,75 @@ fun AppearanceSection(
     }
 }
 
+@Composable
+fun RecordingSection(
+    recordingSettings: RecordingSettings,
+    onSettingsChange: (RecordingSettings) -> Unit
+) {
+    var localSettings by remember { mutableStateOf(recordingSettings) }
+
+    // Update when settings change externally
+    LaunchedEffect(recordingSettings) {
+        localSettings = recordingSettings
+    }
+
+    Column(
+        modifier = Modifier.fillMaxWidth(),
+        verticalArrangement = Arrangement.spacedBy(16.dp)
+    ) {
+        // Auto-stop on silence toggle
+        Row(
+            modifier = Modifier.fillMaxWidth(),
+            horizontalArrangement = Arrangement.SpaceBetween,
+            verticalAlignment = Alignment.CenterVertically
+        ) {
+            Column(modifier = Modifier.weight(1f)) {
+                Text(
+                    text = "Auto-stop on Silence",
+                    style = MaterialTheme.typography.bodyLarge
+                )
+                Text(
+                    text = "Stop recording and transcribe once you stop speaking",
+                    style = MaterialTheme.typography.bodySmall,
+                    color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                )
+            }
+            Switch(
+                checked = localSettings.autoStopOnSilence,
+                onCheckedChange = { enabled ->
+                    val newSettings = localSettings.copy(autoStopOnSilence = enabled)
+                    localSettings = newSettings
+                    onSettingsChange(newSettings)
+                }
+            )
+        }
+
+        // Trailing silence that ends the utterance
+        if (localSettings.autoStopOnSilence) {
+            Column(modifier = Modifier.fillMaxWidth()) {
+                Text(
+                    text = "Silence Before Stopping: ${"%.2f".format(localSettings.silenceHangoverMs / 1000f)} s",
+                    style = MaterialTheme.typography.bodyLarge
+                )
+                Text(
+                    text = "Longer pauses suit slow dictation; shorter ones stop sooner",
+                    style = MaterialTheme.typography.bodySmall,
+                    color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                )
+                Slider(
+                    value = localSettings.silenceHangoverMs.toFloat(),
+                    onValueChange = { value ->
+                        localSettings = localSettings.copy(silenceHangoverMs = (value / 250f).roundToLong() * 250L)
+                    },
+                    onValueChangeFinished = { onSettingsChange(localSettings) },
+                    valueRange = 500f..3000f,
+                    steps = 9
+                )
+            }
+        }
+    }
+}
+
 @Composable
 fun ColorSchemeSelector(
     selectedScheme: ColorSchemeOption,
@@ -2440,6 +2544,35 @@ fun ProminentHybridProcessingCard(
                         modifier = Modifier.fillMaxWidth()
                     )
 
+                    // Low-confidence local results re-transcribed by the provider above
+                    Row(
+                        modifier = Modifier
+                            .fillMaxWidth()
+                            .padding(top = 8.dp),
+                        horizontalArrangement = Arrangement.SpaceBetween,
+                        verticalAlignment = Alignment.CenterVertically
+                    ) {
+                        Column(modifier = Modifier.weight(1f)) {
+                            Text(
+                                text = "Cloud Fallback",
+                                style = MaterialTheme.typography.bodyLarge
+                            )
+                            Text(
+                                text = "Re-transcribe uncertain local results with ${localSettings.secondStageProvider.displayName} (OpenAI and Groq only)",
+                                style = MaterialTheme.typography.bodySmall,
+                                color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                            )
+                        }
+                        Switch(
+                            checked = localSettings.cloudEscalation,
+                            onCheckedChange = { enabled ->
+                                onLocalSettingsChanged(
+                                    localSettings.copy(cloudEscalation = enabled)
+                                )
+                            }
+                        )
+                    }
+
                     // Cost warning
                     Row(
                         modifier = Modifier
@@ -2470,6 +2603,209 @@ fun ProminentHybridProcessingCard(
     }
 }
 
+/**
+ * Speed and accuracy trade-offs of on-device transcription
+ */
+@Composable
+fun LocalTranscriptionCard(
+    localSettings: LocalSettings,
+    onLocalSettingsChanged: (LocalSettings) -> Unit,
+    modifier: Modifier = Modifier
+) {
+    Card(
+        modifier = modifier.fillMaxWidth(),
+        colors = CardDefaults.cardColors(
+            containerColor = MaterialTheme.colorScheme.surfaceVariant
+        )
+    ) {
+        Column(
+            modifier = Modifier.padding(16.dp),
+            verticalArrangement = Arrangement.spacedBy(12.dp)
+        ) {
+            Text(
+                text = "On-Device Transcription",
+                style = MaterialTheme.typography.titleMedium,
+                fontWeight = FontWeight.Bold
+            )
+
+            // Time compression before whisper: fewer frames to encode
+            var speechSpeedup by remember(localSettings.speechSpeedup) { mutableStateOf(localSettings.speechSpeedup) }
+            Column(modifier = Modifier.fillMaxWidth()) {
+                Text(
+                    text = if (speechSpeedup > 1.0f) "Speed Up Speech: ${"%.1f".format(speechSpeedup)}×" else "Speed Up Speech: Off",
+                    style = MaterialTheme.typography.bodyLarge
+                )
+                Text(
+                    text = "Faster transcription of long recordings; fast talkers may lose accuracy",
+                    style = MaterialTheme.typography.bodySmall,
+                    color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                )
+                Slider(
+                    value = speechSpeedup,
+                    onValueChange = { value ->
+                        speechSpeedup = (value * 10).roundToInt() / 10f
+                    },
+                    onValueChangeFinished = {
+                        onLocalSettingsChanged(localSettings.copy(speechSpeedup = speechSpeedup))
+                    },
+                    valueRange = 1.0f..1.5f,
+                    steps = 4
+                )
+            }
+
+            // Per-utterance decoding deadline: cheaper decoding, then partial text past it
+            var latencyBudgetMs by remember(localSettings.latencyBudgetMs) { mutableStateOf(localSettings.latencyBudgetMs) }
+            Column(modifier = Modifier.fillMaxWidth()) {
+                Text(
+                    text = if (latencyBudgetMs > 0) "Time Limit: ${"%.1f".format(latencyBudgetMs / 1000f)} s" else "Time Limit: None",
+                    style = MaterialTheme.typography.bodyLarge
+                )
+                Text(
+                    text = "Past the limit, decoding switches to a faster strategy and then returns the text so far",
+                    style = MaterialTheme.typography.bodySmall,
+                    color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                )
+                Slider(
+                    value = latencyBudgetMs.toFloat(),
+                    onValueChange = { value ->
+                        latencyBudgetMs = (value / 500f).roundToInt() * 500
+                    },
+                    onValueChangeFinished = {
+                        onLocalSettingsChanged(localSettings.copy(latencyBudgetMs = latencyBudgetMs))
+                    },
+                    valueRange = 0f..5000f,
+                    steps = 9
+                )
+            }
+
+            // Instant Tiny draft of long dictations, replaced by the selected model's text
+            Row(
+                modifier = Modifier.fillMaxWidth(),
+                horizontalArrangement = Arrangement.SpaceBetween,
+                verticalAlignment = Alignment.CenterVertically
+            ) {
+                Column(modifier = Modifier.weight(1f)) {
+                    Text(
+                        text = "Quick Draft",
+                        style = MaterialTheme.typography.bodyLarge
+                    )
+                    Text(
+                        text = "Long dictations show a Tiny model draft at once, replaced when the selected model finishes (Tiny must be downloaded)",
+                        style = MaterialTheme.typography.bodySmall,
+                        color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                    )
+                }
+                Switch(
+                    checked = localSettings.draftCascade,
+                    onCheckedChange = { enabled ->
+                        onLocalSettingsChanged(localSettings.copy(draftCascade = enabled))
+                    }
+                )
+            }
+
+            // Languages auto-detect picks from, when the input language is Auto-detect
+            var showLanguageCandidates by remember { mutableStateOf(false) }
+            Row(
+                modifier = Modifier.fillMaxWidth(),
+                horizontalArrangement = Arrangement.SpaceBetween,
+                verticalAlignment = Alignment.CenterVertically
+            ) {
+                Column(modifier = Modifier.weight(1f)) {
+                    Text(
+                        text = "Auto-detect Languages",
+                        style = MaterialTheme.typography.bodyLarge
+                    )
+                    Text(
+                        text = if (localSettings.languageCandidates.isEmpty()) {
+                            "All languages"
+                        } else {
+                            localSettings.languageCandidates.joinToString(", ") { code ->
+                                SUPPORTED_LANGUAGES.find { it.code == code }?.name ?: code
+                            }
+                        },
+                        style = MaterialTheme.typography.bodySmall,
+                        color = MaterialTheme.colorScheme.onSurface.copy(alpha = 0.7f)
+                    )
+                }
+                TextButton(onClick = { showLanguageCandidates = true }) {
+                    Text("Choose")
+                }
+            }
+
+            if (showLanguageCandidates) {
+                LanguageCandidatesDialog(
+                    selected = localSettings.languageCandidates,
+                    onDismiss = { showLanguageCandidates = false },
+                    onConfirm = { codes ->
+                        onLocalSettingsChanged(localSettings.copy(languageCandidates = codes))
+                        showLanguageCandidates = false
+                    }
+                )
+            }
+        }
+    }
+}
+
+/**
+ * Pick the languages auto-detection chooses among; none selected means all of them
+ */
+@Composable
+fun LanguageCandidatesDialog(
+    selected: List<String>,
+    onDismiss: () -> Unit,
+    onConfirm: (List<String>) -> Unit
+) {
+    var codes by remember { mutableStateOf(selected.toSet()) }
+    val languages = SUPPORTED_LANGUAGES.filter { it.code.isNotEmpty() }
+
+    AlertDialog(
+        onDismissRequest = onDismiss,
+        title = { Text("Auto-detect Languages") },
+        text = {
+            Column(modifier = Modifier.fillMaxWidth()) {
+                Text(
+                    "Detection only considers the languages you speak, which makes it faster and avoids mistaking one for a similar one. Select none to consider all.",
+                    fontSize = 14.sp
+                )
+                Spacer(modifier = Modifier.height(8.dp))
+                LazyColumn(modifier = Modifier.heightIn(max = 360.dp)) {
+                    items(languages) { language ->
+                        Row(
+                            modifier = Modifier
+                                .fillMaxWidth()
+                                .clickable {
+                                    codes = if (language.code in codes) codes - language.code else codes + language.code
+                                },
+                            verticalAlignment = Alignment.CenterVertically
+                        ) {
+                            Checkbox(
+                                checked = language.code in codes,
+                                onCheckedChange = { checked ->
+                                    codes = if (checked) codes + language.code else codes - language.code
+                                }
+                            )
+                            Text(language.name)
+                        }
+                    }
+                }
+            }
+        },
+        confirmButton = {
+            TextButton(onClick = {
+                // Keep the list order stable regardless of the order of taps
+                onConfirm(languages.map { it.code }.filter { it in codes })
+            }) {
+                Text("Save")
+            }
+        },
+        dismissButton = {
+            TextButton(onClick = onDismiss) {
+                Text("Cancel")
+            }
+        }
+    )
+}
+
 /**
  * Prerequisites status card for LOCAL provider
  */
@@ -10,6 +10,7 @@ import com.hyperwhisper.data.LocalModelValidator
 import com.hyperwhisper.data.LocalSettings
 import com.hyperwhisper.data.ModelDownloadState
 import com.hyperwhisper.data.ModelRepository
+import com.hyperwhisper.data.RecordingSettings
 import com.hyperwhisper.data.SettingsRepository
 import com.hyperwhisper.data.VoiceMode
 import com.hyperwhisper.data.WhisperModel
@@ -57,6 +58,9 @@ class SettingsViewModel @Inject constructor(
     val appearanceSettings: StateFlow<AppearanceSettings> = settingsRepository.appearanceSettings
         .stateIn(viewModelScope, SharingStarted.Eagerly, AppearanceSettings())
 
+    val recordingSettings: StateFlow<RecordingSettings> = settingsRepository.recordingSettings
+        .stateIn(viewModelScope, SharingStarted.Eagerly, RecordingSettings())
+
     val modelStates: StateFlow<Map<WhisperModel, ModelDownloadState>> = modelRepository.modelStates
         .stateIn(viewModelScope, SharingStarted.Eagerly, emptyMap())
 
@@ -139,6 +143,17 @@ class SettingsViewModel @Inject constructor(
         }
     }
 
+    fun saveRecordingSettings(settings: RecordingSettings) {
+        viewModelScope.launch {
+            try {
+                settingsRepository.saveRecordingSettings(settings)
+                Log.d(TAG, "Recording settings saved: $settings")
+            } catch (e: Exception) {
+                Log.e(TAG, "Error saving recording settings", e)
+            }
+        }
+    }
+
     fun addVoiceMode(name: String, systemPrompt: String) {
         viewModelScope.launch {
             try {
@@ -0,0 +1,57 @@
+package com.hyperwhisper.native_whisper
+
+import android.util.Log
+import java.io.Closeable
+
+/**
+ * Streaming end-of-utterance detector backed by native code
+ * Fed with live PCM16 frames while recording; reports when speech has been
+ * followed by hangoverMs of continuous silence. One instance per recording.
+ */
+class EndpointDetector private constructor(private var handle: Long) : Closeable {
+
+    enum class State { WAITING, SPEECH, END_OF_UTTERANCE }
+
+    companion object {
+        private const val TAG = "EndpointDetector"
+
+        /**
+         * Create a detector, or null when the native library is not part of this build
+         */
+        fun create(sampleRate: Int, hangoverMs: Int, minSpeechMs: Int = 300): EndpointDetector? {
+            if (!WhisperContext.isLibraryAvailable()) return null
+
+            return try {
+                EndpointDetector(nativeCreate(sampleRate, hangoverMs, minSpeechMs))
+            } catch (e: Throwable) {
+                Log.e(TAG, "Error creating endpoint detector", e)
+                null
+            }
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(sampleRate: Int, hangoverMs: Int, minSpeechMs: Int): Long
+        @JvmStatic
+        private external fun nativeProcess(handle: Long, samples: ShortArray, count: Int): Int
+        @JvmStatic
+        private external fun nativeFree(handle: Long)
+    }
+
+    /**
+     * Feed the first count samples of the buffer
+     * @return Detector state after these samples
+     */
+    @Synchronized
+    fun process(samples: ShortArray, count: Int): State {
+        if (handle == 0L) return State.WAITING
+        return State.values()[nativeProcess(handle, samples, count)]
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+}
@@ -0,0 +1,69 @@
+package com.hyperwhisper.native_whisper
+
+import android.util.Log
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Log-mel front-end that runs while recording, backed by native code
+ * Fed with the same 16kHz PCM16 frames that are written to the WAV file; on
+ * finish the spectrogram is handed to the next transcription of that file so
+ * whisper skips its own mel computation. One instance per recording.
+ */
+class IncrementalMel private constructor(private var handle: Long) : Closeable {
+
+    companion object {
+        private const val TAG = "IncrementalMel"
+
+        /**
+         * Create a front-end, or null when the native library is not part of this build
+         * nMels must match the model (80, or 128 for large-v3); a mismatch falls back to whisper's mel
+         */
+        fun create(nMels: Int = 80): IncrementalMel? {
+            if (!WhisperContext.isLibraryAvailable()) return null
+
+            return try {
+                IncrementalMel(nativeCreate(nMels))
+            } catch (e: Throwable) {
+                Log.e(TAG, "Error creating incremental mel", e)
+                null
+            }
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(nMels: Int): Long
+        @JvmStatic
+        private external fun nativePush(handle: Long, samples: ShortArray, count: Int)
+        @JvmStatic
+        private external fun nativeFinish(handle: Long, audioPath: String)
+        @JvmStatic
+        private external fun nativeFree(handle: Long)
+    }
+
+    /**
+     * Feed the first count samples of the buffer
+     */
+    @Synchronized
+    fun push(samples: ShortArray, count: Int) {
+        if (handle == 0L) return
+        nativePush(handle, samples, count)
+    }
+
+    /**
+     * End of recording: the mel is attached to audioFile and this instance is consumed
+     */
+    @Synchronized
+    fun finish(audioFile: File) {
+        if (handle == 0L) return
+        nativeFinish(handle, audioFile.absolutePath)
+        handle = 0L
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+}
@@ -1,16 +1,44 @@
 package com.hyperwhisper.native_whisper
 
+import android.content.Context
 import android.util.Log
+import com.hyperwhisper.data.DecodingProfile
+import com.hyperwhisper.data.InputFieldType
+import com.hyperwhisper.data.ModelHeader
+import com.hyperwhisper.data.TranscriptionConfidence
+import dagger.hilt.android.qualifiers.ApplicationContext
 import java.io.File
 import javax.inject.Inject
 import javax.inject.Singleton
 
+/**
+ * Transcribed segment with timestamps on the original recording timeline
+ */
+data class WhisperSegment(
+    val startMs: Long,
+    val endMs: Long,
+    val text: String,
+    val avgLogprob: Float = 0f,
+    val noSpeechProb: Float = 0f,
+    val compressionRatio: Float = 0f
+)
+
+/**
+ * Detected language with its probability among the candidate languages
+ */
+data class LanguageProbability(
+    val language: String,
+    val probability: Float
+)
+
 /**
  * Kotlin wrapper for whisper.cpp JNI interface
  * Provides safe access to native whisper transcription functionality
  */
 @Singleton
-class WhisperContext @Inject constructor() {
+class WhisperContext @Inject constructor(
+    @ApplicationContext private val context: Context
+) {
 
     companion object {
         private const val TAG = "WhisperContext"
@@ -40,24 +68,76 @@ class WhisperContext @Inject constructor() {
          * Check if the native library was successfully loaded
          */
         fun isLibraryAvailable(): Boolean = libraryLoadSuccess
+
+        /**
+         * Hyperparameters from the GGML header of modelFile, read by the native loader's own
+         * parser; null when the file is not a GGML whisper model or the library is missing
+         */
+        fun getModelHparams(modelFile: File): ModelHeader? {
+            if (!libraryLoadSuccess) return null
+
+            return try {
+                nativeGetModelHparams(modelFile.absolutePath)?.let { ModelHeader.fromHparams(it) }
+            } catch (e: Throwable) {
+                Log.e(TAG, "Error reading model header", e)
+                null
+            }
+        }
+
+        @JvmStatic
+        private external fun nativeGetModelHparams(modelPath: String): IntArray?
     }
 
+    private var backendsInitialized = false
+
+    // Files behind the native contexts, so a different selection is noticed and loaded
+    @Volatile
+    private var loadedModelPath: String? = null
+    @Volatile
+    private var loadedDraftPath: String? = null
+
     // JNI methods
-    private external fun nativeLoadModel(modelPath: String): Boolean
+    private external fun nativeInitBackends(libDir: String)
+    private external fun nativeGetCpuVariant(): String
+    private external fun nativeLoadModel(modelPath: String, cacheDir: String): Boolean
     private external fun nativeTranscribe(
         audioPath: String,
         language: String,
-        translate: Boolean
+        translate: Boolean,
+        profile: Int,
+        budgetMs: Int,
+        sessionContext: Boolean
     ): String
+    private external fun nativeSetVadOptions(enabled: Boolean, paddingMs: Int, minSilenceMs: Int)
+    private external fun nativeSetTimeCompression(factor: Float)
+    private external fun nativeGetCacheStats(): String
+    private external fun nativeSetLanguageDetection(enabled: Boolean, candidates: Array<String>, threshold: Float)
+    private external fun nativeDetectLanguage(audioPath: String, candidates: Array<String>, probsOut: FloatArray): Array<String>
+    private external fun nativeSetGrammar(gbnf: String): Boolean
+    private external fun nativeSetFieldContext(text: String)
+    private external fun nativeSetInputFieldType(type: Int)
+    private external fun nativeResetPromptContext()
+    private external fun nativeGetLastSegmentTimes(): LongArray
+    private external fun nativeGetLastSegmentTexts(): Array<String>
+    private external fun nativeGetLastSegmentConfidence(): FloatArray
+    private external fun nativeGetLastConfidence(): FloatArray
     private external fun nativeUnloadModel()
     private external fun nativeIsModelLoaded(): Boolean
+    private external fun nativeLoadDraftModel(modelPath: String): Boolean
+    private external fun nativeUnloadDraftModel()
+    private external fun nativeIsDraftModelLoaded(): Boolean
+    private external fun nativePackModel(srcPath: String, dstPath: String, type: String): Boolean
+    private external fun nativeTranscribeDraft(audioPath: String, language: String, translate: Boolean, profile: Int): String
+    private external fun nativeAwaitRefinement(timeoutMs: Long): String?
+    private external fun nativeCancelRefinement()
 
     /**
      * Load a whisper model from file
      * @param modelFile The model file to load
+     * @param cacheDir Directory the result cache persists to (null to keep it in memory)
      * @return Result indicating success or failure
      */
-    fun loadModel(modelFile: File): Result<Unit> {
+    fun loadModel(modelFile: File, cacheDir: File? = null): Result<Unit> {
         if (!libraryLoadSuccess) {
             return Result.failure(Exception(
                 "Native library not available. LOCAL mode requires the 'local' build variant with native libraries. " +
@@ -70,8 +150,12 @@ class WhisperContext @Inject constructor() {
                 return Result.failure(Exception("Model file not found: ${modelFile.absolutePath}"))
             }
 
+            initBackends()
+
             Log.d(TAG, "Loading model: ${modelFile.absolutePath} (${modelFile.length()} bytes)")
-            val success = nativeLoadModel(modelFile.absolutePath)
+            val success = nativeLoadModel(modelFile.absolutePath, cacheDir?.absolutePath ?: "")
+            // The native side releases the previous model before loading, even on failure
+            loadedModelPath = if (success) modelFile.absolutePath else null
 
             if (success) {
                 Log.d(TAG, "Model loaded successfully")
@@ -85,17 +169,55 @@ class WhisperContext @Inject constructor() {
         }
     }
 
+    /**
+     * Load the ggml CPU kernel variant matching this device (dotprod, fp16, i8mm, ...)
+     * Variants are shipped as separate libggml-cpu-*.so files in the native library dir
+     */
+    @Synchronized
+    private fun initBackends() {
+        if (backendsInitialized) return
+
+        nativeInitBackends(context.applicationInfo.nativeLibraryDir ?: "")
+        backendsInitialized = true
+        Log.d(TAG, "CPU variant: ${nativeGetCpuVariant()}")
+    }
+
+    /**
+     * Get the CPU variant selected at runtime, e.g. "armv8.2+dotprod+fp16 (CPU: NEON DOTPROD ...)"
+     * @return Variant description, or empty string if the native library is unavailable
+     */
+    fun getCpuVariant(): String {
+        if (!libraryLoadSuccess) return ""
+
+        return try {
+            initBackends()
+            nativeGetCpuVariant()
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error getting CPU variant", e)
+            ""
+        }
+    }
+
     /**
      * Transcribe audio file using the loaded model
      * @param audioFile WAV audio file (16kHz, mono, 16-bit PCM)
      * @param language Language code (ISO-639-1) or empty for auto-detect
      * @param translate Whether to translate to English
+     * @param profile Decoding strategy
+     * @param budgetMs Latency budget for this call: past it decoding switches to FAST or returns
+     *                 the text finished by the deadline (0 = none)
+     * @param sessionContext Whether the dictation context prompts this call and the result extends
+     *                       it; false for saved audio processed again, whose text then depends on
+     *                       the audio alone
      * @return Result containing transcription text or error
      */
     fun transcribe(
         audioFile: File,
         language: String = "",
-        translate: Boolean = false
+        translate: Boolean = false,
+        profile: DecodingProfile = DecodingProfile.BALANCED,
+        budgetMs: Int = 0,
+        sessionContext: Boolean = true
     ): Result<String> {
         if (!libraryLoadSuccess) {
             return Result.failure(Exception(
@@ -112,8 +234,9 @@ class WhisperContext @Inject constructor() {
                 return Result.failure(Exception("Audio file not found: ${audioFile.absolutePath}"))
             }
 
-            Log.d(TAG, "Transcribing: ${audioFile.name} (${audioFile.length()} bytes), lang=$language, translate=$translate")
-            val result = nativeTranscribe(audioFile.absolutePath, language, translate)
+            Log.d(TAG, "Transcribing: ${audioFile.name} (${audioFile.length()} bytes), lang=$language, translate=$translate, " +
+                "profile=$profile, budget=${budgetMs}ms, sessionContext=$sessionContext")
+            val result = nativeTranscribe(audioFile.absolutePath, language, translate, profile.ordinal, budgetMs, sessionContext)
 
             if (result.isNotEmpty()) {
                 Log.d(TAG, "Transcription successful: ${result.length} chars")
@@ -127,6 +250,259 @@ class WhisperContext @Inject constructor() {
         }
     }
 
+    /**
+     * Transcribe with the draft model and start refining the same audio with the loaded model
+     * The draft uses the session's VAD and language settings but no prompt context; collect
+     * the refinement with awaitRefinement()
+     * @param profile Decoding strategy of the refinement (the draft is always FAST)
+     * @return Result containing the draft text or error (no refinement runs then)
+     */
+    fun transcribeDraft(
+        audioFile: File,
+        language: String = "",
+        translate: Boolean = false,
+        profile: DecodingProfile = DecodingProfile.BALANCED
+    ): Result<String> {
+        if (!libraryLoadSuccess) {
+            return Result.failure(Exception("Native library not available"))
+        }
+
+        return try {
+            if (!nativeIsDraftModelLoaded() || !nativeIsModelLoaded()) {
+                return Result.failure(Exception("Draft or main model not loaded"))
+            }
+
+            Log.d(TAG, "Draft transcription: ${audioFile.name}, lang=$language")
+            val result = nativeTranscribeDraft(audioFile.absolutePath, language, translate, profile.ordinal)
+            if (result.isNotEmpty()) {
+                Result.success(result)
+            } else {
+                Result.failure(Exception("Draft transcription returned empty result"))
+            }
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error in draft transcription", e)
+            Result.failure(Exception("Draft transcription failed: ${e.message}"))
+        }
+    }
+
+    /**
+     * Block until the refinement started by transcribeDraft() finishes
+     * Segments and confidence then describe the refined transcript
+     * @param timeoutMs Longest wait; a refinement still running afterwards is cancelled
+     * @return Refined text, or null if it failed, was cancelled or replaced by a newer draft
+     */
+    fun awaitRefinement(timeoutMs: Long): String? {
+        if (!libraryLoadSuccess) return null
+
+        return try {
+            nativeAwaitRefinement(timeoutMs)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error awaiting refinement", e)
+            null
+        }
+    }
+
+    /**
+     * Abort a running refinement; returns immediately
+     */
+    fun cancelRefinement() {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeCancelRefinement()
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error cancelling refinement", e)
+        }
+    }
+
+    /**
+     * Configure native voice activity detection for subsequent transcriptions
+     * Only detected speech (plus paddingMs on each side) is sent to whisper; pauses
+     * shorter than minSilenceMs are kept inside a single speech interval
+     */
+    fun setVadOptions(enabled: Boolean, paddingMs: Int = 200, minSilenceMs: Int = 400) {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeSetVadOptions(enabled, paddingMs, minSilenceMs)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting VAD options", e)
+        }
+    }
+
+    /**
+     * Speed speech up by factor (1.0-1.5, 1.0 = off) before transcription
+     * Shrinks encoder input on long recordings at some WER cost; see the regression harness
+     */
+    fun setTimeCompression(factor: Float) {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeSetTimeCompression(factor.coerceIn(1.0f, 1.5f))
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting time compression", e)
+        }
+    }
+
+    /**
+     * Configure language detection for transcriptions with language "auto"
+     * Detection only considers candidates (empty = all languages); the first result with at
+     * least threshold probability is reused for later utterances until the candidates,
+     * the threshold or the model change
+     */
+    fun setLanguageDetection(enabled: Boolean, candidates: List<String> = emptyList(), threshold: Float = 0.8f) {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeSetLanguageDetection(enabled, candidates.toTypedArray(), threshold)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting language detection", e)
+        }
+    }
+
+    /**
+     * Constrain subsequent transcriptions to a GBNF grammar (start rule "root")
+     * Each distinct grammar is compiled once and reused; pass an empty string for free text
+     * @return false if the grammar does not parse (decoding then stays unconstrained)
+     */
+    fun setGrammar(gbnf: String): Boolean {
+        if (!libraryLoadSuccess) return false
+
+        return try {
+            nativeSetGrammar(gbnf)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting grammar", e)
+            false
+        }
+    }
+
+    /**
+     * Set the text preceding the cursor in the focused field
+     * Its tail, followed by recent transcriptions, is given to whisper as prompt context;
+     * pass an empty string for password fields
+     */
+    fun setFieldContext(text: String) {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeSetFieldContext(text)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting field context", e)
+        }
+    }
+
+    /**
+     * Set the kind of field being dictated into
+     * Number, phone, email and URL fields are decoded under a grammar for their character set
+     * (compiled once per session) with impossible tokens suppressed, so the output needs no cleanup
+     */
+    fun setInputFieldType(type: InputFieldType) {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeSetInputFieldType(type.ordinal)
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error setting input field type", e)
+        }
+    }
+
+    /**
+     * Forget the field context and previous transcriptions used as prompt context
+     */
+    fun resetPromptContext() {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeResetPromptContext()
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error resetting prompt context", e)
+        }
+    }
+
+    /**
+     * Identify the spoken language of a WAV file without transcribing it
+     * @param candidates ISO-639-1 codes to choose from (empty = all languages)
+     * @param topK Number of languages to return
+     * @return Most likely languages first, or empty list on failure
+     */
+    fun detectLanguage(audioFile: File, candidates: List<String> = emptyList(), topK: Int = 3): List<LanguageProbability> {
+        if (!libraryLoadSuccess) return emptyList()
+
+        return try {
+            if (!nativeIsModelLoaded()) return emptyList()
+
+            val probs = FloatArray(topK.coerceAtLeast(1))
+            val codes = nativeDetectLanguage(audioFile.absolutePath, candidates.toTypedArray(), probs)
+            codes.mapIndexed { i, code -> LanguageProbability(code, probs[i]) }
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error detecting language", e)
+            emptyList()
+        }
+    }
+
+    /**
+     * Hit counters of the native result and encoder caches, for logs and diagnostics
+     * @return Summary such as "results 3/10 hits (30%), 12 stored; encoder 1/4 hits", or empty string
+     */
+    fun getCacheStats(): String {
+        if (!libraryLoadSuccess) return ""
+
+        return try {
+            nativeGetCacheStats()
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error getting cache stats", e)
+            ""
+        }
+    }
+
+    /**
+     * Get the segments of the last transcription, timestamps relative to the original recording
+     * @return Segments, or empty list if the last transcription failed or found no speech
+     */
+    fun getLastSegments(): List<WhisperSegment> {
+        if (!libraryLoadSuccess) return emptyList()
+
+        return try {
+            val times = nativeGetLastSegmentTimes()
+            val texts = nativeGetLastSegmentTexts()
+            val confidence = nativeGetLastSegmentConfidence()
+            texts.indices.map { i ->
+                WhisperSegment(
+                    startMs = times[i * 2],
+                    endMs = times[i * 2 + 1],
+                    text = texts[i],
+                    avgLogprob = confidence[i * 3],
+                    noSpeechProb = confidence[i * 3 + 1],
+                    compressionRatio = confidence[i * 3 + 2]
+                )
+            }
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error getting segments", e)
+            emptyList()
+        }
+    }
+
+    /**
+     * Confidence of the last successful transcription
+     * @return Metrics over the whole transcript, or null if it produced no text tokens
+     */
+    fun getLastConfidence(): TranscriptionConfidence? {
+        if (!libraryLoadSuccess) return null
+
+        return try {
+            val values = nativeGetLastConfidence()
+            if (values[3] <= 0f) return null
+            TranscriptionConfidence(
+                avgLogprob = values[0],
+                noSpeechProb = values[1],
+                compressionRatio = values[2]
+            )
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error getting confidence", e)
+            null
+        }
+    }
+
     /**
      * Unload the currently loaded model to free memory
      */
@@ -138,11 +514,104 @@ class WhisperContext @Inject constructor() {
                 Log.d(TAG, "Unloading model")
                 nativeUnloadModel()
             }
+            loadedModelPath = null
         } catch (e: Throwable) {
             Log.e(TAG, "Error unloading model", e)
         }
     }
 
+    /**
+     * Load a small model (Tiny) as draft model, resident next to the main model
+     * @return Result indicating success or failure
+     */
+    fun loadDraftModel(modelFile: File): Result<Unit> {
+        if (!libraryLoadSuccess) {
+            return Result.failure(Exception("Native library not available"))
+        }
+
+        return try {
+            if (!modelFile.exists()) {
+                return Result.failure(Exception("Model file not found: ${modelFile.absolutePath}"))
+            }
+
+            initBackends()
+
+            Log.d(TAG, "Loading draft model: ${modelFile.absolutePath}")
+            val success = nativeLoadDraftModel(modelFile.absolutePath)
+            loadedDraftPath = if (success) modelFile.absolutePath else null
+            if (success) {
+                Result.success(Unit)
+            } else {
+                Result.failure(Exception("Failed to load draft model"))
+            }
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error loading draft model", e)
+            Result.failure(Exception("Failed to load draft model: ${e.message}"))
+        }
+    }
+
+    /**
+     * Unload the draft model to free memory
+     */
+    fun unloadDraftModel() {
+        if (!libraryLoadSuccess) return
+
+        try {
+            nativeUnloadDraftModel()
+            loadedDraftPath = null
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error unloading draft model", e)
+        }
+    }
+
+    /**
+     * Check if a draft model is loaded
+     */
+    fun isDraftModelLoaded(): Boolean {
+        if (!libraryLoadSuccess) return false
+
+        return try {
+            nativeIsDraftModelLoaded()
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error checking if draft model is loaded", e)
+            false
+        }
+    }
+
+    /**
+     * Write a copy of srcFile with its weight matrices at tensor type (e.g. "q8_0") to dstFile
+     * Blocking and I/O heavy; run off the main thread.
+     */
+    fun packModel(srcFile: File, dstFile: File, type: String): Result<Unit> {
+        if (!libraryLoadSuccess) {
+            return Result.failure(Exception("Native library not available"))
+        }
+
+        return try {
+            Log.d(TAG, "Packing ${srcFile.absolutePath} -> ${dstFile.absolutePath} ($type)")
+            if (nativePackModel(srcFile.absolutePath, dstFile.absolutePath, type)) {
+                Result.success(Unit)
+            } else {
+                Result.failure(Exception("Failed to pack model"))
+            }
+        } catch (e: Throwable) {
+            Log.e(TAG, "Error packing model", e)
+            Result.failure(Exception("Failed to pack model: ${e.message}"))
+        }
+    }
+
+    /**
+     * Check if modelFile is the draft model currently loaded
+     */
+    fun isDraftModelLoaded(modelFile: File): Boolean =
+        loadedDraftPath == modelFile.absolutePath && isDraftModelLoaded()
+
+    /**
+     * Check if modelFile is the model currently loaded
+     */
+    fun isModelLoaded(modelFile: File): Boolean =
+        loadedModelPath == modelFile.absolutePath && isModelLoaded()
+
     /**
      * Check if a model is currently loaded
      * @return True if a model is loaded, false otherwise